@@ -1,11 +1,14 @@
 #include <iostream>
 #include <format>
 #include <filesystem>
+#include <cstring>
 #include "imgui.h"
 #include "gtc/type_ptr.hpp"
 #include "App.h"
 
 #include "ComponentReflection.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
 #include "Gizmos.h"
 #include "Graphics.h"
 #include "imgui_impl_sdl3.h"
@@ -14,6 +17,8 @@
 #include "imgui_internal.h"
 #include "Log.h"
 #include "MaterialPropertyInspector.h"
+#include "MeshLoader.h"
+#include "MeshResidency.h"
 #include "MetaInspector.h"
 #include "render/Context.h"
 #include "Scene.h"
@@ -57,15 +62,6 @@ namespace CPURDR
 		return false;
 	}
 
-	static inline uint32_t ConvertRGBAToARGB(uint32_t c)
-	{
-		const uint32_t r = (c >> 24) & 0xFF;
-		const uint32_t g = (c >> 16) & 0xFF;
-		const uint32_t b = (c >> 8) & 0xFF;
-		const uint32_t a = c & 0xFF;
-		return (a << 24) | (b << 16) | (g << 8) | r;
-	}
-
 	App::App():
 		m_Keys(SDL_GetKeyboardState(nullptr)),
 		m_ImGuiRenderer(nullptr),
@@ -98,6 +94,9 @@ namespace CPURDR
 			return;
 		}
 		m_RenderContext = m_RenderWindow->GetContext();
+		m_RenderContext->SetColorFormat(SCENE_TEXTURE_COLOR_FORMAT);
+		// Double buffered so the next frame renders while the last one is uploaded
+		m_RenderContext->SetFramebufferCount(2);
 		// m_ImGuiRenderer = m_RenderWindow->GetSDLRenderer();
 
 		m_RenderWindow->SetResizeCallback([this](int width, int height)
@@ -206,56 +205,98 @@ namespace CPURDR
 		bool show_another_window = false;
 		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
+		Profiler& profiler = Profiler::GetInstance();
+		profiler.SetThreadName("Main");
+
 		// Game Loop
 		while (!m_RenderWindow->ShouldClose())
 		{
-			uint64_t frameStart = SDL_GetPerformanceCounter();
-			double deltaTime = static_cast<double>(frameStart - prevFrameStart) / static_cast<double>(frequency);
-			prevFrameStart = frameStart;
+			// Closes the previous iteration here, since the loop body has early continues
+			profiler.EndFrame();
+			profiler.BeginFrame();
 
-			SDL_Event event{0};
-			while (SDL_PollEvent(&event))
+			// Everything below, up to KickRenderJob(), may touch the scene and the context
 			{
-				if (!m_MouseCaptured)
+				PROFILE_SCOPE("App::Update");
+				WaitForRenderJob();
+				if (m_DynamicResolutionEnabled)
 				{
-					ImGui_ImplSDL3_ProcessEvent(&event);
+					m_RenderWindow->SetRenderScale(m_DynamicResolution.Update(m_RenderJobMs));
 				}
-
-				switch (event.type)
+				for (const std::string& failed : MeshLoader::GetInstance().ProcessCompletedLoads())
 				{
-					case SDL_EVENT_QUIT:
-						m_RenderWindow->SetShouldClose(true);
-						break;
-
-					case SDL_EVENT_WINDOW_RESIZED:
-						m_RenderWindow->OnResize(event.window.data1, event.window.data2);
-						break;
-
-					case SDL_EVENT_MOUSE_MOTION:
-						if (m_MouseCaptured)
-						{
-							float xOffset = static_cast<float>(event.motion.xrel);
-							float yOffset = static_cast<float>(event.motion.yrel);
+					SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", ("Error loading model: " + failed).c_str(), nullptr);
+				}
+				MeshResidency::GetInstance().Update();
+			}
 
-							m_Camera->ProcessMouseMovement(xOffset, -yOffset);
-						}
-						break;
+			uint64_t frameStart = SDL_GetPerformanceCounter();
+			double deltaTime = static_cast<double>(frameStart - prevFrameStart) / static_cast<double>(frequency);
+			prevFrameStart = frameStart;
 
-					case SDL_EVENT_MOUSE_BUTTON_DOWN:
-						if (event.button.button == SDL_BUTTON_RIGHT)
-						{
-							m_MouseCaptured = true;
-							SDL_SetWindowRelativeMouseMode(m_RenderWindow->GetSDLWindow(), true);
-						}
-						break;
+			{
+				PROFILE_SCOPE("App::ProcessEvents");
+				SDL_Event event{0};
+				while (SDL_PollEvent(&event))
+				{
+					if (!m_MouseCaptured)
+					{
+						ImGui_ImplSDL3_ProcessEvent(&event);
+					}
 
-					case SDL_EVENT_MOUSE_BUTTON_UP:
-						if (event.button.button == SDL_BUTTON_RIGHT)
-						{
-							m_MouseCaptured = false;
-							SDL_SetWindowRelativeMouseMode(m_RenderWindow->GetSDLWindow(), false);
-						}
-						break;
+					switch (event.type)
+					{
+						case SDL_EVENT_QUIT:
+							m_RenderWindow->SetShouldClose(true);
+							break;
+
+						case SDL_EVENT_WINDOW_RESIZED:
+							m_RenderWindow->OnResize(event.window.data1, event.window.data2);
+							break;
+
+						case SDL_EVENT_DROP_FILE:
+							if (event.drop.data != nullptr)
+							{
+								const std::string path = event.drop.data;
+								const std::string name = std::filesystem::path(path).stem().string();
+								entt::entity entity = m_StreamDroppedMeshes? m_Scene->CreateStreamedMeshEntity(name, path) :
+									m_Scene->CreateMeshEntityAsync(name, path);
+								// Async loads report failures from ProcessCompletedLoads()
+								if (m_StreamDroppedMeshes && !m_Scene->GetRegistry().get<MeshFilter>(entity).asset)
+								{
+									SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", ("Error loading model: " + path).c_str(), nullptr);
+								}
+								m_Scene->GetRegistry().get<Transform>(entity).position = m_Camera->GetPosition() + m_Camera->GetFront() * 10.0f;
+								SelectEntity(entity);
+							}
+							break;
+
+						case SDL_EVENT_MOUSE_MOTION:
+							if (m_MouseCaptured)
+							{
+								float xOffset = static_cast<float>(event.motion.xrel);
+								float yOffset = static_cast<float>(event.motion.yrel);
+
+								m_Camera->ProcessMouseMovement(xOffset, -yOffset);
+							}
+							break;
+
+						case SDL_EVENT_MOUSE_BUTTON_DOWN:
+							if (event.button.button == SDL_BUTTON_RIGHT)
+							{
+								m_MouseCaptured = true;
+								SDL_SetWindowRelativeMouseMode(m_RenderWindow->GetSDLWindow(), true);
+							}
+							break;
+
+						case SDL_EVENT_MOUSE_BUTTON_UP:
+							if (event.button.button == SDL_BUTTON_RIGHT)
+							{
+								m_MouseCaptured = false;
+								SDL_SetWindowRelativeMouseMode(m_RenderWindow->GetSDLWindow(), false);
+							}
+							break;
+					}
 				}
 			}
 
@@ -275,119 +316,6 @@ namespace CPURDR
 
 			HandleEntityDeletion();
 
-			// ==================================
-			// Begin Rendering
-			// ==================================
-			ClearValue clearValue;
-			clearValue.color = 0x141414FF;
-			// Standard-Z
-			clearValue.depth = 1.0f;
-			// Reversed-Z
-			// clearValue.depth = 0.0f;
-			m_RenderContext->BeginRenderPass(clearValue);
-
-			Viewport viewport;
-			viewport.x = 0;
-			viewport.y = 0;
-			viewport.width = m_RenderContext->GetFramebufferWidth();
-			viewport.height = m_RenderContext->GetFramebufferHeight();
-			m_RenderContext->SetViewport(viewport);
-
-			m_RenderPipeline->Render(m_Scene->GetRegistry(), m_RenderContext.get(), *m_Camera);
-
-			Gizmos::DrawAxis(m_RenderContext.get(), *m_Camera, 2.0f, 0.03f);
-
-			m_RenderContext->EndRenderPass();
-
-			SDL_GPUCommandBuffer* command_buffer = SDL_AcquireGPUCommandBuffer(m_GPUDevice);
-			if (!command_buffer) continue;
-
-			const Texture2D_RGBA* contextColorBuffer = m_RenderContext->GetColorBuffer();
-			if (contextColorBuffer)
-			{
-			    const uint32_t w = (uint32_t)contextColorBuffer->GetWidth();
-			    const uint32_t h = (uint32_t)contextColorBuffer->GetHeight();
-			    const uint32_t bytes = w * h * sizeof(uint32_t);
-
-			    // Recreate GPU texture/buffer on first use or resize
-			    if (!m_SceneGPUTexture || w != m_SceneGPUWidth || h != m_SceneGPUHeight)
-			    {
-			        if (m_SceneGPUTexture)
-			        {
-			            SDL_ReleaseGPUTexture(m_GPUDevice, m_SceneGPUTexture);
-			            m_SceneGPUTexture = nullptr;
-			        }
-			        if (m_SceneUploadBuffer)
-			        {
-			            SDL_ReleaseGPUTransferBuffer(m_GPUDevice, m_SceneUploadBuffer);
-			            m_SceneUploadBuffer = nullptr;
-			        }
-
-			        SDL_GPUTextureCreateInfo tex_info = {};
-			        tex_info.type = SDL_GPU_TEXTURETYPE_2D;
-			        tex_info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-			        tex_info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-			        tex_info.width = w;
-			        tex_info.height = h;
-			        tex_info.layer_count_or_depth = 1;
-			        tex_info.num_levels = 1;
-			        tex_info.sample_count = SDL_GPU_SAMPLECOUNT_1;
-			        tex_info.props = 0;
-
-			        m_SceneGPUTexture = SDL_CreateGPUTexture(m_GPUDevice, &tex_info);
-
-			        SDL_GPUTransferBufferCreateInfo tb_info = {};
-			        tb_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-			        tb_info.size = bytes;
-			        tb_info.props = 0;
-
-			        m_SceneUploadBuffer = SDL_CreateGPUTransferBuffer(m_GPUDevice, &tb_info);
-
-			        m_SceneGPUWidth = w;
-			        m_SceneGPUHeight = h;
-			    }
-
-			    if (m_SceneGPUTexture && m_SceneUploadBuffer)
-			    {
-			        void* dst = SDL_MapGPUTransferBuffer(m_GPUDevice, m_SceneUploadBuffer, false);
-			        if (dst)
-			        {
-			        	const uint32_t* srcPixels = contextColorBuffer->GetData();
-			        	uint32_t* dstPixels = static_cast<uint32_t*>(dst);
-			        	const uint32_t pixelCount = w * h;
-
-			        	for (uint32_t i = 0; i < pixelCount; ++i)
-			        	{
-			        		dstPixels[i] = ConvertRGBAToARGB(srcPixels[i]);
-			        	}
-			            SDL_UnmapGPUTransferBuffer(m_GPUDevice, m_SceneUploadBuffer);
-
-			            SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(command_buffer);
-			            if (copy_pass)
-			            {
-			                SDL_GPUTextureTransferInfo src = {};
-			                src.transfer_buffer = m_SceneUploadBuffer;
-			                src.offset = 0;
-			                src.pixels_per_row = w;
-			                src.rows_per_layer = h;
-
-			                SDL_GPUTextureRegion dst_region = {};
-			                dst_region.texture = m_SceneGPUTexture;
-			                dst_region.mip_level = 0;
-			                dst_region.layer = 0;
-			                dst_region.x = 0;
-			                dst_region.y = 0;
-			                dst_region.z = 0;
-			                dst_region.w = w;
-			                dst_region.h = h;
-			                dst_region.d = 1;
-
-			                SDL_UploadToGPUTexture(copy_pass, &src, &dst_region, false);
-			                SDL_EndGPUCopyPass(copy_pass);
-			            }
-			        }
-			    }
-			}
 			// if (m_DisplayTexture)
 			// {
 			// 	SDL_DestroyTexture(m_DisplayTexture);
@@ -527,6 +455,12 @@ namespace CPURDR
 					ImGui::EndMenu();
 				}
 
+				if (size_t pendingLoads = MeshLoader::GetInstance().GetPendingLoadCount())
+				{
+					ImGui::Separator();
+					ImGui::TextDisabled("Importing %zu model(s)...", pendingLoads);
+				}
+
 				ImGui::EndMenuBar();
 			}
 
@@ -578,9 +512,9 @@ namespace CPURDR
 				for (auto entity: view)
 				{
 					const MeshFilter& meshFilter = view.get<MeshFilter>(entity);
-					for (const auto& mesh: meshFilter.meshes)
+					for (const auto& mesh: meshFilter.GetMeshes())
 					{
-						totalVertices += mesh.vertices.size();
+						totalVertices += mesh.GetVertexCount();
 					}
 				}
 
@@ -594,9 +528,193 @@ namespace CPURDR
 					m_RenderContext->GetFramebufferHeight());
 				ImGui::Text(" In Render Pass: %s", m_RenderContext->IsInRenderPass()? "Yes" : "No");
 
+				int framebufferCount = m_RenderContext->GetFramebufferCount();
+				if (ImGui::SliderInt(" Framebuffers", &framebufferCount, 1, Context::MAX_FRAMEBUFFER_COUNT))
+				{
+					m_RenderContext->SetFramebufferCount(framebufferCount);
+				}
+
+				// The scene panel scales the framebuffer back up with the GPU's bilinear sampler
+				float renderScale = m_RenderWindow->GetRenderScale();
+				ImGui::BeginDisabled(m_DynamicResolutionEnabled);
+				if (ImGui::SliderFloat(" Render Scale", &renderScale, Window::MIN_RENDER_SCALE, Window::MAX_RENDER_SCALE, "%.2f"))
+				{
+					m_RenderWindow->SetRenderScale(renderScale);
+				}
+				ImGui::EndDisabled();
+
+				if (ImGui::Checkbox(" Dynamic Resolution", &m_DynamicResolutionEnabled) && m_DynamicResolutionEnabled)
+				{
+					m_DynamicResolution.Reset(m_RenderWindow->GetRenderScale());
+				}
+				if (m_DynamicResolutionEnabled)
+				{
+					DynamicResolutionSettings settings = m_DynamicResolution.GetSettings();
+					bool changed = ImGui::SliderFloat(" Target ms", &settings.targetFrameMs, 4.0f, 50.0f, "%.1f");
+					changed |= ImGui::SliderFloat(" Min Scale", &settings.minScale, Window::MIN_RENDER_SCALE, 1.0f, "%.2f");
+					if (changed)
+					{
+						m_DynamicResolution.SetSettings(settings);
+					}
+					ImGui::TextDisabled(" raster %.2f ms at %.2f", m_DynamicResolution.GetSmoothedMs(), m_DynamicResolution.GetScale());
+				}
+
 				const Viewport& vp = m_RenderContext->GetViewport();
 				ImGui::Text(" Viewport: (%d, %d) %dx%d", vp.x, vp.y, vp.width, vp.height);
 
+				ImGui::Text(" Color Format: %s", GetColorFormatName(m_RenderContext->GetColorFormat()));
+				const uint32_t scenePixels = m_SceneGPUWidth * m_SceneGPUHeight;
+				ImGui::Text(" Uploaded: %.1f%%", scenePixels > 0? 100.0 * m_SceneUploadedPixels / scenePixels : 0.0);
+
+				const DepthFormat currentDepthFormat = m_RenderContext->GetDepthFormat();
+				if (ImGui::BeginCombo(" Depth Format", GetDepthFormatName(currentDepthFormat)))
+				{
+					for (DepthFormat format : {DepthFormat::D32_Float, DepthFormat::D24_UNorm_S8_UInt, DepthFormat::D16_UNorm})
+					{
+						if (ImGui::Selectable(GetDepthFormatName(format), format == currentDepthFormat))
+						{
+							m_RenderContext->SetDepthFormat(format);
+						}
+					}
+					ImGui::EndCombo();
+				}
+
+				const char* cullModeNames[] = {"None", "Back", "Front"};
+				int cullMode = (int)m_RenderContext->GetCullMode();
+				if (ImGui::Combo(" Cull Mode", &cullMode, cullModeNames, IM_ARRAYSIZE(cullModeNames)))
+				{
+					m_RenderContext->SetCullMode((CullMode)cullMode);
+				}
+
+				const DebugView currentDebugView = m_RenderContext->GetDebugView();
+				if (ImGui::BeginCombo(" Debug View", GetDebugViewName(currentDebugView)))
+				{
+					for (DebugView debugView : {DebugView::None, DebugView::Overdraw, DebugView::ShadingCost})
+					{
+						if (ImGui::Selectable(GetDebugViewName(debugView), debugView == currentDebugView))
+						{
+							m_RenderContext->SetDebugView(debugView);
+						}
+					}
+					ImGui::EndCombo();
+				}
+				if (currentDebugView == DebugView::Overdraw)
+				{
+					ImGui::TextDisabled(" blue 1 fragment, red %u, white more", m_RenderContext->GetDebugViewRange());
+				}
+				else if (currentDebugView == DebugView::ShadingCost)
+				{
+					ImGui::TextDisabled(" red %u %s per pixel (99th percentile), white more",
+						m_RenderContext->GetDebugViewRange(), GetCycleCounterUnit());
+				}
+
+				const TemporalMode currentTemporalMode = m_RenderContext->GetTemporalMode();
+				if (ImGui::BeginCombo(" Temporal", GetTemporalModeName(currentTemporalMode)))
+				{
+					for (TemporalMode mode : {TemporalMode::Off, TemporalMode::Checkerboard})
+					{
+						if (ImGui::Selectable(GetTemporalModeName(mode), mode == currentTemporalMode))
+						{
+							m_RenderContext->SetTemporalMode(mode);
+						}
+					}
+					ImGui::EndCombo();
+				}
+				if (currentTemporalMode != TemporalMode::Off)
+				{
+					const TemporalResolveResult& resolve = m_RenderContext->GetTemporalResolveResult();
+					const uint64_t resolved = resolve.reprojected + resolve.rejected;
+					ImGui::TextDisabled(" reprojected %.1f%%, rejected %.1f%%",
+						resolved > 0? 100.0 * resolve.reprojected / resolved : 0.0,
+						resolved > 0? 100.0 * resolve.rejected / resolved : 0.0);
+				}
+
+				// Depth test and projection have to agree, so toggle them together
+				bool reversedZ = m_RenderContext->IsReversedZ();
+				if (ImGui::Checkbox(" Reversed-Z", &reversedZ))
+				{
+					m_RenderContext->SetDepthFunction(reversedZ? DepthFunction::Greater : DepthFunction::Less);
+					m_Camera->SetReversedZ(reversedZ);
+				}
+
+				bool meshletCulling = m_RenderPipeline->IsMeshletCullingEnabled();
+				if (ImGui::Checkbox(" Meshlet Culling", &meshletCulling))
+				{
+					m_RenderPipeline->SetMeshletCulling(meshletCulling);
+				}
+				if (meshletCulling)
+				{
+					bool occlusionCulling = m_RenderPipeline->IsOcclusionCullingEnabled();
+					if (ImGui::Checkbox(" Hi-Z Occlusion Culling", &occlusionCulling))
+					{
+						m_RenderPipeline->SetOcclusionCulling(occlusionCulling);
+					}
+				}
+
+				bool instancing = m_RenderPipeline->IsInstancingEnabled();
+				if (ImGui::Checkbox(" Instancing", &instancing))
+				{
+					m_RenderPipeline->SetInstancing(instancing);
+				}
+
+				float lodErrorThreshold = m_RenderPipeline->GetLodErrorThreshold();
+				if (ImGui::SliderFloat(" LOD Error (px)", &lodErrorThreshold, 0.0f, 8.0f, "%.1f"))
+				{
+					m_RenderPipeline->SetLodErrorThreshold(lodErrorThreshold);
+				}
+
+				MeshResidency& residency = MeshResidency::GetInstance();
+				ImGui::Checkbox(" Stream Dropped Meshes", &m_StreamDroppedMeshes);
+				int meshBudgetMB = (int)(residency.GetBudget() >> 20);
+				if (ImGui::SliderInt(" Mesh Budget (MB)", &meshBudgetMB, 16, 4096))
+				{
+					residency.SetBudget((uint64_t)meshBudgetMB << 20);
+				}
+				const MeshResidencyStatistics& streaming = residency.GetStatistics();
+				if (streaming.streams > 0)
+				{
+					ImGui::TextDisabled(" %zu streams, %zu levels, %llu/%llu MB, %zu reads pending", streaming.streams,
+						streaming.residentLevels, (unsigned long long)(streaming.residentBytes >> 20),
+						(unsigned long long)(residency.GetBudget() >> 20), streaming.pendingReads);
+				}
+
+				// Written by the render job started below, replay with cpurenderer_replay
+				if (ImGui::Button(" Capture Frame"))
+				{
+					m_RenderPipeline->RequestCapture(std::format("frame_capture_{:03}.cpfc", m_FrameCaptureCount++));
+				}
+
+				if (ImGui::CollapsingHeader("Pipeline Statistics"))
+				{
+					const PipelineStatistics& statistics = m_RenderContext->GetPipelineStatistics();
+					const uint64_t framebufferPixels =
+						(uint64_t)m_RenderContext->GetFramebufferWidth() * m_RenderContext->GetFramebufferHeight();
+
+					ImGui::Text(" Overdraw: %.2fx", statistics.GetOverdraw(framebufferPixels));
+					ImGui::Text(" Cull Efficiency: %.1f%%", 100.0 * statistics.GetCullEfficiency());
+					ImGui::Separator();
+					ImGui::Text(" Draws: %llu (%llu instances)", (unsigned long long)statistics.draws,
+						(unsigned long long)statistics.instances);
+					ImGui::Text(" Meshlets Drawn: %llu", (unsigned long long)statistics.meshletsDrawn);
+					ImGui::Text(" Meshlets Frustum Culled: %llu", (unsigned long long)statistics.meshletsFrustumCulled);
+					ImGui::Text(" Meshlets Backface Culled: %llu", (unsigned long long)statistics.meshletsBackfaceCulled);
+					ImGui::Text(" Meshlets Occlusion Culled: %llu", (unsigned long long)statistics.meshletsOcclusionCulled);
+					ImGui::Separator();
+					ImGui::Text(" Vertices Shaded: %llu", (unsigned long long)statistics.verticesShaded);
+					ImGui::Text(" Vertex Cache Hits: %llu (ACMR %.2f)", (unsigned long long)statistics.vertexCacheHits, statistics.GetACMR());
+					ImGui::Text(" Triangles Submitted: %llu", (unsigned long long)statistics.trianglesSubmitted);
+					ImGui::Text(" Backface Culled: %llu", (unsigned long long)statistics.backfaceCulled);
+					ImGui::Text(" Frustum Rejected: %llu", (unsigned long long)statistics.frustumRejected);
+					ImGui::Text(" Near Clipped: %llu", (unsigned long long)statistics.nearClipped);
+					ImGui::Text(" Zero Area Rejected: %llu", (unsigned long long)statistics.zeroAreaRejected);
+					ImGui::Text(" Triangles Rasterized: %llu", (unsigned long long)statistics.trianglesRasterized);
+					ImGui::Separator();
+					ImGui::Text(" Pixels Covered: %llu", (unsigned long long)statistics.pixelsCovered);
+					ImGui::Text(" Depth Failed: %llu", (unsigned long long)statistics.depthFailed);
+					ImGui::Text(" Fragments Shaded: %llu", (unsigned long long)statistics.fragmentsShaded);
+					ImGui::Text(" Pixels Written: %llu", (unsigned long long)statistics.pixelsWritten);
+				}
+
 				ImGui::End();
 			}
 
@@ -604,9 +722,24 @@ namespace CPURDR
 
 			RenderInspector();
 
+			RenderProfiler();
+
 			if (show_demo_window)
 				ImGui::ShowDemoWindow(&show_demo_window);
 
+			// ==================================
+			// Begin Rendering
+			// ==================================
+			// Rasterize this frame on a worker while the previous one is uploaded and submitted below.
+			// The scene must not be modified until WaitForRenderJob()
+			KickRenderJob();
+			PROFILE_SCOPE("App::SubmitFrame");
+
+			SDL_GPUCommandBuffer* command_buffer = SDL_AcquireGPUCommandBuffer(m_GPUDevice);
+			if (!command_buffer) continue;
+
+			const bool uploaded = UploadSceneTexture(command_buffer);
+
 			// Rendering
 			ImGui::Render();
 			ImDrawData* draw_data = ImGui::GetDrawData();
@@ -622,6 +755,8 @@ namespace CPURDR
 			{
 				PLOG_ERROR << "SDL_WaitAndAcquireGPUSwapchainTexture failed: " << SDL_GetError();
 				SDL_CancelGPUCommandBuffer(command_buffer);
+				// The scene upload recorded in it is dropped too
+				m_SceneTextureStale |= uploaded;
 				continue;
 			}
 
@@ -647,7 +782,19 @@ namespace CPURDR
 				}
 			}
 
-			if (!SDL_SubmitGPUCommandBuffer(command_buffer))
+			if (uploaded)
+			{
+				// The fence tells when this transfer buffer can be written again
+				SceneUploadSlot& slot = m_SceneUploadSlots[m_SceneUploadIndex];
+				slot.fence = SDL_SubmitGPUCommandBufferAndAcquireFence(command_buffer);
+				if (!slot.fence)
+				{
+					PLOG_ERROR << "SDL_SubmitGPUCommandBufferAndAcquireFence failed: " << SDL_GetError();
+					m_SceneTextureStale = true;
+				}
+				m_SceneUploadIndex = (m_SceneUploadIndex + 1) % SCENE_UPLOADS_IN_FLIGHT;
+			}
+			else if (!SDL_SubmitGPUCommandBuffer(command_buffer))
 			{
 				PLOG_ERROR << "SDL_SubmitGPUCommandBuffer failed: " << SDL_GetError();
 			}
@@ -1117,9 +1264,13 @@ namespace CPURDR
 		ImGuiID dockCenter = 0, dockRight = 0;
 		ImGui::DockBuilderSplitNode(dockCenterRight, ImGuiDir_Right, 0.25f, &dockRight, &dockCenter);
 
+		ImGuiID dockBottom = 0;
+		ImGui::DockBuilderSplitNode(dockCenter, ImGuiDir_Down, 0.3f, &dockBottom, &dockCenter);
+
 		ImGui::DockBuilderDockWindow("Scene Hierarchy", dockLeft);
 		ImGui::DockBuilderDockWindow("Scene", dockCenter);
 		ImGui::DockBuilderDockWindow("Inspector", dockRight);
+		ImGui::DockBuilderDockWindow("Profiler", dockBottom);
 
 		ImGui::DockBuilderFinish(dockspaceId);
 	}
@@ -1151,6 +1302,179 @@ namespace CPURDR
 		RenderInspectorMultiSelect();
 	}
 
+	void App::RenderProfiler()
+	{
+		ImGui::Begin("Profiler", nullptr, UI::GetEditorPanelFlags());
+
+		Profiler& profiler = Profiler::GetInstance();
+
+#ifndef CPURDR_ENABLE_PROFILER
+		ImGui::TextDisabled("Built without CPURDR_ENABLE_PROFILER");
+#endif
+
+		bool enabled = Profiler::IsEnabled();
+		if (ImGui::Checkbox("Enabled", &enabled))
+		{
+			profiler.SetEnabled(enabled);
+		}
+		ImGui::SameLine();
+		bool paused = profiler.IsPaused();
+		if (ImGui::Checkbox("Pause", &paused))
+		{
+			profiler.SetPaused(paused);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button(profiler.IsCapturing()? "Stop Capture" : "Start Capture"))
+		{
+			if (profiler.IsCapturing()) profiler.StopCapture();
+			else profiler.StartCapture();
+		}
+		ImGui::SameLine();
+		ImGui::BeginDisabled(profiler.IsCapturing() || profiler.GetCapturedEventCount() == 0);
+		if (ImGui::Button("Export Chrome Trace"))
+		{
+			profiler.ExportChromeTrace("profile_trace.json");
+		}
+		ImGui::EndDisabled();
+		ImGui::SameLine();
+		ImGui::TextDisabled("%zu captured, %llu dropped", profiler.GetCapturedEventCount(),
+			(unsigned long long)profiler.GetDroppedEventCount());
+
+		const std::deque<ProfileFrame>& frames = profiler.GetFrames();
+		if (frames.empty())
+		{
+			ImGui::TextDisabled("No frames recorded");
+			ImGui::End();
+			return;
+		}
+
+		// Frame time history, newest on the right
+		std::vector<float> frameMs(frames.size());
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			frameMs[i] = (float)profiler.TicksToMs(frames[i].end - frames[i].start);
+		}
+		ImGui::PlotHistogram("##FrameTimes", frameMs.data(), (int)frameMs.size(), 0, nullptr,
+			0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 50.0f));
+
+		m_ProfilerFrameOffset = std::clamp(m_ProfilerFrameOffset, 0, (int)frames.size() - 1);
+		ImGui::SliderInt("Frames Back", &m_ProfilerFrameOffset, 0, (int)frames.size() - 1);
+		const ProfileFrame& frame = frames[frames.size() - 1 - m_ProfilerFrameOffset];
+		const double frameLengthMs = profiler.TicksToMs(frame.end - frame.start);
+		ImGui::SameLine();
+		ImGui::Text("%.3f ms", frameLengthMs);
+
+		// Everything that overlaps the frame, the render job of a frame usually ends in the next one
+		const std::vector<std::string> threadNames = profiler.GetThreadNames();
+		std::vector<const ProfileEvent*> frameEvents;
+		std::vector<uint32_t> laneDepths(threadNames.size(), 0);
+		for (const ProfileEvent& event : profiler.GetEvents())
+		{
+			if (event.end < frame.start || event.start > frame.end || event.threadIndex >= threadNames.size()) continue;
+			frameEvents.push_back(&event);
+			laneDepths[event.threadIndex] = std::max(laneDepths[event.threadIndex], event.depth + 1);
+		}
+
+		// Timeline, one lane per thread and one row per nesting depth
+		const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+		const float labelWidth = 90.0f;
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const float timelineWidth = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 1.0f);
+		const double pixelsPerTick = (double)timelineWidth / (double)std::max<uint64_t>(frame.end - frame.start, 1);
+		const ImVec2 mouse = ImGui::GetIO().MousePos;
+
+		float laneY = origin.y;
+		std::vector<float> laneTops(threadNames.size(), 0.0f);
+		for (size_t lane = 0; lane < threadNames.size(); ++lane)
+		{
+			if (laneDepths[lane] == 0) continue;
+			laneTops[lane] = laneY;
+			drawList->AddText(ImVec2(origin.x, laneY + 2.0f), ImGui::GetColorU32(ImGuiCol_TextDisabled), threadNames[lane].c_str());
+			laneY += rowHeight * (float)laneDepths[lane] + 4.0f;
+		}
+
+		const ProfileEvent* hovered = nullptr;
+		drawList->PushClipRect(ImVec2(origin.x + labelWidth, origin.y), ImVec2(origin.x + labelWidth + timelineWidth, laneY), true);
+		for (const ProfileEvent* event : frameEvents)
+		{
+			const float x0 = origin.x + labelWidth + (float)(((double)event->start - (double)frame.start) * pixelsPerTick);
+			const float x1 = origin.x + labelWidth + (float)(((double)event->end - (double)frame.start) * pixelsPerTick);
+			const float y0 = laneTops[event->threadIndex] + rowHeight * (float)event->depth;
+			const ImVec2 min(x0, y0);
+			const ImVec2 max(std::max(x1, x0 + 1.0f), y0 + rowHeight - 1.0f);
+
+			// Stable color per scope name
+			const uint32_t hash = (uint32_t)(((uintptr_t)event->name >> 3) * 2654435761u);
+			const ImU32 color = IM_COL32(90 + (hash & 0x7F), 90 + ((hash >> 8) & 0x7F), 90 + ((hash >> 16) & 0x7F), 255);
+			drawList->AddRectFilled(min, max, color);
+			if (max.x - min.x > 30.0f)
+			{
+				drawList->PushClipRect(min, max, true);
+				drawList->AddText(ImVec2(min.x + 3.0f, min.y + 2.0f), IM_COL32(20, 20, 20, 255), event->name);
+				drawList->PopClipRect();
+			}
+
+			if (ImGui::IsWindowHovered() && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+			{
+				hovered = event;
+			}
+		}
+		drawList->PopClipRect();
+		ImGui::Dummy(ImVec2(labelWidth + timelineWidth, laneY - origin.y));
+
+		if (hovered)
+		{
+			ImGui::SetTooltip("%s\n%.3f ms", hovered->name, profiler.TicksToMs(hovered->end - hovered->start));
+		}
+
+		// Inclusive time per scope name within the frame, most expensive first
+		struct ScopeTotal
+		{
+			const char* name;
+			uint64_t ticks;
+			uint32_t calls;
+		};
+		std::vector<ScopeTotal> totals;
+		for (const ProfileEvent* event : frameEvents)
+		{
+			const uint64_t start = std::max(event->start, frame.start);
+			const uint64_t end = std::min(event->end, frame.end);
+			auto it = std::find_if(totals.begin(), totals.end(), [event](const ScopeTotal& total) {return std::strcmp(total.name, event->name) == 0;});
+			if (it == totals.end())
+			{
+				totals.push_back({event->name, end - start, 1});
+			}
+			else
+			{
+				it->ticks += end - start;
+				it->calls++;
+			}
+		}
+		std::sort(totals.begin(), totals.end(), [](const ScopeTotal& a, const ScopeTotal& b) {return a.ticks > b.ticks;});
+
+		if (ImGui::BeginTable("ProfilerScopes", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp))
+		{
+			ImGui::TableSetupColumn("Scope");
+			ImGui::TableSetupColumn("ms");
+			ImGui::TableSetupColumn("Calls");
+			ImGui::TableHeadersRow();
+			for (const ScopeTotal& total : totals)
+			{
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(total.name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", profiler.TicksToMs(total.ticks));
+				ImGui::TableNextColumn();
+				ImGui::Text("%u", total.calls);
+			}
+			ImGui::EndTable();
+		}
+
+		ImGui::End();
+	}
+
 	void App::RenderInspectorMultiSelect()
 	{
 		ImGui::Begin("Inspector", nullptr, UI::GetEditorPanelFlags());
@@ -1244,13 +1568,36 @@ namespace CPURDR
 			{
 				if (ImGui::CollapsingHeader("MeshFilter"))
 				{
-					ImGui::Text("Meshes: %zu", meshFilter->meshes.size());
-					for (size_t i = 0; i < meshFilter->meshes.size(); i++)
+					const auto& meshes = meshFilter->GetMeshes();
+					if (meshFilter->asset)
+					{
+						ImGui::Text("Asset: %s", meshFilter->asset->source.empty()? "<generated>" : meshFilter->asset->source.c_str());
+						ImGui::Text("Shared by: %ld", meshFilter->asset.use_count());
+						const MeshAsset& asset = *meshFilter->asset;
+						if (asset.GetLodCount() > 1 && ImGui::TreeNode("LODs"))
+						{
+							for (size_t level = 0; level < asset.GetLodCount(); level++)
+							{
+								if (asset.stream && !asset.stream->IsResident(level))
+								{
+									ImGui::TextDisabled("LOD %zu: paged out, error %.4f", level, asset.GetLodError(level));
+									continue;
+								}
+								const std::vector<Mesh>& lodMeshes = asset.stream? asset.stream->GetMeshes(level) : asset.GetLodMeshes(level);
+								size_t triangles = 0;
+								for (const Mesh& mesh : lodMeshes) triangles += mesh.indices.size() / 3;
+								ImGui::Text("LOD %zu: %zu triangles, error %.4f", level, triangles, asset.GetLodError(level));
+							}
+							ImGui::TreePop();
+						}
+					}
+					ImGui::Text("Meshes: %zu", meshes.size());
+					for (size_t i = 0; i < meshes.size(); i++)
 					{
-						const auto& mesh = meshFilter->meshes[i];
+						const auto& mesh = meshes[i];
 						if (ImGui::TreeNode((void*)(intptr_t)i, "Mesh %zu", i))
 						{
-							ImGui::Text("Vertices: %zu", mesh.vertices.size());
+							ImGui::Text("Vertices: %zu%s", mesh.GetVertexCount(), mesh.IsQuantized()? " (quantized)" : "");
 							ImGui::Text("Indices: %zu", mesh.indices.size());
 							ImGui::Text("Triangles: %zu", mesh.indices.size() / 3);
 							ImGui::TreePop();
@@ -1406,6 +1753,291 @@ namespace CPURDR
 	}
 
 
+	void App::KickRenderJob()
+	{
+		// The job renders with a copy of the camera so input handling never races it
+		m_RenderJob = ThreadPool::GetInstance().Submit([this, camera = *m_Camera]()
+		{
+			PROFILE_SCOPE("App::RenderJob");
+			const uint64_t start = SDL_GetPerformanceCounter();
+
+			ClearValue clearValue;
+			clearValue.color = 0x141414FF;
+			// Standard-Z clears to 1.0, Reversed-Z clears to 0.0
+			clearValue.depth = m_RenderContext->GetClearDepth();
+			m_RenderContext->BeginRenderPass(clearValue);
+
+			Viewport viewport;
+			viewport.x = 0;
+			viewport.y = 0;
+			viewport.width = m_RenderContext->GetFramebufferWidth();
+			viewport.height = m_RenderContext->GetFramebufferHeight();
+			m_RenderContext->SetViewport(viewport);
+
+			m_RenderPipeline->Render(m_Scene->GetRegistry(), m_RenderContext.get(), camera);
+
+			Gizmos::DrawAxis(m_RenderContext.get(), camera, 2.0f, 0.03f);
+
+			m_RenderContext->EndRenderPass();
+			m_RenderJobMs = (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+		});
+	}
+
+	void App::WaitForRenderJob()
+	{
+		if (!m_RenderJob.valid())
+		{
+			return;
+		}
+
+		PROFILE_SCOPE("App::WaitForRenderJob");
+		m_RenderJob.get();
+		m_RenderContext->SwapFramebuffers();
+	}
+
+	bool App::UploadSceneTexture(SDL_GPUCommandBuffer* commandBuffer)
+	{
+		PROFILE_SCOPE("App::UploadSceneTexture");
+
+		// With a single framebuffer the present buffer is the one being rendered
+		if (m_RenderContext->GetFramebufferCount() < 2)
+		{
+			WaitForRenderJob();
+		}
+
+		m_SceneUploadedPixels = 0;
+		const Texture2D_RGBA* presentColorBuffer = m_RenderContext->GetPresentColorBuffer();
+		if (!presentColorBuffer)
+		{
+			return false;
+		}
+
+		const uint32_t w = (uint32_t)presentColorBuffer->GetWidth();
+		const uint32_t h = (uint32_t)presentColorBuffer->GetHeight();
+		const uint32_t bytes = w * h * sizeof(uint32_t);
+		bool fullUpload = false;
+
+		// Recreate GPU texture/buffers on first use or resize
+		if (!m_SceneGPUTexture || w != m_SceneGPUWidth || h != m_SceneGPUHeight)
+		{
+			ReleaseSceneUploadSlots();
+			if (m_SceneGPUTexture)
+			{
+				SDL_ReleaseGPUTexture(m_GPUDevice, m_SceneGPUTexture);
+				m_SceneGPUTexture = nullptr;
+			}
+
+			SDL_GPUTextureCreateInfo tex_info = {};
+			tex_info.type = SDL_GPU_TEXTURETYPE_2D;
+			tex_info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+			tex_info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+			tex_info.width = w;
+			tex_info.height = h;
+			tex_info.layer_count_or_depth = 1;
+			tex_info.num_levels = 1;
+			tex_info.sample_count = SDL_GPU_SAMPLECOUNT_1;
+			tex_info.props = 0;
+
+			m_SceneGPUTexture = SDL_CreateGPUTexture(m_GPUDevice, &tex_info);
+
+			SDL_GPUTransferBufferCreateInfo tb_info = {};
+			tb_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+			tb_info.size = bytes;
+			tb_info.props = 0;
+
+			for (SceneUploadSlot& slot : m_SceneUploadSlots)
+			{
+				slot.buffer = SDL_CreateGPUTransferBuffer(m_GPUDevice, &tb_info);
+			}
+			m_SceneUploadIndex = 0;
+
+			m_SceneGPUWidth = w;
+			m_SceneGPUHeight = h;
+			fullUpload = true;
+		}
+
+		SceneUploadSlot& slot = m_SceneUploadSlots[m_SceneUploadIndex];
+		if (!m_SceneGPUTexture || !slot.buffer)
+		{
+			return false;
+		}
+
+		// From here on the CPU copy claims this frame, any failure below leaves the texture behind it
+		std::vector<SDL_Rect> dirtyRects;
+		CollectSceneDamage(*presentColorBuffer, fullUpload || m_SceneTextureStale, dirtyRects);
+		m_SceneTextureStale = false;
+		if (dirtyRects.empty())
+		{
+			return false;
+		}
+
+		// Only block if the GPU is still reading this buffer from SCENE_UPLOADS_IN_FLIGHT frames ago
+		if (slot.fence)
+		{
+			SDL_WaitForGPUFences(m_GPUDevice, true, &slot.fence, 1);
+			SDL_ReleaseGPUFence(m_GPUDevice, slot.fence);
+			slot.fence = nullptr;
+		}
+
+		void* dst = SDL_MapGPUTransferBuffer(m_GPUDevice, slot.buffer, false);
+		if (!dst)
+		{
+			m_SceneTextureStale = true;
+			return false;
+		}
+
+		// Rects are packed back to back in the transfer buffer, each with its own row pitch.
+		// A plain copy while the context renders in the texture's layout
+		const ColorFormat colorFormat = m_RenderContext->GetColorFormat();
+		const uint32_t* srcPixels = presentColorBuffer->GetData();
+		uint32_t* dstPixels = static_cast<uint32_t*>(dst);
+		std::vector<uint32_t> rectOffsets;
+		rectOffsets.reserve(dirtyRects.size());
+		uint32_t offset = 0;
+		for (const SDL_Rect& rect : dirtyRects)
+		{
+			rectOffsets.push_back(offset);
+			if (rect.w == (int)w)
+			{
+				ConvertPixels(srcPixels + (size_t)rect.y * w, colorFormat,
+					dstPixels + offset, SCENE_TEXTURE_COLOR_FORMAT, (size_t)rect.w * rect.h);
+			}
+			else
+			{
+				for (int y = 0; y < rect.h; ++y)
+				{
+					ConvertPixels(srcPixels + (size_t)(rect.y + y) * w + rect.x, colorFormat,
+						dstPixels + offset + (size_t)y * rect.w, SCENE_TEXTURE_COLOR_FORMAT, rect.w);
+				}
+			}
+			offset += (uint32_t)(rect.w * rect.h);
+		}
+		SDL_UnmapGPUTransferBuffer(m_GPUDevice, slot.buffer);
+
+		SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(commandBuffer);
+		if (!copy_pass)
+		{
+			m_SceneTextureStale = true;
+			return false;
+		}
+
+		for (size_t i = 0; i < dirtyRects.size(); ++i)
+		{
+			const SDL_Rect& rect = dirtyRects[i];
+
+			SDL_GPUTextureTransferInfo src = {};
+			src.transfer_buffer = slot.buffer;
+			src.offset = rectOffsets[i] * sizeof(uint32_t);
+			src.pixels_per_row = rect.w;
+			src.rows_per_layer = rect.h;
+
+			SDL_GPUTextureRegion dst_region = {};
+			dst_region.texture = m_SceneGPUTexture;
+			dst_region.mip_level = 0;
+			dst_region.layer = 0;
+			dst_region.x = rect.x;
+			dst_region.y = rect.y;
+			dst_region.z = 0;
+			dst_region.w = rect.w;
+			dst_region.h = rect.h;
+			dst_region.d = 1;
+
+			SDL_UploadToGPUTexture(copy_pass, &src, &dst_region, false);
+		}
+		SDL_EndGPUCopyPass(copy_pass);
+
+		m_SceneUploadedPixels = offset;
+		return true;
+	}
+
+	void App::CollectSceneDamage(const Texture2D_RGBA& colorBuffer, bool fullUpload, std::vector<SDL_Rect>& dirtyRects)
+	{
+		const int width = (int)colorBuffer.GetWidth();
+		const int height = (int)colorBuffer.GetHeight();
+		const ColorDamage& damage = m_RenderContext->GetPresentColorDamage();
+		const ColorFormat colorFormat = m_RenderContext->GetColorFormat();
+		ColorDamage& presented = m_ScenePresentedDamage;
+
+		// The texture holds the last uploaded frame. Untouched tiles of both frames are the clear color,
+		// so only tiles drawn in either frame can differ, as long as nothing else changed in between
+		fullUpload |= damage.unknown || presented.unknown ||
+			colorFormat != m_ScenePresentedColorFormat ||
+			damage.clearColor != presented.clearColor ||
+			damage.tileColumns != presented.tileColumns || damage.tileRows != presented.tileRows ||
+			m_ScenePresentedPixels.size() != colorBuffer.GetSize();
+
+		const uint32_t* srcPixels = colorBuffer.GetData();
+		if (fullUpload)
+		{
+			m_ScenePresentedPixels.assign(srcPixels, srcPixels + colorBuffer.GetSize());
+			dirtyRects.push_back(SDL_Rect{0, 0, width, height});
+		}
+		else
+		{
+			// Tiles that were redrawn with identical pixels are skipped, which is the common case for a static scene
+			for (int tileY = 0; tileY < damage.tileRows; ++tileY)
+			{
+				const int y0 = tileY * ColorDamage::TILE_SIZE;
+				const int rows = std::min(ColorDamage::TILE_SIZE, height - y0);
+				int spanStart = -1;
+
+				for (int tileX = 0; tileX <= damage.tileColumns; ++tileX)
+				{
+					bool dirty = false;
+					if (tileX < damage.tileColumns &&
+						(damage.IsTileWritten(tileX, tileY) || presented.IsTileWritten(tileX, tileY)))
+					{
+						const int x0 = tileX * ColorDamage::TILE_SIZE;
+						const size_t rowBytes = std::min(ColorDamage::TILE_SIZE, width - x0) * sizeof(uint32_t);
+						for (int y = y0; y < y0 + rows; ++y)
+						{
+							const size_t index = (size_t)y * width + x0;
+							if (std::memcmp(srcPixels + index, m_ScenePresentedPixels.data() + index, rowBytes) != 0)
+							{
+								std::memcpy(m_ScenePresentedPixels.data() + index, srcPixels + index, rowBytes);
+								dirty = true;
+							}
+						}
+					}
+
+					// Merge horizontally adjacent dirty tiles into one rect
+					if (dirty && spanStart < 0)
+					{
+						spanStart = tileX;
+					}
+					else if (!dirty && spanStart >= 0)
+					{
+						const int x0 = spanStart * ColorDamage::TILE_SIZE;
+						const int x1 = std::min(tileX * ColorDamage::TILE_SIZE, width);
+						dirtyRects.push_back(SDL_Rect{x0, y0, x1 - x0, rows});
+						spanStart = -1;
+					}
+				}
+			}
+		}
+
+		presented = damage;
+		m_ScenePresentedColorFormat = colorFormat;
+	}
+
+	void App::ReleaseSceneUploadSlots()
+	{
+		for (SceneUploadSlot& slot : m_SceneUploadSlots)
+		{
+			if (slot.fence)
+			{
+				SDL_WaitForGPUFences(m_GPUDevice, true, &slot.fence, 1);
+				SDL_ReleaseGPUFence(m_GPUDevice, slot.fence);
+				slot.fence = nullptr;
+			}
+			if (slot.buffer)
+			{
+				SDL_ReleaseGPUTransferBuffer(m_GPUDevice, slot.buffer);
+				slot.buffer = nullptr;
+			}
+		}
+	}
+
 	void App::ShutdownImGui()
 	{
 		// ImGui_ImplSDLRenderer3_Shutdown();
@@ -1423,16 +2055,16 @@ namespace CPURDR
 		// 	m_DisplayTexture = nullptr;
 		// }
 
+		WaitForRenderJob();
+		MeshLoader::GetInstance().Shutdown();
+		MeshResidency::GetInstance().Shutdown();
+
+		ReleaseSceneUploadSlots();
 		if (m_SceneGPUTexture)
 		{
 			SDL_ReleaseGPUTexture(m_GPUDevice, m_SceneGPUTexture);
 			m_SceneGPUTexture = nullptr;
 		}
-		if (m_SceneUploadBuffer)
-		{
-			SDL_ReleaseGPUTransferBuffer(m_GPUDevice, m_SceneUploadBuffer);
-			m_SceneUploadBuffer = nullptr;
-		}
 
 		ShutdownImGui();
 
@@ -1,11 +1,14 @@
 #pragma once
 #include "SDL3/SDL.h"
 #include <glm.hpp>
+#include <array>
+#include <future>
 #include <memory>
 
 #include "entt.hpp"
 #include "Model.h"
 #include "assimp/scene.h"
+#include "render/DynamicResolution.h"
 #include "render/RenderPipeline.h"
 #include "render/Window.h"
 
@@ -45,6 +48,13 @@ namespace CPURDR
 
 		void SetupDockingLayout();
 		void RenderInspector();
+		void RenderProfiler();
+
+		void KickRenderJob();
+		void WaitForRenderJob();
+		bool UploadSceneTexture(SDL_GPUCommandBuffer* commandBuffer);
+		void CollectSceneDamage(const Texture2D_RGBA& colorBuffer, bool fullUpload, std::vector<SDL_Rect>& dirtyRects);
+		void ReleaseSceneUploadSlots();
 
 		void HandleEntityDeletion();
 		void RenderInspectorMultiSelect();
@@ -71,14 +81,44 @@ namespace CPURDR
 		bool m_MouseCaptured = false;
 		bool m_DockingLayoutInitialized = false;
 
+		// Frames back from the newest one shown in the profiler timeline
+		int m_ProfilerFrameOffset = 0;
+		int m_FrameCaptureCount = 0;
+
 		std::vector<entt::entity> m_SelectedEntities;
 		bool m_HasSelection = false;
 
 		SDL_Renderer* m_ImGuiRenderer; // deprecated
 		SDL_GPUTexture* m_DisplayTexture; // deprecated
 
+		// Matches SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM byte order
+		static constexpr ColorFormat SCENE_TEXTURE_COLOR_FORMAT = ColorFormat::ABGR8888;
 		SDL_GPUTexture* m_SceneGPUTexture = nullptr;
-		SDL_GPUTransferBuffer* m_SceneUploadBuffer = nullptr;
+		// Transfer buffers are reused once the GPU signals the fence of their last upload
+		struct SceneUploadSlot
+		{
+			SDL_GPUTransferBuffer* buffer = nullptr;
+			SDL_GPUFence* fence = nullptr;
+		};
+		static constexpr uint32_t SCENE_UPLOADS_IN_FLIGHT = 3;
+		std::array<SceneUploadSlot, SCENE_UPLOADS_IN_FLIGHT> m_SceneUploadSlots;
+		uint32_t m_SceneUploadIndex = 0;
+		std::future<void> m_RenderJob;
+		// Written by the render job, read once it has been waited for
+		float m_RenderJobMs = 0.0f;
+
+		bool m_DynamicResolutionEnabled = false;
+		DynamicResolution m_DynamicResolution;
+		// Dropped models page their levels of detail through MeshResidency instead of loading whole
+		bool m_StreamDroppedMeshes = false;
+
+		// CPU copy of what the scene texture holds, to find which written tiles actually changed
+		std::vector<uint32_t> m_ScenePresentedPixels;
+		ColorDamage m_ScenePresentedDamage;
+		ColorFormat m_ScenePresentedColorFormat = ColorFormat::RGBA8888;
+		// An upload failed or was dropped after the CPU copy took it in, the texture is re-uploaded whole
+		bool m_SceneTextureStale = false;
+		uint32_t m_SceneUploadedPixels = 0;
 		uint32_t m_SceneGPUWidth = 0;
 		uint32_t m_SceneGPUHeight = 0;
 
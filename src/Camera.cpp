@@ -73,6 +73,20 @@ namespace CPURDR
 		// 0.0f,       0.0f, -(m_Far + m_Near) / (m_Far - m_Near), -2.0 * (m_Far * m_Near) / (m_Far - m_Near),
 		// 0.0f,       0.0f, 1.0,                                  0.0f
 
+		// ================================
+		// Vulkan Convention, Reversed-Z, Infinite Far
+		// ================================
+		// z_ndc = near / -z_view, 1.0 at the near plane and approaches 0.0 at infinity
+		if (m_ReversedZ)
+		{
+			return glm::mat4(
+				f / aspect, 0.0f, 0.0f, 0.0f,
+				0.0f, -f, 0.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, -1.0f,
+				0.0f, 0.0f, m_Near, 0.0f
+				);
+		}
+
 		// ================================
 		// Vulkan Convention
 		// ================================
@@ -189,7 +203,7 @@ namespace CPURDR
 
 		// Check if the point is within the near and far planes
 		float distance = glm::dot(toPoint, m_Front);
-		if (distance < m_Near || distance > m_Far)
+		if (distance < m_Near || (!m_ReversedZ && distance > m_Far))
 		{
 			return false;
 		}
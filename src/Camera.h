@@ -11,6 +11,7 @@ namespace CPURDR
 	// X: -1.0 ~ 1.0(left to right)
 	// Y: -1.0 ~ 1.0(top to bottom)
 	// Z: 0.0 ~ 1.0(near to far)
+	// Z: 1.0 ~ 0.0(near to infinity) with Reversed-Z
 
 	// ===============
 	// Framebuffer Coord
@@ -52,6 +53,9 @@ namespace CPURDR
 		void SetRotation(float yaw, float pitch, float roll = 0.0f);
 		void SetFOV(float fov);
 		void SetClipPlanes(float nearPlane, float farPlane);
+		// Reversed-Z uses an infinite far plane, m_Far is ignored by the projection
+		void SetReversedZ(bool reversedZ) {m_ReversedZ = reversedZ;}
+		bool IsReversedZ() const {return m_ReversedZ;}
 
 		void LookAt(const glm::vec3& target);
 		void Reset();
@@ -87,6 +91,7 @@ namespace CPURDR
 
 		float m_Near{0.1f};
 		float m_Far{10.0f};
+		bool m_ReversedZ{false};
 
 		static constexpr float DEFAULT_YAW = -90.0f;
 		static constexpr float DEFAULT_PITCH = 0.0f;
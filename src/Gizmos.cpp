@@ -1,5 +1,7 @@
 #include "Gizmos.h"
 
+#include <limits>
+
 #include "glm.hpp"
 #include "Graphics.h"
 #include "ext/matrix_transform.hpp"
@@ -160,6 +162,37 @@ namespace CPURDR
 			return;
 		}
 
+		// Gizmo colors are 0xRRGGBBAA
+		color = context->EncodeColor(color);
+
+		const bool reversedZ = context->IsReversedZ();
+		switch (context->GetDepthFormat())
+		{
+		case DepthFormat::D32_Float:
+			if (reversedZ)
+				DrawMesh<DepthFormat::D32_Float, DepthFunction::Greater>(context, camera, mesh, transform, color);
+			else
+				DrawMesh<DepthFormat::D32_Float, DepthFunction::Less>(context, camera, mesh, transform, color);
+			break;
+		case DepthFormat::D24_UNorm_S8_UInt:
+			if (reversedZ)
+				DrawMesh<DepthFormat::D24_UNorm_S8_UInt, DepthFunction::Greater>(context, camera, mesh, transform, color);
+			else
+				DrawMesh<DepthFormat::D24_UNorm_S8_UInt, DepthFunction::Less>(context, camera, mesh, transform, color);
+			break;
+		case DepthFormat::D16_UNorm:
+			if (reversedZ)
+				DrawMesh<DepthFormat::D16_UNorm, DepthFunction::Greater>(context, camera, mesh, transform, color);
+			else
+				DrawMesh<DepthFormat::D16_UNorm, DepthFunction::Less>(context, camera, mesh, transform, color);
+			break;
+		}
+	}
+
+	template<DepthFormat Format, DepthFunction Function>
+	void Gizmos::DrawMesh(Context* context, const Camera& camera, const Mesh& mesh, const glm::mat4& transform, uint32_t color)
+	{
+
 		const Viewport& viewport = context->GetViewport();
 		int width = viewport.width;
 		int height = viewport.height;
@@ -169,7 +202,7 @@ namespace CPURDR
 		glm::mat4 projectionMatrix = camera.GetProjectionMatrix(aspect);
 		glm::mat4 mvpMatrix = projectionMatrix * viewMatrix * transform;
 
-		Texture2D_RFloat* depthBuffer = context->GetDepthBuffer();
+		auto* depthBuffer = context->GetDepthAttachment<Format>();
 		Texture2D_RGBA* colorBuffer = context->GetColorBuffer();
 
 		if (!depthBuffer || !colorBuffer)
@@ -179,6 +212,32 @@ namespace CPURDR
 
 		const float EPSILON = 0.001f;
 
+		// Mark the projected bounds of the whole gizmo as drawn, or everything if part of it is behind the camera
+		glm::vec2 screenMin(std::numeric_limits<float>::max());
+		glm::vec2 screenMax(std::numeric_limits<float>::lowest());
+		bool behindCamera = false;
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			glm::vec4 clip = mvpMatrix * glm::vec4(vertex.position, 1.0f);
+			if (clip.w < EPSILON)
+			{
+				behindCamera = true;
+				break;
+			}
+			glm::vec2 screen = (glm::vec2(clip) / clip.w + 1.0f) * 0.5f * glm::vec2(width, height);
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+		}
+		if (behindCamera)
+		{
+			context->MarkColorWritten(0, 0, width - 1, height - 1);
+		}
+		else if (!mesh.vertices.empty())
+		{
+			context->MarkColorWritten((int)std::floor(screenMin.x), (int)std::floor(screenMin.y),
+				(int)std::ceil(screenMax.x), (int)std::ceil(screenMax.y));
+		}
+
 		for (size_t i = 0; i < mesh.indices.size(); i += 3)
 		{
 			glm::vec3 p0 = mesh.vertices[mesh.indices[i]].position;
@@ -198,7 +257,7 @@ namespace CPURDR
 
 			if (behindCount > 0)
 			{
-				ClipAndRenderTriangle(clip0, clip1, clip2, width, height,
+				ClipAndRenderTriangle<Format, Function>(clip0, clip1, clip2, width, height,
 					depthBuffer, colorBuffer, color, EPSILON);
 				continue;
 			}
@@ -225,7 +284,7 @@ namespace CPURDR
 			screen2.y = (clip2.y + 1.0f) * 0.5f * height;
 			screen2.z = clip2.z;
 
-			Graphics::Triangle(screen0, screen1, screen2,
+			Graphics::Triangle<Format, Function>(screen0, screen1, screen2,
 				width, height, *depthBuffer, *colorBuffer, color);
 		}
 	}
@@ -249,9 +308,10 @@ namespace CPURDR
 		return inside + t * (outside - inside);
 	}
 
+	template<DepthFormat Format, DepthFunction Function>
 	void Gizmos::ClipAndRenderTriangle(const glm::vec4& v0, const glm::vec4& v1,
 		const glm::vec4& v2, int width, int height,
-		Texture2D_RFloat* depthBuffer, Texture2D_RGBA* colorBuffer,
+		typename DepthFormatTraits<Format>::TextureType* depthBuffer, Texture2D_RGBA* colorBuffer,
 		uint32_t color, float nearPlane)
 	{
 		bool front0 = v0.w >= nearPlane;
@@ -322,7 +382,7 @@ namespace CPURDR
 			glm::vec3 s0 = ClipToScreen(clipped[0]);
 			glm::vec3 s1 = ClipToScreen(clipped[1]);
 			glm::vec3 s2 = ClipToScreen(clipped[2]);
-			Graphics::Triangle(s0, s1, s2, width, height, *depthBuffer, *colorBuffer, color);
+			Graphics::Triangle<Format, Function>(s0, s1, s2, width, height, *depthBuffer, *colorBuffer, color);
 		}
 		else if (clipCount == 4)
 		{
@@ -331,8 +391,8 @@ namespace CPURDR
 			glm::vec3 s2 = ClipToScreen(clipped[2]);
 			glm::vec3 s3 = ClipToScreen(clipped[3]);
 
-			Graphics::Triangle(s0, s1, s2, width, height, *depthBuffer, *colorBuffer, color);
-			Graphics::Triangle(s0, s2, s3, width, height, *depthBuffer, *colorBuffer, color);
+			Graphics::Triangle<Format, Function>(s0, s1, s2, width, height, *depthBuffer, *colorBuffer, color);
+			Graphics::Triangle<Format, Function>(s0, s2, s3, width, height, *depthBuffer, *colorBuffer, color);
 		}
 	}
 
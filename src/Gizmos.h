@@ -22,9 +22,13 @@ namespace CPURDR
 		static Mesh CreateConeMesh(float radius = 0.05f, float height = 0.15f, int segments = 8);
 		static void DrawMesh(Context* context, const Camera& camera, const Mesh& mesh, const glm::mat4& transform, uint32_t color);
 
+		template<DepthFormat Format, DepthFunction Function>
+		static void DrawMesh(Context* context, const Camera& camera, const Mesh& mesh, const glm::mat4& transform, uint32_t color);
+
+		template<DepthFormat Format, DepthFunction Function>
 		static void ClipAndRenderTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2,
-			int width, int height, Texture2D_RFloat* depthBuffer, Texture2D_RGBA* colorBuffer,
-			uint32_t color, float nearPlane);
+			int width, int height, typename DepthFormatTraits<Format>::TextureType* depthBuffer,
+			Texture2D_RGBA* colorBuffer, uint32_t color, float nearPlane);
 
 		static uint32_t ColorToUint32(const glm::vec3& color);
 
@@ -178,6 +178,16 @@ void Graphics::Triangle(SDL_Renderer* renderer, glm::vec3 p0, glm::vec3 p1, glm:
 void Graphics::Triangle(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, const int& width, const int& height,
 	CPURDR::Texture2D_RFloat& depthBuffer, CPURDR::Texture2D_RGBA& colorBuffer, uint32_t color)
 {
+	Triangle<CPURDR::DepthFormat::D32_Float>(p0, p1, p2, width, height, depthBuffer, colorBuffer, color);
+}
+
+template<CPURDR::DepthFormat Format, CPURDR::DepthFunction Function>
+void Graphics::Triangle(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, const int& width, const int& height,
+	typename CPURDR::DepthFormatTraits<Format>::TextureType& depthBuffer, CPURDR::Texture2D_RGBA& colorBuffer,
+	uint32_t color)
+{
+	using DepthTraits = CPURDR::DepthFormatTraits<Format>;
+
 	glm::vec2 bboxMin = glm::vec2(
 		std::min(p0.x, std::min(p1.x, p2.x)),
 		std::min(p0.y, std::min(p1.y, p2.y))
@@ -233,11 +243,15 @@ void Graphics::Triangle(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, const int& wid
 
 				float depth = bary0 * p0.z + bary1 * p1.z + bary2 * p2.z;
 
-				// depth > depthBuffer(x, y) for Reversed-Z
-				if (depth >= 0.0f && depth <= 1.0f && depth < depthBuffer(x, y))
+				if (depth >= 0.0f && depth <= 1.0f)
 				{
-					depthBuffer(x, y) = depth;
-					colorBuffer(x, y) = color;
+					auto& depthTexel = depthBuffer(x, y);
+					const auto encodedDepth = DepthTraits::Encode(depth);
+					if (CPURDR::PassesDepthTest<Function>(encodedDepth, DepthTraits::Load(depthTexel)))
+					{
+						depthTexel = DepthTraits::Store(depthTexel, encodedDepth);
+						colorBuffer(x, y) = color;
+					}
 				}
 			}
 
@@ -249,6 +263,19 @@ void Graphics::Triangle(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, const int& wid
 	}
 }
 
+template void Graphics::Triangle<CPURDR::DepthFormat::D32_Float, CPURDR::DepthFunction::Less>(glm::vec3, glm::vec3, glm::vec3,
+	const int&, const int&, CPURDR::Texture2D_RFloat&, CPURDR::Texture2D_RGBA&, uint32_t);
+template void Graphics::Triangle<CPURDR::DepthFormat::D32_Float, CPURDR::DepthFunction::Greater>(glm::vec3, glm::vec3, glm::vec3,
+	const int&, const int&, CPURDR::Texture2D_RFloat&, CPURDR::Texture2D_RGBA&, uint32_t);
+template void Graphics::Triangle<CPURDR::DepthFormat::D24_UNorm_S8_UInt, CPURDR::DepthFunction::Less>(glm::vec3, glm::vec3, glm::vec3,
+	const int&, const int&, CPURDR::Texture2D_D24S8&, CPURDR::Texture2D_RGBA&, uint32_t);
+template void Graphics::Triangle<CPURDR::DepthFormat::D24_UNorm_S8_UInt, CPURDR::DepthFunction::Greater>(glm::vec3, glm::vec3, glm::vec3,
+	const int&, const int&, CPURDR::Texture2D_D24S8&, CPURDR::Texture2D_RGBA&, uint32_t);
+template void Graphics::Triangle<CPURDR::DepthFormat::D16_UNorm, CPURDR::DepthFunction::Less>(glm::vec3, glm::vec3, glm::vec3,
+	const int&, const int&, CPURDR::Texture2D_D16&, CPURDR::Texture2D_RGBA&, uint32_t);
+template void Graphics::Triangle<CPURDR::DepthFormat::D16_UNorm, CPURDR::DepthFunction::Greater>(glm::vec3, glm::vec3, glm::vec3,
+	const int&, const int&, CPURDR::Texture2D_D16&, CPURDR::Texture2D_RGBA&, uint32_t);
+
 double Graphics::SignedTriangleArea(const glm::vec3 p0, const glm::vec3 p1, const glm::vec3 p2)
 {
 	// clockwise -> -
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Texture2D.h"
+#include "render/DepthFormat.h"
 
 class Graphics {
 public:
@@ -25,6 +26,14 @@ public:
 		CPURDR::Texture2D_RGBA& colorBuffer,
 		uint32_t color);
 
+	template<CPURDR::DepthFormat Format, CPURDR::DepthFunction Function = CPURDR::DepthFunction::Less>
+	static void Triangle(
+		glm::vec3 p0, glm::vec3 p1, glm::vec3 p2,
+		const int& width, const int& height,
+		typename CPURDR::DepthFormatTraits<Format>::TextureType& depthBuffer,
+		CPURDR::Texture2D_RGBA& colorBuffer,
+		uint32_t color);
+
 	// Rasterization
 	static double SignedTriangleArea(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2);
 private:
@@ -0,0 +1,70 @@
+#include "MeshAsset.h"
+
+#include <limits>
+
+namespace CPURDR
+{
+	size_t MeshAsset::GetVertexCount() const
+	{
+		size_t count = 0;
+		for (const auto& mesh: meshes)
+		{
+			count += mesh.GetVertexCount();
+		}
+		return count;
+	}
+
+	size_t MeshAsset::GetTriangleCount() const
+	{
+		size_t count = 0;
+		for (const auto& mesh: meshes)
+		{
+			count += mesh.indices.size() / 3;
+		}
+		return count;
+	}
+
+	MeshAssetHandle CreateMeshAsset(std::vector<Mesh> meshes, std::string source, std::vector<MeshLod> lods,
+		std::shared_ptr<MeshStream> stream)
+	{
+		auto asset = std::make_shared<MeshAsset>();
+		asset->source = std::move(source);
+		asset->meshes = std::move(meshes);
+		asset->lods = std::move(lods);
+		asset->stream = std::move(stream);
+
+		// A streamed asset only has its coarsest level at hand. Its vertices are some of the full detail ones,
+		// which lie within the level's error of its surface
+		size_t boundsLevel = 0;
+		while (boundsLevel + 1 < asset->GetLodCount() && asset->GetLodMeshes(boundsLevel).empty())
+		{
+			boundsLevel++;
+		}
+		const std::vector<Mesh>& boundsMeshes = asset->GetLodMeshes(boundsLevel);
+
+		glm::vec3 boundsMin(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+		for (const Mesh& mesh : boundsMeshes)
+		{
+			for (size_t i = 0; i < mesh.GetVertexCount(); ++i)
+			{
+				const glm::vec3 position = mesh.GetPosition(i);
+				boundsMin = glm::min(boundsMin, position);
+				boundsMax = glm::max(boundsMax, position);
+			}
+		}
+		if (boundsMin.x <= boundsMax.x)
+		{
+			asset->boundsCenter = (boundsMin + boundsMax) * 0.5f;
+			for (const Mesh& mesh : boundsMeshes)
+			{
+				for (size_t i = 0; i < mesh.GetVertexCount(); ++i)
+				{
+					asset->boundsRadius = std::max(asset->boundsRadius, glm::length(mesh.GetPosition(i) - asset->boundsCenter));
+				}
+			}
+			asset->boundsRadius += asset->GetLodError(boundsLevel);
+		}
+		return asset;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Model.h"
+
+namespace CPURDR
+{
+	class MeshStream;
+
+	// A simplified version of every submesh of an asset
+	struct MeshLod
+	{
+		std::vector<Mesh> meshes;
+		// How far the surface may have moved from the full detail meshes, in object space units
+		float error = 0.0f;
+	};
+
+	// The submeshes of one imported file or generated shape. Immutable once created, entities reference it
+	// through a MeshAssetHandle and it is freed with the last reference
+	struct MeshAsset
+	{
+		// File it was imported from, empty for generated meshes
+		std::string source;
+		std::vector<Mesh> meshes;
+		// Coarser levels after the full detail meshes, by increasing error. See MeshSimplifier.h
+		std::vector<MeshLod> lods;
+
+		// Object space bounding sphere of the full detail meshes
+		glm::vec3 boundsCenter = glm::vec3(0.0f);
+		float boundsRadius = 0.0f;
+
+		// Set for assets opened through MeshResidency. Only the coarsest level is kept in lods, the others are
+		// empty here and paged in and out by the stream
+		std::shared_ptr<MeshStream> stream;
+
+		size_t GetVertexCount() const;
+		size_t GetTriangleCount() const;
+
+		// Level 0 is meshes, the full detail
+		size_t GetLodCount() const {return lods.size() + 1;}
+		const std::vector<Mesh>& GetLodMeshes(size_t level) const {return level == 0? meshes : lods[level - 1].meshes;}
+		float GetLodError(size_t level) const {return level == 0? 0.0f : lods[level - 1].error;}
+	};
+
+	using MeshAssetHandle = std::shared_ptr<const MeshAsset>;
+
+	MeshAssetHandle CreateMeshAsset(std::vector<Mesh> meshes, std::string source = {}, std::vector<MeshLod> lods = {},
+		std::shared_ptr<MeshStream> stream = nullptr);
+}
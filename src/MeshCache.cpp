@@ -0,0 +1,427 @@
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "plog/Log.h"
+#include "core/MappedFile.h"
+
+namespace CPURDR
+{
+	static constexpr char MESH_CACHE_MAGIC[4] = {'C', 'P', 'M', 'C'};
+
+	struct MeshCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceSize;
+		int64_t sourceWriteTime;
+		uint32_t importFlags;
+		uint32_t meshCount;
+		uint32_t vertexSize;
+		uint32_t indexSize;
+	};
+
+	struct MeshCacheEntry
+	{
+		uint64_t vertexOffset;
+		uint64_t vertexCount;
+		uint64_t indexOffset;
+		uint64_t indexCount;
+		// 0 for the full detail meshes, entries are sorted by level
+		uint32_t lodLevel;
+		float lodError;
+	};
+
+	static_assert(sizeof(MeshCacheHeader) == 40 && sizeof(MeshCacheEntry) == 40);
+
+	static uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + MESH_CACHE_ALIGNMENT - 1) & ~(uint64_t)(MESH_CACHE_ALIGNMENT - 1);
+	}
+
+	// FNV-1a, stable across runs and standard libraries unlike std::hash
+	static uint64_t HashPath(const std::string& path)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (unsigned char c : path)
+		{
+			hash = (hash ^ c) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	bool GetMeshSourceStamp(const std::string& sourcePath, MeshSourceStamp& stamp)
+	{
+		std::error_code error;
+		const uint64_t size = std::filesystem::file_size(sourcePath, error);
+		if (error) return false;
+		const auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+		if (error) return false;
+
+		stamp.size = size;
+		stamp.writeTime = (int64_t)writeTime.time_since_epoch().count();
+		return true;
+	}
+
+	std::string GetMeshCachePath(const std::string& directory, const std::string& sourcePath)
+	{
+		std::error_code error;
+		std::filesystem::path absolute = std::filesystem::absolute(sourcePath, error);
+		if (error) absolute = sourcePath;
+		absolute = absolute.lexically_normal();
+
+		char hash[17];
+		std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)HashPath(absolute.generic_string()));
+		const std::string name = absolute.filename().string() + "_" + hash + ".cpmesh";
+		return (std::filesystem::path(directory) / name).string();
+	}
+
+	bool WriteMeshCache(const std::string& cachePath, const MeshSourceStamp& stamp, uint32_t importFlags,
+		const std::vector<Mesh>& meshes, const std::vector<MeshLod>& lods)
+	{
+		std::error_code error;
+		const std::filesystem::path path = cachePath;
+		if (path.has_parent_path())
+		{
+			std::filesystem::create_directories(path.parent_path(), error);
+		}
+
+		MeshCacheHeader header = {};
+		std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+		header.version = MESH_CACHE_VERSION;
+		header.sourceSize = stamp.size;
+		header.sourceWriteTime = stamp.writeTime;
+		header.importFlags = importFlags;
+		// Every level flattened into one table
+		std::vector<const Mesh*> allMeshes;
+		std::vector<MeshCacheEntry> entries;
+		for (size_t level = 0; level <= lods.size(); ++level)
+		{
+			for (const Mesh& mesh : level == 0? meshes : lods[level - 1].meshes)
+			{
+				allMeshes.push_back(&mesh);
+				MeshCacheEntry entry = {};
+				entry.lodLevel = (uint32_t)level;
+				entry.lodError = level == 0? 0.0f : lods[level - 1].error;
+				entries.push_back(entry);
+			}
+		}
+
+		header.meshCount = (uint32_t)entries.size();
+		header.vertexSize = sizeof(Vertex);
+		header.indexSize = sizeof(unsigned int);
+
+		uint64_t offset = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry);
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			entries[i].vertexOffset = offset = AlignOffset(offset);
+			entries[i].vertexCount = allMeshes[i]->vertices.size();
+			offset += allMeshes[i]->vertices.size_bytes();
+			entries[i].indexOffset = offset = AlignOffset(offset);
+			entries[i].indexCount = allMeshes[i]->indices.size();
+			offset += allMeshes[i]->indices.size_bytes();
+		}
+
+		// The import thread and a blocking load may cook the same source at once, each writes its own file and
+		// the last rename wins
+		static std::atomic<uint64_t> s_WriteCounter = 0;
+		const std::string temporaryPath = std::format("{}.{:x}.{:x}.{}.tmp", cachePath,
+			std::hash<std::thread::id>()(std::this_thread::get_id()),
+			(uint64_t)std::chrono::system_clock::now().time_since_epoch().count(), s_WriteCounter++);
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				PLOG_WARNING << "Can't write mesh cache " << temporaryPath;
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize)(entries.size() * sizeof(MeshCacheEntry)));
+
+			static constexpr char padding[MESH_CACHE_ALIGNMENT] = {};
+			auto writeBlob = [&file](uint64_t blobOffset, const void* data, size_t bytes)
+			{
+				const uint64_t position = (uint64_t)file.tellp();
+				file.write(padding, (std::streamsize)(blobOffset - position));
+				file.write(static_cast<const char*>(data), (std::streamsize)bytes);
+			};
+			for (size_t i = 0; i < entries.size(); ++i)
+			{
+				writeBlob(entries[i].vertexOffset, allMeshes[i]->vertices.data(), allMeshes[i]->vertices.size_bytes());
+				writeBlob(entries[i].indexOffset, allMeshes[i]->indices.data(), allMeshes[i]->indices.size_bytes());
+			}
+
+			if (!file.good())
+			{
+				PLOG_WARNING << "Failed writing mesh cache " << temporaryPath;
+				file.close();
+				std::filesystem::remove(temporaryPath, error);
+				return false;
+			}
+		}
+
+		// rename() doesn't replace an existing file on every platform
+		std::filesystem::remove(path, error);
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			PLOG_WARNING << "Failed to move mesh cache into place " << cachePath << ": " << error.message();
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		PLOG_INFO << "Wrote mesh cache " << cachePath << " (" << offset / 1024 << " KB)";
+		return true;
+	}
+
+	// Checks everything but the table, which must then lie within fileSize
+	static bool ValidateHeader(const std::string& cachePath, const MeshCacheHeader& header, uint64_t fileSize,
+		const MeshSourceStamp& stamp, uint32_t importFlags)
+	{
+		if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != MESH_CACHE_VERSION ||
+			header.vertexSize != sizeof(Vertex) || header.indexSize != sizeof(unsigned int))
+		{
+			PLOG_INFO << "Mesh cache " << cachePath << " has an old layout, reimporting";
+			return false;
+		}
+		if (header.sourceSize != stamp.size || header.sourceWriteTime != stamp.writeTime || header.importFlags != importFlags)
+		{
+			PLOG_INFO << "Mesh cache " << cachePath << " is stale, reimporting";
+			return false;
+		}
+		if (sizeof(MeshCacheHeader) + (uint64_t)header.meshCount * sizeof(MeshCacheEntry) > fileSize)
+		{
+			PLOG_WARNING << "Mesh cache " << cachePath << " is truncated";
+			return false;
+		}
+		return true;
+	}
+
+	// table holds header.meshCount entries
+	static bool ParseTable(const std::string& cachePath, const MeshCacheHeader& header, const uint8_t* table,
+		uint64_t fileSize, std::vector<MeshCacheLevel>& levels)
+	{
+		const uint64_t tableEnd = sizeof(MeshCacheHeader) + (uint64_t)header.meshCount * sizeof(MeshCacheEntry);
+
+		// A blob must be aligned, lie past the table and end inside the file
+		auto blobFits = [&](uint64_t offset, uint64_t count, uint64_t elementSize)
+		{
+			return offset % MESH_CACHE_ALIGNMENT == 0 && offset >= tableEnd && offset <= fileSize &&
+				count <= (fileSize - offset) / elementSize;
+		};
+
+		std::vector<MeshCacheLevel> result;
+		for (uint32_t i = 0; i < header.meshCount; ++i)
+		{
+			MeshCacheEntry entry;
+			std::memcpy(&entry, table + i * sizeof(MeshCacheEntry), sizeof(entry));
+			// Levels may only continue the current one or start the next, and keep their arrays in file order
+			const bool levelValid = result.empty()? entry.lodLevel == 0 :
+				entry.lodLevel == result.size() - 1 || entry.lodLevel == result.size();
+			const uint64_t previousEnd = result.empty()? tableEnd :
+				result.back().submeshes.back().indexOffset + result.back().submeshes.back().indexCount * sizeof(unsigned int);
+			if (!blobFits(entry.vertexOffset, entry.vertexCount, sizeof(Vertex)) ||
+				!blobFits(entry.indexOffset, entry.indexCount, sizeof(unsigned int)) || entry.indexCount % 3 != 0 || !levelValid ||
+				entry.vertexOffset < previousEnd || entry.indexOffset < entry.vertexOffset + entry.vertexCount * sizeof(Vertex))
+			{
+				PLOG_WARNING << "Mesh cache " << cachePath << " is corrupt, reimporting";
+				return false;
+			}
+
+			if (entry.lodLevel == result.size())
+			{
+				MeshCacheLevel& level = result.emplace_back();
+				level.error = entry.lodError;
+				level.offset = entry.vertexOffset;
+			}
+			MeshCacheLevel& level = result.back();
+			level.submeshes.push_back({entry.vertexOffset, entry.vertexCount, entry.indexOffset, entry.indexCount});
+			level.size = entry.indexOffset + entry.indexCount * sizeof(unsigned int) - level.offset;
+		}
+
+		// Every level covers the same submeshes
+		for (const MeshCacheLevel& level : result)
+		{
+			if (level.submeshes.size() != result.front().submeshes.size())
+			{
+				PLOG_WARNING << "Mesh cache " << cachePath << " is corrupt, reimporting";
+				return false;
+			}
+		}
+
+		levels = std::move(result);
+		return true;
+	}
+
+	// The pipeline trusts index values, one past its submesh's vertices would read out of bounds. The layout checks
+	// don't catch a damaged cache, data starts at file offset dataOffset
+	static bool ValidateIndices(const std::string& cachePath, const MeshCacheLevel& level, const uint8_t* data,
+		uint64_t dataOffset)
+	{
+		for (const MeshCacheLevel::Submesh& submesh : level.submeshes)
+		{
+			const unsigned int* indices = reinterpret_cast<const unsigned int*>(data + (submesh.indexOffset - dataOffset));
+			if (std::any_of(indices, indices + submesh.indexCount, [&submesh](unsigned int index) {return index >= submesh.vertexCount;}))
+			{
+				PLOG_WARNING << "Mesh cache " << cachePath << " is corrupt, reimporting";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Views the arrays of level in data, which starts at file offset dataOffset
+	static void ViewLevel(const MeshCacheLevel& level, const uint8_t* data, uint64_t dataOffset,
+		const std::shared_ptr<const void>& storage, std::vector<Mesh>& meshes)
+	{
+		meshes.clear();
+		meshes.reserve(level.submeshes.size());
+		for (const MeshCacheLevel::Submesh& submesh : level.submeshes)
+		{
+			meshes.emplace_back(
+				std::span<const Vertex>(reinterpret_cast<const Vertex*>(data + (submesh.vertexOffset - dataOffset)), (size_t)submesh.vertexCount),
+				std::span<const unsigned int>(reinterpret_cast<const unsigned int*>(data + (submesh.indexOffset - dataOffset)), (size_t)submesh.indexCount),
+				storage);
+		}
+	}
+
+	bool ReadMeshCache(const std::string& cachePath, const MeshSourceStamp& stamp, uint32_t importFlags,
+		std::vector<Mesh>& meshes, std::vector<MeshLod>& lods)
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(cachePath, error))
+		{
+			return false;
+		}
+
+		auto file = std::make_shared<MappedFile>();
+		if (!file->Open(cachePath))
+		{
+			return false;
+		}
+
+		const uint8_t* data = file->GetData();
+		const uint64_t fileSize = file->GetSize();
+		if (fileSize < sizeof(MeshCacheHeader))
+		{
+			PLOG_WARNING << "Mesh cache " << cachePath << " is truncated";
+			return false;
+		}
+
+		MeshCacheHeader header;
+		std::memcpy(&header, data, sizeof(header));
+		std::vector<MeshCacheLevel> levels;
+		if (!ValidateHeader(cachePath, header, fileSize, stamp, importFlags) ||
+			!ParseTable(cachePath, header, data + sizeof(MeshCacheHeader), fileSize, levels))
+		{
+			return false;
+		}
+
+		for (const MeshCacheLevel& level : levels)
+		{
+			if (!ValidateIndices(cachePath, level, data, 0))
+			{
+				return false;
+			}
+		}
+
+		std::vector<Mesh> result;
+		std::vector<MeshLod> resultLods(levels.empty()? 0 : levels.size() - 1);
+		const std::shared_ptr<const void> storage = file;
+		for (size_t level = 0; level < levels.size(); ++level)
+		{
+			ViewLevel(levels[level], data, 0, storage, level == 0? result : resultLods[level - 1].meshes);
+			if (level > 0) resultLods[level - 1].error = levels[level].error;
+		}
+
+		meshes = std::move(result);
+		lods = std::move(resultLods);
+		return true;
+	}
+
+	bool ReadMeshCacheTable(const std::string& cachePath, const MeshSourceStamp& stamp, uint32_t importFlags,
+		std::vector<MeshCacheLevel>& levels)
+	{
+		std::error_code error;
+		const uint64_t fileSize = std::filesystem::file_size(cachePath, error);
+		if (error)
+		{
+			return false;
+		}
+
+		std::ifstream file(cachePath, std::ios::binary);
+		MeshCacheHeader header;
+		if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		{
+			PLOG_WARNING << "Mesh cache " << cachePath << " is truncated";
+			return false;
+		}
+		if (!ValidateHeader(cachePath, header, fileSize, stamp, importFlags))
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> table((size_t)header.meshCount * sizeof(MeshCacheEntry));
+		if (!file.read(reinterpret_cast<char*>(table.data()), (std::streamsize)table.size()))
+		{
+			PLOG_WARNING << "Mesh cache " << cachePath << " is truncated";
+			return false;
+		}
+		return ParseTable(cachePath, header, table.data(), fileSize, levels);
+	}
+
+	bool ReadMeshCacheLevel(const std::string& cachePath, const MeshCacheLevel& level, std::vector<Mesh>& meshes)
+	{
+		// The table was read earlier, the file may have been rewritten or damaged since
+		std::error_code error;
+		const uint64_t fileSize = std::filesystem::file_size(cachePath, error);
+		if (error || level.offset > fileSize || level.size > fileSize - level.offset)
+		{
+			PLOG_WARNING << "Mesh cache " << cachePath << " is truncated";
+			return false;
+		}
+		auto arrayFits = [&level](uint64_t offset, uint64_t count, uint64_t elementSize)
+		{
+			return offset >= level.offset && offset - level.offset <= level.size &&
+				count <= (level.size - (offset - level.offset)) / elementSize;
+		};
+		for (const MeshCacheLevel::Submesh& submesh : level.submeshes)
+		{
+			if (!arrayFits(submesh.vertexOffset, submesh.vertexCount, sizeof(Vertex)) ||
+				!arrayFits(submesh.indexOffset, submesh.indexCount, sizeof(unsigned int)))
+			{
+				PLOG_WARNING << "Mesh cache " << cachePath << " is corrupt";
+				return false;
+			}
+		}
+
+		std::ifstream file(cachePath, std::ios::binary);
+		// Not value initialized, every byte is read over
+		std::shared_ptr<uint8_t[]> data(new uint8_t[level.size]);
+		if (!file.is_open() || !file.seekg((std::streamoff)level.offset) ||
+			!file.read(reinterpret_cast<char*>(data.get()), (std::streamsize)level.size))
+		{
+			PLOG_WARNING << "Failed reading " << level.size << " bytes at " << level.offset << " from mesh cache " << cachePath;
+			return false;
+		}
+
+		if (!ValidateIndices(cachePath, level, data.get(), level.offset))
+		{
+			return false;
+		}
+		ViewLevel(level, data.get(), level.offset, data, meshes);
+		return true;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshAsset.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Mesh Cache
+	// ===============
+	// Cooked meshes of one source asset: a header, a table of submeshes of every LOD level, then the vertex and
+	// index arrays of every submesh, each aligned to MESH_CACHE_ALIGNMENT. Arrays are stored exactly as Vertex and
+	// unsigned int lay out in memory(little-endian), so reading maps the file and points Mesh at it
+	constexpr uint32_t MESH_CACHE_VERSION = 2;
+	constexpr size_t MESH_CACHE_ALIGNMENT = 64;
+
+	// The source asset a cache was cooked from, the cache is stale once either value changes
+	struct MeshSourceStamp
+	{
+		uint64_t size = 0;
+		int64_t writeTime = 0;
+
+		bool operator==(const MeshSourceStamp& other) const = default;
+	};
+
+	bool GetMeshSourceStamp(const std::string& sourcePath, MeshSourceStamp& stamp);
+
+	// <directory>/<source file name>_<hash of its absolute path>.cpmesh
+	std::string GetMeshCachePath(const std::string& directory, const std::string& sourcePath);
+
+	// Written to a temporary file and renamed, so a reader never sees a partial cache
+	bool WriteMeshCache(const std::string& cachePath, const MeshSourceStamp& stamp, uint32_t importFlags,
+		const std::vector<Mesh>& meshes, const std::vector<MeshLod>& lods);
+
+	// Fails without logging an error when the cache is missing or stale, so the caller can import instead.
+	// The meshes view the mapped file, it stays mapped while any of them is alive.
+	// The layout and every index value are validated, a damaged cache is reimported like a stale one
+	bool ReadMeshCache(const std::string& cachePath, const MeshSourceStamp& stamp, uint32_t importFlags,
+		std::vector<Mesh>& meshes, std::vector<MeshLod>& lods);
+
+	// Where the arrays of one level lie in a cache file, level 0 is the full detail meshes
+	struct MeshCacheLevel
+	{
+		struct Submesh
+		{
+			uint64_t vertexOffset;
+			uint64_t vertexCount;
+			uint64_t indexOffset;
+			uint64_t indexCount;
+		};
+
+		std::vector<Submesh> submeshes;
+		float error = 0.0f;
+		// The file range holding every array of the level, they are written contiguously
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	// Validates the cache like ReadMeshCache() but only reads its header and table, for reading levels one at a time
+	bool ReadMeshCacheTable(const std::string& cachePath, const MeshSourceStamp& stamp, uint32_t importFlags,
+		std::vector<MeshCacheLevel>& levels);
+
+	// Reads the arrays of one level of the table into memory the meshes share. Touches no shared state.
+	// Fails when an array lies outside the level or the file, or an index is past its submesh's vertices
+	bool ReadMeshCacheLevel(const std::string& cachePath, const MeshCacheLevel& level, std::vector<Mesh>& meshes);
+}
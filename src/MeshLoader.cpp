@@ -2,11 +2,32 @@
 
 #include "assimp/postprocess.h"
 #include "plog/Log.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Primitives.h"
+#include "VertexQuantization.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
 
 namespace CPURDR
 {
 	MeshLoader* MeshLoader::s_Instance = nullptr;
 
+	// Part of the cache key, a change invalidates every cooked mesh
+	static constexpr uint32_t IMPORT_FLAGS =
+		aiProcess_Triangulate |
+		aiProcess_GenNormals |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_OptimizeMeshes;
+
+	// Cooked into the cache along with IMPORT_FLAGS
+	static constexpr uint32_t COOK_OPTIMIZED = 1u << 31;
+	static constexpr uint32_t COOK_LODS = 1u << 30;
+	static_assert((IMPORT_FLAGS & (COOK_OPTIMIZED | COOK_LODS)) == 0);
+
+	static constexpr size_t VERTEX_CHUNK_SIZE = 16384;
+
 	MeshLoader& MeshLoader::GetInstance()
 	{
 		if (s_Instance == nullptr)
@@ -16,134 +37,363 @@ namespace CPURDR
 		return *s_Instance;
 	}
 
-	std::vector<Mesh> MeshLoader::LoadMeshFromFile(const std::string& filepath)
+	static Mesh ConvertMesh(const aiMesh* aiMeshPtr, const MeshImportSettings& settings, uint32_t colorSeed)
 	{
-		auto it = m_MeshCache.find(filepath);
-		if (it != m_MeshCache.end())
+		std::vector<Vertex> vertices(aiMeshPtr->mNumVertices);
+		ThreadPool::GetImportInstance().ParallelFor(0, vertices.size(), VERTEX_CHUNK_SIZE,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t v = begin; v < end; v++)
+				{
+					Vertex& vertex = vertices[v];
+
+					vertex.position = glm::vec3(
+						aiMeshPtr->mVertices[v].x,
+						aiMeshPtr->mVertices[v].y,
+						aiMeshPtr->mVertices[v].z
+					);
+
+					if (aiMeshPtr->HasNormals())
+					{
+						vertex.normal = glm::vec3(
+							aiMeshPtr->mNormals[v].x,
+							aiMeshPtr->mNormals[v].y,
+							aiMeshPtr->mNormals[v].z
+						);
+					}
+					else
+					{
+						vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+					}
+
+					if (aiMeshPtr->HasTextureCoords(0))
+					{
+						vertex.texcoord = glm::vec2(
+							aiMeshPtr->mTextureCoords[0][v].x,
+							aiMeshPtr->mTextureCoords[0][v].y
+						);
+					}
+					else
+					{
+						vertex.texcoord = glm::vec2(0.0f, 1.0f);
+					}
+				}
+			});
+
+		std::vector<unsigned int> indices;
+		indices.reserve(aiMeshPtr->mNumFaces * 3);
+
+		for (unsigned int f = 0; f < aiMeshPtr->mNumFaces; f++)
 		{
-			PLOG_DEBUG << "Mesh loaded from cache: " << filepath;
-			return it->second;
+			const aiFace& face = aiMeshPtr->mFaces[f];
+			for (unsigned int j = 0; j < face.mNumIndices; j++)
+			{
+				indices.push_back(face.mIndices[j]);
+			}
+		}
+
+		if (settings.optimize)
+		{
+			const float acmrBefore = AnalyzeVertexCache(indices, vertices.size());
+			OptimizeMesh(vertices, indices);
+			PLOG_DEBUG << "Optimized " << indices.size() / 3 << " triangles, ACMR " << acmrBefore << " -> "
+				<< AnalyzeVertexCache(indices, vertices.size());
+		}
+
+		std::mt19937 rng(colorSeed);
+		std::uniform_int_distribution<int> dist(0, 255);
+		std::vector<SDL_Color> colors;
+		colors.reserve(indices.size() / 3);
+		for (unsigned int i = 0; i < indices.size(); i += 3)
+		{
+			SDL_Color c = {
+				static_cast<uint8_t>(dist(rng)),
+				static_cast<uint8_t>(dist(rng)),
+				static_cast<uint8_t>(dist(rng)),
+				255
+			};
+			colors.push_back(c);
+		}
+
+		return Mesh(std::move(vertices), std::move(indices), colors);
+	}
+
+	static bool ReadOrImportMeshes(const std::string& filepath, const std::string& cacheDirectory,
+		const MeshImportSettings& settings, uint32_t colorSeed, std::vector<Mesh>& meshes, std::vector<MeshLod>& lods)
+	{
+		const uint32_t cookFlags = IMPORT_FLAGS | (settings.optimize? COOK_OPTIMIZED : 0) | (settings.generateLods? COOK_LODS : 0);
+
+		MeshSourceStamp stamp;
+		const bool cacheable = !cacheDirectory.empty() && GetMeshSourceStamp(filepath, stamp);
+		const std::string cachePath = cacheable? GetMeshCachePath(cacheDirectory, filepath) : std::string();
+		if (cacheable && ReadMeshCache(cachePath, stamp, cookFlags, meshes, lods))
+		{
+			PLOG_DEBUG << "Mesh mapped from " << cachePath;
+			return true;
 		}
 
 		Assimp::Importer importer;
-		const aiScene* pScene = importer.ReadFile(
-			filepath.c_str(),
-			aiProcess_Triangulate |
-			aiProcess_GenNormals |
-			aiProcess_JoinIdenticalVertices |
-			aiProcess_OptimizeMeshes
-		);
+		const aiScene* pScene = importer.ReadFile(filepath.c_str(), IMPORT_FLAGS);
 
 		if (pScene == nullptr)
 		{
 			PLOG_ERROR << "Failed to load mesh from file: " << filepath << " - " << importer.GetErrorString();
-			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", ("Error loading model: " + filepath).c_str(), nullptr);
-			return std::vector<Mesh>();
+			return false;
 		}
 
 		if (pScene->mNumMeshes == 0)
 		{
 			PLOG_WARNING << "No meshes found in file: " << filepath;
-			return std::vector<Mesh>();
+			return false;
 		}
 
-		std::vector<Mesh> meshes;
-		meshes.reserve(pScene->mNumMeshes);
+		// Submeshes convert in parallel, each with its own color sequence so the result doesn't depend on scheduling
+		meshes.assign(pScene->mNumMeshes, Mesh({}, {}));
+		ThreadPool::GetImportInstance().ParallelFor(0, meshes.size(), 1,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					meshes[i] = ConvertMesh(pScene->mMeshes[i], settings, colorSeed + (uint32_t)i);
+				}
+			});
+		PLOG_DEBUG << "Loaded " << meshes.size() << " submeshes from " << filepath;
 
-		for (unsigned int i = 0; i < pScene->mNumMeshes; i++)
+		lods.clear();
+		if (settings.generateLods)
 		{
-			const aiMesh* aiMeshPtr = pScene->mMeshes[i];
+			lods = GenerateLods(meshes, settings.optimize);
+			for (size_t level = 0; level < lods.size(); ++level)
+			{
+				size_t triangles = 0;
+				for (const Mesh& mesh : lods[level].meshes) triangles += mesh.indices.size() / 3;
+				PLOG_DEBUG << "LOD " << level + 1 << ": " << triangles << " triangles, error " << lods[level].error;
+			}
+		}
 
-			std::vector<Vertex> vertices;
-			vertices.reserve(aiMeshPtr->mNumVertices);
+		if (cacheable)
+		{
+			WriteMeshCache(cachePath, stamp, cookFlags, meshes, lods);
+		}
+		return true;
+	}
 
-			for (unsigned int v = 0; v < aiMeshPtr->mNumVertices; v++)
-			{
-				Vertex vertex;
+	// Touches no loader state, runs on the calling thread or the import thread
+	static bool ImportMeshes(const std::string& filepath, const std::string& cacheDirectory,
+		const MeshImportSettings& settings, uint32_t colorSeed, bool quantize, std::vector<Mesh>& meshes,
+		std::vector<MeshLod>& lods)
+	{
+		PROFILE_SCOPE("ImportMeshes");
+		if (!ReadOrImportMeshes(filepath, cacheDirectory, settings, colorSeed, meshes, lods)) return false;
 
-				vertex.position = glm::vec3(
-					aiMeshPtr->mVertices[v].x,
-					aiMeshPtr->mVertices[v].y,
-					aiMeshPtr->mVertices[v].z
-				);
+		std::vector<Mesh*> allMeshes;
+		for (Mesh& mesh : meshes) allMeshes.push_back(&mesh);
+		for (MeshLod& lod : lods)
+		{
+			for (Mesh& mesh : lod.meshes) allMeshes.push_back(&mesh);
+		}
+		MeshLoader::PrepareMeshes(allMeshes, settings, quantize);
+		return true;
+	}
 
-				if (aiMeshPtr->HasNormals())
-				{
-					vertex.normal = glm::vec3(
-						aiMeshPtr->mNormals[v].x,
-						aiMeshPtr->mNormals[v].y,
-						aiMeshPtr->mNormals[v].z
-					);
-				}
-				else
-				{
-					vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
-				}
+	void MeshLoader::PrepareMeshes(std::span<Mesh* const> meshes, const MeshImportSettings& settings, bool quantize)
+	{
+		if (!quantize && !settings.buildMeshlets) return;
 
-				if (aiMeshPtr->HasTextureCoords(0))
-				{
-					vertex.texcoord = glm::vec2(
-						aiMeshPtr->mTextureCoords[0][v].x,
-						aiMeshPtr->mTextureCoords[0][v].y
-					);
-				}
-				else
+		ThreadPool::GetImportInstance().ParallelFor(0, meshes.size(), 1,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
 				{
-					vertex.texcoord = glm::vec2(0.0f, 1.0f);
+					Mesh& mesh = *meshes[i];
+					if (quantize) mesh = QuantizeMesh(mesh);
+					// After quantizing so the bounds hold the decoded positions
+					if (settings.buildMeshlets) mesh.meshlets = BuildMeshlets(mesh);
 				}
+			});
+	}
 
-				vertices.push_back(vertex);
-			}
+	MeshAssetHandle MeshLoader::LoadMeshFromFile(const std::string& filepath, const MeshImportSettings& settings)
+	{
+		if (MeshAssetHandle loaded = GetMesh(filepath))
+		{
+			PLOG_DEBUG << "Mesh loaded from cache: " << filepath;
+			return loaded;
+		}
+
+		std::vector<Mesh> meshes;
+		std::vector<MeshLod> lods;
+		if (!ImportMeshes(filepath, m_CacheDirectory, settings, (uint32_t)m_Rng(), m_QuantizeVertices, meshes, lods))
+		{
+			return nullptr;
+		}
+
+		MeshAssetHandle asset = CreateMeshAsset(std::move(meshes), filepath, std::move(lods));
+		m_MeshCache[filepath] = asset;
+		return asset;
+	}
 
-			std::vector<unsigned int> indices;
-			indices.reserve(aiMeshPtr->mNumFaces * 3);
+	bool MeshLoader::CookMesh(const std::string& filepath, const MeshImportSettings& settings, std::string& cachePath,
+		std::vector<MeshCacheLevel>& levels)
+	{
+		MeshSourceStamp stamp;
+		if (m_CacheDirectory.empty() || !GetMeshSourceStamp(filepath, stamp))
+		{
+			PLOG_ERROR << "Can't cook " << filepath << ", it needs to exist and a mesh cache directory";
+			return false;
+		}
+
+		const uint32_t cookFlags = IMPORT_FLAGS | (settings.optimize? COOK_OPTIMIZED : 0) | (settings.generateLods? COOK_LODS : 0);
+		cachePath = GetMeshCachePath(m_CacheDirectory, filepath);
+		if (ReadMeshCacheTable(cachePath, stamp, cookFlags, levels))
+		{
+			return true;
+		}
+
+		// The imported meshes are dropped once written
+		PROFILE_SCOPE("CookMesh");
+		std::vector<Mesh> meshes;
+		std::vector<MeshLod> lods;
+		if (!ReadOrImportMeshes(filepath, m_CacheDirectory, settings, (uint32_t)m_Rng(), meshes, lods))
+		{
+			return false;
+		}
+		meshes.clear();
+		lods.clear();
+		if (!ReadMeshCacheTable(cachePath, stamp, cookFlags, levels))
+		{
+			PLOG_ERROR << "Cooked " << filepath << " but can't read back " << cachePath;
+			return false;
+		}
+		return true;
+	}
+
+	void MeshLoader::LoadMeshAsync(const std::string& filepath, MeshLoadCallback callback, const MeshImportSettings& settings)
+	{
+		if (MeshAssetHandle loaded = GetMesh(filepath))
+		{
+			callback(std::move(loaded));
+			return;
+		}
+
+		// A path already in flight only gains another callback
+		auto [it, inserted] = m_PendingLoads.try_emplace(filepath);
+		it->second.push_back(std::move(callback));
+		if (!inserted) return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_ImportMutex);
+			if (!m_ImportThread.joinable())
+			{
+				m_ImportStopping = false;
+				m_ImportThread = std::thread([this]() {ImportLoop();});
+			}
+			m_ImportQueue.push_back({filepath, m_CacheDirectory, settings, (uint32_t)m_Rng(), m_QuantizeVertices});
+		}
+		m_ImportCondition.notify_one();
+		PLOG_INFO << "Queued mesh import: " << filepath;
+	}
 
-			for (unsigned int f = 0; f < aiMeshPtr->mNumFaces; f++)
+	void MeshLoader::ImportLoop()
+	{
+		Profiler::GetInstance().SetThreadName("Mesh Import");
+		while (true)
+		{
+			ImportRequest request;
 			{
-				const aiFace& face = aiMeshPtr->mFaces[f];
-				for (unsigned int j = 0; j < face.mNumIndices; j++)
+				std::unique_lock<std::mutex> lock(m_ImportMutex);
+				m_ImportCondition.wait(lock, [this]() {return m_ImportStopping || !m_ImportQueue.empty();});
+				if (m_ImportStopping)
 				{
-					indices.push_back(face.mIndices[j]);
+					return;
 				}
+				request = std::move(m_ImportQueue.front());
+				m_ImportQueue.pop_front();
 			}
 
-			std::vector<SDL_Color> colors;
-			colors.reserve(indices.size() / 3);
-			for (unsigned int i = 0; i < indices.size(); i += 3)
+			ImportResult result;
+			result.filepath = request.filepath;
+			result.success = ImportMeshes(request.filepath, request.cacheDirectory, request.settings,
+				request.colorSeed, request.quantize, result.meshes, result.lods);
+
+			std::lock_guard<std::mutex> lock(m_ImportMutex);
+			m_CompletedImports.push_back(std::move(result));
+		}
+	}
+
+	std::vector<std::string> MeshLoader::ProcessCompletedLoads()
+	{
+		std::vector<ImportResult> completed;
+		{
+			std::lock_guard<std::mutex> lock(m_ImportMutex);
+			completed.swap(m_CompletedImports);
+		}
+
+		std::vector<std::string> failed;
+
+		for (ImportResult& result : completed)
+		{
+			MeshAssetHandle asset;
+			if (result.success)
 			{
-				SDL_Color c = {
-					static_cast<uint8_t>(m_Dist(m_Rng)),
-					static_cast<uint8_t>(m_Dist(m_Rng)),
-					static_cast<uint8_t>(m_Dist(m_Rng)),
-					255
-				};
-				colors.push_back(c);
+				asset = CreateMeshAsset(std::move(result.meshes), result.filepath, std::move(result.lods));
+				m_MeshCache[result.filepath] = asset;
+			}
+			else
+			{
+				failed.push_back(result.filepath);
 			}
 
-			meshes.emplace_back(vertices, indices, colors);
+			auto pending = m_PendingLoads.extract(result.filepath);
+			if (pending.empty()) continue;
+			for (MeshLoadCallback& callback : pending.mapped())
+			{
+				callback(asset);
+			}
+		}
+		return failed;
+	}
+
+	MeshAssetHandle MeshLoader::GetPlaceholderAsset()
+	{
+		if (!m_PlaceholderAsset)
+		{
+			m_PlaceholderAsset = CreateMeshAsset({Primitives::Cube(0.25f)});
+		}
+		return m_PlaceholderAsset;
+	}
 
-			PLOG_DEBUG << "Loaded submesh " << i << " from " << filepath;
+	void MeshLoader::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_ImportMutex);
+			m_ImportStopping = true;
+			m_ImportQueue.clear();
+		}
+		m_ImportCondition.notify_all();
+		if (m_ImportThread.joinable())
+		{
+			m_ImportThread.join();
 		}
 
-		m_MeshCache[filepath] = meshes;
-		return meshes;
+		m_CompletedImports.clear();
+		m_PendingLoads.clear();
 	}
 
 	bool MeshLoader::IsMeshLoaded(const std::string& filepath) const
 	{
-		return m_MeshCache.find(filepath) != m_MeshCache.end();
+		return GetMesh(filepath) != nullptr;
 	}
 
-	const std::vector<Mesh>* MeshLoader::GetMesh(const std::string& filepath) const
+	MeshAssetHandle MeshLoader::GetMesh(const std::string& filepath) const
 	{
 		auto it = m_MeshCache.find(filepath);
-		return (it != m_MeshCache.end()) ? &it->second : nullptr;
+		return (it != m_MeshCache.end()) ? it->second.lock() : nullptr;
 	}
 
 	void MeshLoader::ClearCache()
 	{
-		size_t count = m_MeshCache.size();
-		m_MeshCache.clear();
+		size_t count = std::erase_if(m_MeshCache, [](const auto& entry) {return entry.second.expired();});
 		PLOG_DEBUG << "Cleared mesh cache (" << count << " meshes)";
 	}
 
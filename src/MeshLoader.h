@@ -1,26 +1,86 @@
 #pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
-#include "Model.h"
+#include "MeshAsset.h"
+#include "MeshCache.h"
 
 namespace CPURDR
 {
+	// Import-time processing of one asset, used when the asset is not loaded yet
+	struct MeshImportSettings
+	{
+		// Reorders triangles for the post-transform cache and overdraw and vertices for fetch locality, see MeshOptimizer.h
+		bool optimize = true;
+		// Splits every mesh into meshlets RenderPipeline can cull, see Meshlet.h. Not cooked, rebuilt on every load
+		bool buildMeshlets = true;
+		// Cooks a chain of simplified levels for RenderPipeline to pick from by screen size, see MeshSimplifier.h
+		bool generateLods = true;
+	};
+
+	// Receives the imported asset, nullptr if the import failed
+	using MeshLoadCallback = std::function<void(MeshAssetHandle)>;
+
 	class MeshLoader
 	{
 	public:
 		static MeshLoader& GetInstance();
 
-		std::vector<Mesh> LoadMeshFromFile(const std::string& filepath);
+		// Every load of a path returns the same asset while any handle to it is alive. Logs and returns nullptr on
+		// failure, telling the user is up to the caller
+		MeshAssetHandle LoadMeshFromFile(const std::string& filepath, const MeshImportSettings& settings = {});
+
+		// Parses on a background thread and converts submeshes on the thread pool. The callback runs on the
+		// thread calling ProcessCompletedLoads(), or right away if the asset is already loaded
+		void LoadMeshAsync(const std::string& filepath, MeshLoadCallback callback, const MeshImportSettings& settings = {});
+
+		// Hands finished async imports to their callbacks, call once per frame while the scene may be modified.
+		// Returns the paths that failed to load, for the caller to report
+		std::vector<std::string> ProcessCompletedLoads();
+
+		// Paths requested through LoadMeshAsync() whose callbacks have not run yet
+		size_t GetPendingLoadCount() const {return m_PendingLoads.size();}
+
+		// Stand-in shown by entities whose mesh is still importing
+		MeshAssetHandle GetPlaceholderAsset();
+
+		// Waits for the import in progress and drops the queued ones along with their callbacks
+		void Shutdown();
 
 		bool IsMeshLoaded(const std::string& filepath) const;
 
-		const std::vector<Mesh>* GetMesh(const std::string& filepath) const;
+		MeshAssetHandle GetMesh(const std::string& filepath) const;
 
+		// Forgets expired entries, live assets stay with their owners
 		void ClearCache();
 
+		// Imported meshes are cooked into this directory and mapped from there on later loads, empty disables it
+		void SetCacheDirectory(const std::string& directory) {m_CacheDirectory = directory;}
+		const std::string& GetCacheDirectory() const {return m_CacheDirectory;}
+
+		// Imports filepath into the mesh cache unless it is cooked there already, then reads back only the cache's
+		// table for MeshResidency. Fails without a cache directory
+		bool CookMesh(const std::string& filepath, const MeshImportSettings& settings, std::string& cachePath,
+			std::vector<MeshCacheLevel>& levels);
+
+		// What every load does to cooked meshes: quantizes them if asked and builds their meshlets. Touches no loader state,
+		// spreads over the import pool like the rest of the import
+		static void PrepareMeshes(std::span<Mesh* const> meshes, const MeshImportSettings& settings, bool quantize);
+
+		// Later imports keep their vertices in the 16-byte QuantizedVertex layout, the mesh cache stays full precision
+		void SetQuantizeVertices(bool quantize) {m_QuantizeVertices = quantize;}
+		bool GetQuantizeVertices() const {return m_QuantizeVertices;}
+
 	private:
-		MeshLoader(): m_Rng(std::random_device()()), m_Dist(0, 255){};
+		MeshLoader(): m_Rng(std::random_device()()){};
 		~MeshLoader() = default;
 
 		MeshLoader(const MeshLoader&) = delete;
@@ -28,13 +88,48 @@ namespace CPURDR
 		MeshLoader(MeshLoader&&) = delete;
 		MeshLoader& operator=(MeshLoader&&) = delete;
 
-		std::unordered_map<std::string, std::vector<Mesh>> m_MeshCache;
+		struct ImportRequest
+		{
+			std::string filepath;
+			std::string cacheDirectory;
+			MeshImportSettings settings;
+			uint32_t colorSeed = 0;
+			bool quantize = false;
+		};
+
+		struct ImportResult
+		{
+			std::string filepath;
+			std::vector<Mesh> meshes;
+			std::vector<MeshLod> lods;
+			bool success = false;
+		};
+
+		void ImportLoop();
+
+		// Weak so an asset is freed once no entity uses it
+		std::unordered_map<std::string, std::weak_ptr<const MeshAsset>> m_MeshCache;
+		std::string m_CacheDirectory = "cache/meshes";
+		MeshAssetHandle m_PlaceholderAsset;
+		bool m_QuantizeVertices = false;
+
+		// Callbacks waiting on each requested path, main thread only
+		std::unordered_map<std::string, std::vector<MeshLoadCallback>> m_PendingLoads;
+
+		// Shared with the import thread
+		std::thread m_ImportThread;
+		std::mutex m_ImportMutex;
+		std::condition_variable m_ImportCondition;
+		std::deque<ImportRequest> m_ImportQueue;
+		std::vector<ImportResult> m_CompletedImports;
+		bool m_ImportStopping = false;
+
 		static  MeshLoader* s_Instance;
 
 		// ==========================
 		// For visualization only
 		// ==========================
+		// Seeds the per-triangle colors of each import
 		std::mt19937 m_Rng;
-		std::uniform_int_distribution<int> m_Dist;
 	};
 }
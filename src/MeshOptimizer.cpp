@@ -0,0 +1,292 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+
+namespace CPURDR
+{
+	static constexpr uint32_t UNASSIGNED = 0xFFFFFFFF;
+
+	// Tracks the cache with insertion timestamps: a vertex is cached while fewer than cacheSize misses
+	// happened since it was inserted. Advancing the time by cacheSize + 1 empties the cache
+	struct FifoCacheModel
+	{
+		std::vector<uint32_t> insertTime;
+		uint32_t time;
+		uint32_t cacheSize;
+
+		FifoCacheModel(size_t vertexCount, uint32_t cacheSize):
+			insertTime(vertexCount, 0), time(cacheSize + 1), cacheSize(cacheSize) {}
+
+		bool IsCached(uint32_t vertex) const {return time - insertTime[vertex] <= cacheSize;}
+
+		// Returns 1 on a miss
+		uint32_t Access(uint32_t vertex)
+		{
+			if (IsCached(vertex)) return 0;
+			insertTime[vertex] = time++;
+			return 1;
+		}
+
+		void Clear() {time += cacheSize + 1;}
+	};
+
+	static bool IndicesInRange(std::span<const unsigned int> indices, size_t vertexCount)
+	{
+		return std::all_of(indices.begin(), indices.end(), [vertexCount](unsigned int index) {return index < vertexCount;});
+	}
+
+	float AnalyzeVertexCache(std::span<const unsigned int> indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || !IndicesInRange(indices, vertexCount)) return 0.0f;
+
+		FifoCacheModel cache(vertexCount, cacheSize);
+		uint64_t misses = 0;
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			misses += cache.Access(indices[i]);
+		}
+		return (float)misses / (float)triangleCount;
+	}
+
+	std::vector<uint32_t> OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) return {};
+		if (!IndicesInRange(indices, vertexCount)) return {0};
+
+		// Triangles around each vertex, in compressed rows
+		std::vector<uint32_t> offsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			offsets[indices[i] + 1]++;
+		}
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+		{
+			adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+		}
+
+		std::vector<uint32_t> liveTriangles(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			liveTriangles[v] = offsets[v + 1] - offsets[v];
+		}
+
+		FifoCacheModel cache(vertexCount, cacheSize);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		std::vector<unsigned int> output;
+		deadEnds.reserve(triangleCount * 3);
+		output.reserve(triangleCount * 3);
+
+		std::vector<uint32_t> clusters = {0};
+		size_t cursor = 0;
+		uint32_t fan = indices[0];
+		while (fan != UNASSIGNED)
+		{
+			// Emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (uint32_t k = offsets[fan]; k < offsets[fan + 1]; ++k)
+			{
+				const uint32_t triangle = adjacency[k];
+				if (emitted[triangle]) continue;
+				emitted[triangle] = true;
+
+				for (int j = 0; j < 3; ++j)
+				{
+					const uint32_t vertex = indices[triangle * 3 + j];
+					output.push_back(vertex);
+					deadEnds.push_back(vertex);
+					candidates.push_back(vertex);
+					liveTriangles[vertex]--;
+					cache.Access(vertex);
+				}
+			}
+
+			// Next fan around the candidate that stays cached longest, if its remaining triangles still fit
+			uint32_t next = UNASSIGNED;
+			int64_t bestPriority = -1;
+			for (uint32_t vertex : candidates)
+			{
+				if (liveTriangles[vertex] == 0) continue;
+
+				const uint32_t age = cache.time - cache.insertTime[vertex];
+				const int64_t priority = age + 2 * liveTriangles[vertex] <= cacheSize? age : 0;
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = vertex;
+				}
+			}
+
+			// Dead end: back up to a recently emitted vertex, or else jump to the next unfinished one in input order
+			while (next == UNASSIGNED && !deadEnds.empty())
+			{
+				const uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[vertex] > 0) next = vertex;
+			}
+			if (next == UNASSIGNED)
+			{
+				while (cursor < vertexCount && liveTriangles[cursor] == 0) cursor++;
+				if (cursor < vertexCount)
+				{
+					next = (uint32_t)cursor;
+					clusters.push_back((uint32_t)(output.size() / 3));
+				}
+			}
+			fan = next;
+		}
+
+		indices.swap(output);
+		return clusters;
+	}
+
+	void OptimizeOverdraw(std::vector<unsigned int>& indices, std::span<const Vertex> vertices,
+		const std::vector<uint32_t>& clusters, float threshold, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0 || clusters.empty() || !IndicesInRange(indices, vertices.size())) return;
+
+		// Soft boundaries: cut a cluster wherever the part since the last cut is already nearly as cache
+		// efficient as the whole cluster, measuring every part with an empty cache
+		FifoCacheModel cache(vertices.size(), cacheSize);
+		auto triangleMisses = [&](size_t triangle)
+		{
+			return cache.Access(indices[triangle * 3]) + cache.Access(indices[triangle * 3 + 1]) +
+				cache.Access(indices[triangle * 3 + 2]);
+		};
+
+		std::vector<uint32_t> pieces;
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			const size_t start = clusters[c];
+			const size_t end = c + 1 < clusters.size()? clusters[c + 1] : triangleCount;
+
+			cache.Clear();
+			uint32_t clusterMisses = 0;
+			for (size_t t = start; t < end; ++t)
+			{
+				clusterMisses += triangleMisses(t);
+			}
+			const float missLimit = threshold * (float)clusterMisses / (float)(end - start);
+
+			cache.Clear();
+			pieces.push_back((uint32_t)start);
+			size_t pieceStart = start;
+			uint32_t pieceMisses = 0;
+			for (size_t t = start; t < end; ++t)
+			{
+				pieceMisses += triangleMisses(t);
+				if (t + 1 < end && (float)pieceMisses <= missLimit * (float)(t + 1 - pieceStart))
+				{
+					pieces.push_back((uint32_t)(t + 1));
+					pieceStart = t + 1;
+					pieceMisses = 0;
+					cache.Clear();
+				}
+			}
+		}
+		if (pieces.size() < 2) return;
+
+		// Area weighted centroid and normal of every piece
+		struct Piece
+		{
+			uint32_t start;
+			uint32_t end;
+			glm::vec3 centroid;
+			glm::vec3 normal;
+			float area;
+			float sortKey;
+		};
+		std::vector<Piece> sorted(pieces.size());
+		glm::vec3 meshCentroid(0.0f);
+		float meshArea = 0.0f;
+		for (size_t p = 0; p < pieces.size(); ++p)
+		{
+			Piece& piece = sorted[p];
+			piece.start = pieces[p];
+			piece.end = p + 1 < pieces.size()? pieces[p + 1] : (uint32_t)triangleCount;
+			piece.centroid = glm::vec3(0.0f);
+			piece.normal = glm::vec3(0.0f);
+			piece.area = 0.0f;
+			for (uint32_t t = piece.start; t < piece.end; ++t)
+			{
+				const glm::vec3& p0 = vertices[indices[t * 3]].position;
+				const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+				const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float area = glm::length(normal) * 0.5f;
+				piece.centroid += (p0 + p1 + p2) * (area / 3.0f);
+				piece.normal += normal;
+				piece.area += area;
+			}
+			meshCentroid += piece.centroid;
+			meshArea += piece.area;
+			if (piece.area > 0.0f) piece.centroid /= piece.area;
+		}
+		if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+		for (Piece& piece : sorted)
+		{
+			const float length = glm::length(piece.normal);
+			piece.sortKey = length > 0.0f? glm::dot(piece.centroid - meshCentroid, piece.normal / length) : 0.0f;
+		}
+		// Outward facing pieces on the rim of the mesh go first, they are the most likely to occlude the rest
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Piece& a, const Piece& b) {return a.sortKey > b.sortKey;});
+
+		std::vector<unsigned int> output;
+		output.reserve(indices.size());
+		for (const Piece& piece : sorted)
+		{
+			output.insert(output.end(), indices.begin() + piece.start * 3, indices.begin() + piece.end * 3);
+		}
+		indices.swap(output);
+	}
+
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		if (!IndicesInRange(indices, vertices.size())) return;
+
+		// Vertices no triangle uses are dropped
+		std::vector<uint32_t> remap(vertices.size(), UNASSIGNED);
+		std::vector<Vertex> reordered;
+		reordered.reserve(vertices.size());
+		for (unsigned int& index : indices)
+		{
+			if (remap[index] == UNASSIGNED)
+			{
+				remap[index] = (uint32_t)reordered.size();
+				reordered.push_back(vertices[index]);
+			}
+			index = remap[index];
+		}
+		vertices.swap(reordered);
+	}
+
+	void OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+	{
+		const std::vector<uint32_t> clusters = OptimizeVertexCache(indices, vertices.size());
+		OptimizeOverdraw(indices, vertices, clusters);
+		OptimizeVertexFetch(vertices, indices);
+	}
+
+	Mesh OptimizeMesh(const Mesh& mesh)
+	{
+		if (mesh.IsQuantized() || mesh.indices.empty()) return mesh;
+
+		std::vector<Vertex> vertices(mesh.vertices.begin(), mesh.vertices.end());
+		std::vector<unsigned int> indices(mesh.indices.begin(), mesh.indices.end());
+		OptimizeMesh(vertices, indices);
+		Mesh optimized(std::move(vertices), std::move(indices), mesh.colors);
+		if (mesh.meshlets) optimized.meshlets = BuildMeshlets(optimized);
+		return optimized;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Model.h"
+#include "render/PostTransformCache.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Mesh Optimizer
+	// ===============
+	// Import-time reordering for RenderPipeline: triangles for the post-transform cache(Tipsify, Sander et al. 2007),
+	// then whole clusters of them so outward facing parts tend to draw first, then vertices in first use order
+
+	// Vertex shader invocations per triangle through a FIFO cache of cacheSize entries
+	float AnalyzeVertexCache(std::span<const unsigned int> indices, size_t vertexCount,
+		uint32_t cacheSize = PostTransformCache::SIZE);
+
+	// Returns the first triangle of every cluster, a new cluster starts where the walk had to jump to
+	// an unrelated part of the mesh
+	std::vector<uint32_t> OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+		uint32_t cacheSize = PostTransformCache::SIZE);
+
+	// Splits the clusters further where that costs less than threshold times their cache efficiency,
+	// then sorts them by how much they face away from the mesh center
+	void OptimizeOverdraw(std::vector<unsigned int>& indices, std::span<const Vertex> vertices,
+		const std::vector<uint32_t>& clusters, float threshold = 1.05f, uint32_t cacheSize = PostTransformCache::SIZE);
+
+	void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	// The three passes in order
+	void OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+	// Optimized copy with any meshlets rebuilt, quantized meshes are returned unchanged
+	Mesh OptimizeMesh(const Mesh& mesh);
+}
@@ -0,0 +1,374 @@
+#include "MeshResidency.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+
+#include "plog/Log.h"
+#include "core/Profiler.h"
+
+namespace CPURDR
+{
+	MeshResidency* MeshResidency::s_Instance = nullptr;
+
+	MeshResidency& MeshResidency::GetInstance()
+	{
+		if (s_Instance == nullptr)
+		{
+			s_Instance = new MeshResidency();
+		}
+		return *s_Instance;
+	}
+
+	size_t MeshStream::GetResidentLevel(size_t level) const
+	{
+		while (level + 1 < m_Levels.size() && !m_Levels[level].resident)
+		{
+			level++;
+		}
+		return level;
+	}
+
+	void MeshStream::Request(size_t level, float priority)
+	{
+		Level& entry = m_Levels[level];
+		entry.requestPriority = entry.requested? std::max(entry.requestPriority, priority) : priority;
+		entry.requested = true;
+	}
+
+	static void PrepareLevel(std::vector<Mesh>& meshes, const MeshImportSettings& settings, bool quantize)
+	{
+		std::vector<Mesh*> pointers;
+		for (Mesh& mesh : meshes) pointers.push_back(&mesh);
+		MeshLoader::PrepareMeshes(pointers, settings, quantize);
+	}
+
+	// A cache whose coarsest level fails to read counts as a miss, it is removed and cooked once more
+	static bool CookCoarsestLevel(const std::string& filepath, const MeshImportSettings& settings, std::string& cachePath,
+		std::vector<MeshCacheLevel>& levels, std::vector<Mesh>& coarsest)
+	{
+		for (int attempt = 0; attempt < 2; ++attempt)
+		{
+			if (!MeshLoader::GetInstance().CookMesh(filepath, settings, cachePath, levels))
+			{
+				return false;
+			}
+			if (levels.empty() || levels.front().submeshes.empty())
+			{
+				PLOG_WARNING << "No meshes found in file: " << filepath;
+				return false;
+			}
+			if (ReadMeshCacheLevel(cachePath, levels.back(), coarsest))
+			{
+				return true;
+			}
+
+			std::error_code error;
+			std::filesystem::remove(cachePath, error);
+		}
+		return false;
+	}
+
+	MeshAssetHandle MeshResidency::LoadStreamedMesh(const std::string& filepath, const MeshImportSettings& settings)
+	{
+		auto it = m_Assets.find(filepath);
+		if (MeshAssetHandle loaded = it != m_Assets.end()? it->second.lock() : nullptr)
+		{
+			return loaded;
+		}
+
+		MeshLoader& loader = MeshLoader::GetInstance();
+		auto stream = std::make_shared<MeshStream>();
+		std::vector<MeshCacheLevel> levels;
+		std::vector<Mesh> coarsest;
+		if (!CookCoarsestLevel(filepath, settings, stream->m_CachePath, levels, coarsest))
+		{
+			return nullptr;
+		}
+		PrepareLevel(coarsest, settings, loader.GetQuantizeVertices());
+
+		MeshAssetHandle asset;
+		if (levels.size() == 1)
+		{
+			PLOG_WARNING << "Mesh " << filepath << " has no coarser levels to stream, it is loaded whole";
+			asset = CreateMeshAsset(std::move(coarsest), filepath);
+		}
+		else
+		{
+			stream->m_Settings = settings;
+			stream->m_Quantize = loader.GetQuantizeVertices();
+			stream->m_Levels.resize(levels.size());
+			std::vector<MeshLod> lods(levels.size() - 1);
+			for (size_t level = 0; level < levels.size(); ++level)
+			{
+				stream->m_Levels[level].layout = levels[level];
+				if (level > 0) lods[level - 1].error = levels[level].error;
+			}
+			stream->m_Levels.back().meshes = coarsest;
+			stream->m_Levels.back().resident = true;
+			lods.back().meshes = std::move(coarsest);
+
+			m_Streams.push_back(stream);
+			asset = CreateMeshAsset({}, filepath, std::move(lods), std::move(stream));
+			PLOG_INFO << std::format("Streaming {}: {} levels, {} KB at full detail, {} KB kept resident", filepath,
+				levels.size(), levels.front().size / 1024, levels.back().size / 1024);
+		}
+
+		m_Assets[filepath] = asset;
+		return asset;
+	}
+
+	void MeshResidency::Update()
+	{
+		PROFILE_SCOPE("MeshResidency::Update");
+		m_Frame++;
+
+		// Whatever is still queued is requeued below in this frame's order, or dropped
+		std::vector<ReadResult> completed;
+		std::vector<ReadRequest> queued;
+		{
+			std::lock_guard<std::mutex> lock(m_ReadMutex);
+			completed.swap(m_CompletedReads);
+			queued.swap(m_ReadQueue);
+		}
+		for (const ReadRequest& request : queued)
+		{
+			if (std::shared_ptr<MeshStream> stream = request.stream.lock())
+			{
+				stream->m_Levels[request.level].reading = false;
+			}
+		}
+
+		for (ReadResult& result : completed)
+		{
+			std::shared_ptr<MeshStream> stream = result.stream.lock();
+			if (!stream) continue;
+
+			MeshStream::Level& level = stream->m_Levels[result.level];
+			level.reading = false;
+			if (!result.success)
+			{
+				// The stream keeps drawing a coarser level, the next load of the asset cooks the cache again
+				PLOG_WARNING << "Level " << result.level << " of " << stream->m_CachePath << " failed to read, removing the cache";
+				level.failed = true;
+				std::error_code error;
+				std::filesystem::remove(stream->m_CachePath, error);
+				continue;
+			}
+			level.meshes = std::move(result.meshes);
+			level.resident = true;
+			// Not evicted before it was drawn once
+			level.lastUsedFrame = m_Frame;
+			m_Statistics.bytesRead += level.layout.size;
+		}
+
+		std::erase_if(m_Streams, [](const std::weak_ptr<MeshStream>& stream) {return stream.expired();});
+		std::vector<std::shared_ptr<MeshStream>> streams;
+		streams.reserve(m_Streams.size());
+		for (const std::weak_ptr<MeshStream>& stream : m_Streams)
+		{
+			streams.push_back(stream.lock());
+		}
+
+		// Levels in memory or on their way count against the budget
+		struct Candidate
+		{
+			std::shared_ptr<MeshStream> stream;
+			size_t level;
+			float priority;
+		};
+		std::vector<Candidate> candidates;
+		uint64_t committedBytes = 0;
+		for (const std::shared_ptr<MeshStream>& stream : streams)
+		{
+			std::vector<MeshStream::Level>& levels = stream->m_Levels;
+			for (size_t level = 0; level + 1 < levels.size(); ++level)
+			{
+				if (levels[level].resident || levels[level].reading) committedBytes += levels[level].layout.size;
+			}
+
+			// Entities of one asset at different distances want different levels
+			for (size_t level = 0; level < levels.size(); ++level)
+			{
+				MeshStream::Level& wanted = levels[level];
+				if (!wanted.requested) continue;
+
+				levels[stream->GetResidentLevel(level)].lastUsedFrame = m_Frame;
+				if (!wanted.resident && !wanted.reading && !wanted.failed)
+				{
+					candidates.push_back({stream, level, wanted.requestPriority});
+				}
+				wanted.requested = false;
+			}
+		}
+
+		// Levels not drawn this frame, least recently used first
+		struct Evictable
+		{
+			MeshStream* stream;
+			size_t level;
+			uint64_t lastUsedFrame;
+		};
+		std::vector<Evictable> evictable;
+		uint64_t evictableBytes = 0;
+		for (const std::shared_ptr<MeshStream>& stream : streams)
+		{
+			for (size_t level = 0; level + 1 < stream->m_Levels.size(); ++level)
+			{
+				const MeshStream::Level& entry = stream->m_Levels[level];
+				if (entry.resident && entry.lastUsedFrame < m_Frame)
+				{
+					evictable.push_back({stream.get(), level, entry.lastUsedFrame});
+					evictableBytes += entry.layout.size;
+				}
+			}
+		}
+		std::sort(evictable.begin(), evictable.end(),
+			[](const Evictable& a, const Evictable& b) {return a.lastUsedFrame < b.lastUsedFrame;});
+		size_t nextEviction = 0;
+		auto evictUntil = [&](uint64_t bytes)
+		{
+			while (committedBytes > bytes && nextEviction < evictable.size())
+			{
+				MeshStream::Level& level = evictable[nextEviction].stream->m_Levels[evictable[nextEviction].level];
+				nextEviction++;
+				level.meshes.clear();
+				level.meshes.shrink_to_fit();
+				level.resident = false;
+				committedBytes -= level.layout.size;
+				evictableBytes -= level.layout.size;
+				m_Statistics.evictions++;
+			}
+		};
+		// The budget may have been lowered
+		evictUntil(m_Budget);
+
+		// Largest on screen first. A level that can't fit even after evicting leaves the room to smaller ones
+		std::stable_sort(candidates.begin(), candidates.end(),
+			[](const Candidate& a, const Candidate& b) {return a.priority > b.priority;});
+		std::vector<ReadRequest> requests;
+		for (const Candidate& candidate : candidates)
+		{
+			MeshStream::Level& level = candidate.stream->m_Levels[candidate.level];
+			if (committedBytes - std::min(committedBytes, evictableBytes) + level.layout.size > m_Budget) continue;
+
+			evictUntil(m_Budget - level.layout.size);
+			committedBytes += level.layout.size;
+			level.reading = true;
+			ReadRequest& request = requests.emplace_back();
+			request.stream = candidate.stream;
+			request.level = candidate.level;
+			request.cachePath = candidate.stream->m_CachePath;
+			request.layout = level.layout;
+			request.settings = candidate.stream->m_Settings;
+			request.quantize = candidate.stream->m_Quantize;
+		}
+
+		if (!requests.empty())
+		{
+			std::reverse(requests.begin(), requests.end());
+			{
+				std::lock_guard<std::mutex> lock(m_ReadMutex);
+				if (!m_ReadThread.joinable())
+				{
+					m_ReadStopping = false;
+					m_ReadThread = std::thread([this]() {ReadLoop();});
+				}
+				m_ReadQueue = std::move(requests);
+			}
+			m_ReadCondition.notify_all();
+		}
+
+		MeshResidencyStatistics& statistics = m_Statistics;
+		statistics.streams = streams.size();
+		statistics.residentLevels = 0;
+		statistics.residentBytes = 0;
+		statistics.permanentBytes = 0;
+		statistics.pendingReads = 0;
+		for (const std::shared_ptr<MeshStream>& stream : streams)
+		{
+			statistics.permanentBytes += stream->m_Levels.back().layout.size;
+			for (size_t level = 0; level + 1 < stream->m_Levels.size(); ++level)
+			{
+				const MeshStream::Level& entry = stream->m_Levels[level];
+				if (entry.resident)
+				{
+					statistics.residentLevels++;
+					statistics.residentBytes += entry.layout.size;
+				}
+				else if (entry.reading)
+				{
+					statistics.pendingReads++;
+				}
+			}
+		}
+	}
+
+	void MeshResidency::ReadLoop()
+	{
+		Profiler::GetInstance().SetThreadName("Mesh Streaming");
+		while (true)
+		{
+			ReadRequest request;
+			{
+				std::unique_lock<std::mutex> lock(m_ReadMutex);
+				m_ReadCondition.wait(lock, [this]() {return m_ReadStopping || !m_ReadQueue.empty();});
+				if (m_ReadStopping)
+				{
+					return;
+				}
+				request = std::move(m_ReadQueue.back());
+				m_ReadQueue.pop_back();
+				m_ReadsInProgress++;
+			}
+
+			ReadResult result;
+			{
+				PROFILE_SCOPE("MeshResidency::Read");
+				result.stream = std::move(request.stream);
+				result.level = request.level;
+				result.success = ReadMeshCacheLevel(request.cachePath, request.layout, result.meshes);
+				if (result.success) PrepareLevel(result.meshes, request.settings, request.quantize);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_ReadMutex);
+				m_CompletedReads.push_back(std::move(result));
+				m_ReadsInProgress--;
+			}
+			m_ReadCondition.notify_all();
+		}
+	}
+
+	void MeshResidency::WaitForReads()
+	{
+		std::unique_lock<std::mutex> lock(m_ReadMutex);
+		m_ReadCondition.wait(lock, [this]()
+		{
+			return !m_ReadThread.joinable() || m_ReadStopping || (m_ReadQueue.empty() && m_ReadsInProgress == 0);
+		});
+	}
+
+	void MeshResidency::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_ReadMutex);
+			m_ReadStopping = true;
+			m_ReadQueue.clear();
+		}
+		m_ReadCondition.notify_all();
+		if (m_ReadThread.joinable())
+		{
+			m_ReadThread.join();
+		}
+
+		m_CompletedReads.clear();
+		for (const std::weak_ptr<MeshStream>& weak : m_Streams)
+		{
+			if (std::shared_ptr<MeshStream> stream = weak.lock())
+			{
+				for (MeshStream::Level& level : stream->m_Levels) level.reading = false;
+			}
+		}
+	}
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "MeshAsset.h"
+#include "MeshCache.h"
+#include "MeshLoader.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Mesh Residency
+	// ===============
+	// Out-of-core meshes for scenes that don't fit in memory. A streamed asset is cooked into the mesh cache by
+	// MeshLoader, then only the table and the coarsest level of the cache are read, and that level stays for good.
+	// While rendering, every visible entity asks its stream for the level its screen error calls for and draws
+	// the finest one in memory meanwhile. Between frames, Update() has a background thread read the missing
+	// levels, the largest on screen first, and evicts the levels drawn longest ago to stay within the budget
+
+	// The levels of detail of one streamed asset and which of them are in memory. Request() is called while
+	// rendering, everything else changes in MeshResidency::Update() only, which never runs during a frame
+	class MeshStream
+	{
+	public:
+		size_t GetLevelCount() const {return m_Levels.size();}
+		bool IsResident(size_t level) const {return m_Levels[level].resident;}
+		// Finest level in memory that is at least as coarse as level
+		size_t GetResidentLevel(size_t level) const;
+		// Empty unless the level is resident
+		const std::vector<Mesh>& GetMeshes(size_t level) const {return m_Levels[level].meshes;}
+
+		// The frame being rendered wants level on screen. Higher priorities are read first
+		void Request(size_t level, float priority);
+
+	private:
+		friend class MeshResidency;
+
+		struct Level
+		{
+			MeshCacheLevel layout;
+			std::vector<Mesh> meshes;
+			bool resident = false;
+			// Queued or being read
+			bool reading = false;
+			// Not requested again once a read failed
+			bool failed = false;
+			uint64_t lastUsedFrame = 0;
+			// By any entity since the last Update(), with the highest priority asked
+			bool requested = false;
+			float requestPriority = 0.0f;
+		};
+
+		std::string m_CachePath;
+		MeshImportSettings m_Settings;
+		bool m_Quantize = false;
+		// The last one is the coarsest, always resident
+		std::vector<Level> m_Levels;
+	};
+
+	struct MeshResidencyStatistics
+	{
+		size_t streams = 0;
+		// Levels paged in and what they take of the budget, counted at their cooked size
+		size_t residentLevels = 0;
+		uint64_t residentBytes = 0;
+		// The coarsest level of every stream, kept outside the budget
+		uint64_t permanentBytes = 0;
+		// Queued or being read
+		size_t pendingReads = 0;
+		// Since startup
+		uint64_t bytesRead = 0;
+		uint64_t evictions = 0;
+	};
+
+	class MeshResidency
+	{
+	public:
+		static MeshResidency& GetInstance();
+
+		// Cooks filepath unless the mesh cache is current and reads its coarsest level, blocking. Every load of a
+		// path returns the same asset while any handle to it is alive, nullptr on failure
+		MeshAssetHandle LoadStreamedMesh(const std::string& filepath, const MeshImportSettings& settings = {});
+
+		// Bytes the levels paged in may take together. Levels the last frame drew stay until they go unused
+		void SetBudget(uint64_t bytes) {m_Budget = bytes;}
+		uint64_t GetBudget() const {return m_Budget;}
+
+		// Installs the finished reads, then queues reads for what the last frame requested, evicting the least
+		// recently used levels to make room. Call once per frame while no frame renders
+		void Update();
+
+		// Blocks until every queued read is done, the next Update() installs them
+		void WaitForReads();
+
+		// As of the last Update()
+		const MeshResidencyStatistics& GetStatistics() const {return m_Statistics;}
+
+		// Waits for the read in progress and drops the queued ones, streams keep what they have
+		void Shutdown();
+
+	private:
+		MeshResidency() = default;
+		~MeshResidency() = default;
+
+		MeshResidency(const MeshResidency&) = delete;
+		MeshResidency& operator=(const MeshResidency&) = delete;
+		MeshResidency(MeshResidency&&) = delete;
+		MeshResidency& operator=(MeshResidency&&) = delete;
+
+		// Holds copies of what the read thread needs, it never touches a stream
+		struct ReadRequest
+		{
+			std::weak_ptr<MeshStream> stream;
+			size_t level = 0;
+			std::string cachePath;
+			MeshCacheLevel layout;
+			MeshImportSettings settings;
+			bool quantize = false;
+		};
+
+		struct ReadResult
+		{
+			std::weak_ptr<MeshStream> stream;
+			size_t level = 0;
+			std::vector<Mesh> meshes;
+			bool success = false;
+		};
+
+		void ReadLoop();
+
+		// Weak so an asset and its stream are freed once no entity uses them
+		std::unordered_map<std::string, std::weak_ptr<const MeshAsset>> m_Assets;
+		std::vector<std::weak_ptr<MeshStream>> m_Streams;
+		uint64_t m_Budget = 256ull << 20;
+		uint64_t m_Frame = 0;
+		MeshResidencyStatistics m_Statistics;
+
+		// Shared with the read thread
+		std::thread m_ReadThread;
+		std::mutex m_ReadMutex;
+		std::condition_variable m_ReadCondition;
+		// Highest priority last, the thread takes from the back
+		std::vector<ReadRequest> m_ReadQueue;
+		std::vector<ReadResult> m_CompletedReads;
+		size_t m_ReadsInProgress = 0;
+		bool m_ReadStopping = false;
+
+		static MeshResidency* s_Instance;
+	};
+}
@@ -0,0 +1,363 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+#include "core/Profiler.h"
+#include "core/ThreadPool.h"
+
+namespace CPURDR
+{
+	static constexpr uint32_t UNASSIGNED = 0xFFFFFFFF;
+
+	// A level is dropped when it keeps more than this share of the previous level's triangles
+	static constexpr float MIN_LOD_REDUCTION = 0.9f;
+
+	// Weighted sum of squared distances to a set of planes, the symmetric 4x4 matrix of Garland and Heckbert
+	struct Quadric
+	{
+		double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+		double b2 = 0.0, bc = 0.0, bd = 0.0;
+		double c2 = 0.0, cd = 0.0;
+		double d2 = 0.0;
+		double weight = 0.0;
+
+		void AddPlane(const glm::dvec3& n, double d, double w)
+		{
+			a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+			b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+			c2 += w * n.z * n.z; cd += w * n.z * d;
+			d2 += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			weight += q.weight;
+		}
+
+		// Mean squared distance, so the error stays a length however many planes were merged
+		double Evaluate(const glm::vec3& p) const
+		{
+			if (weight <= 0.0) return 0.0;
+			const double x = p.x, y = p.y, z = p.z;
+			const double error = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+				b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+				c2 * z * z + 2.0 * cd * z + d2;
+			return std::max(error / weight, 0.0);
+		}
+	};
+
+	struct PositionKey
+	{
+		uint32_t bits[3];
+
+		bool operator==(const PositionKey& other) const
+		{
+			return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+		}
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			return ((size_t)key.bits[0] * 73856093u) ^ ((size_t)key.bits[1] * 19349663u) ^ ((size_t)key.bits[2] * 83492791u);
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	float SimplifyMesh(std::vector<unsigned int>& indices, std::span<const Vertex> vertices, size_t targetIndexCount)
+	{
+		const size_t vertexCount = vertices.size();
+		if (indices.size() <= targetIndexCount || indices.size() % 3 != 0) return 0.0f;
+		if (std::any_of(indices.begin(), indices.end(), [vertexCount](unsigned int index) {return index >= vertexCount;})) return 0.0f;
+
+		// Vertices sharing a position are one vertex of the topology, the corners keep their own attributes
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<glm::vec3> positions;
+		{
+			std::unordered_map<PositionKey, uint32_t, PositionKeyHash> welded;
+			welded.reserve(vertexCount);
+			for (size_t v = 0; v < vertexCount; ++v)
+			{
+				PositionKey key;
+				std::memcpy(key.bits, &vertices[v].position, sizeof(key.bits));
+				auto [it, inserted] = welded.try_emplace(key, (uint32_t)positions.size());
+				if (inserted) positions.push_back(vertices[v].position);
+				remap[v] = it->second;
+			}
+		}
+		const size_t positionCount = positions.size();
+
+		// A position reached through more than one vertex lies on an attribute seam and is locked
+		std::vector<uint32_t> wedge(positionCount, UNASSIGNED);
+		std::vector<bool> locked(positionCount, false);
+		for (unsigned int index : indices)
+		{
+			const uint32_t p = remap[index];
+			if (wedge[p] == UNASSIGNED) wedge[p] = index;
+			else if (wedge[p] != index) locked[p] = true;
+		}
+
+		// So are the ends of edges that are not shared by exactly two oppositely wound triangles
+		{
+			std::unordered_map<uint64_t, int> edges;
+			edges.reserve(indices.size());
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					const uint32_t a = remap[indices[i + k]];
+					const uint32_t b = remap[indices[i + (k + 1) % 3]];
+					if (a == b) continue;
+					// +1 one way, +1024 the other, a manifold edge ends up at exactly 1025
+					edges[a < b? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a] += a < b? 1 : 1024;
+				}
+			}
+			for (const auto& [edge, count] : edges)
+			{
+				if (count == 1025) continue;
+				locked[edge >> 32] = true;
+				locked[edge & 0xFFFFFFFF] = true;
+			}
+		}
+
+		std::vector<Quadric> quadrics(positionCount);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const glm::dvec3 p0 = positions[remap[indices[i]]];
+			const glm::dvec3 normal = glm::cross(glm::dvec3(positions[remap[indices[i + 1]]]) - p0,
+				glm::dvec3(positions[remap[indices[i + 2]]]) - p0);
+			const double length = glm::length(normal);
+			if (length <= 0.0) continue;
+
+			// Weighted by area, so many small triangles don't outvote one large one
+			Quadric plane;
+			plane.AddPlane(normal / length, -glm::dot(normal / length, p0), length * 0.5);
+			for (int k = 0; k < 3; ++k)
+			{
+				quadrics[remap[indices[i + k]]].Add(plane);
+			}
+		}
+
+		const size_t targetTriangles = targetIndexCount / 3;
+		size_t liveTriangles = indices.size() / 3;
+		double maxError = 0.0;
+
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> adjacency;
+		std::vector<Collapse> collapses;
+		std::vector<bool> dead;
+		std::vector<bool> touched;
+		std::vector<uint32_t> neighborsFrom;
+		std::vector<uint32_t> neighborsTo;
+		while (liveTriangles > targetTriangles)
+		{
+			const size_t triangleCount = indices.size() / 3;
+
+			// Triangles around every position, in compressed rows
+			offsets.assign(positionCount + 1, 0);
+			for (unsigned int index : indices) offsets[remap[index] + 1]++;
+			for (size_t p = 0; p < positionCount; ++p) offsets[p + 1] += offsets[p];
+			adjacency.resize(indices.size());
+			{
+				std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < indices.size(); ++i) adjacency[fill[remap[indices[i]]]++] = (uint32_t)(i / 3);
+			}
+
+			collapses.clear();
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					const uint32_t a = remap[indices[i + k]];
+					const uint32_t b = remap[indices[i + (k + 1) % 3]];
+					if (!locked[a]) collapses.push_back({a, b, quadrics[a].Evaluate(positions[b])});
+					if (!locked[b]) collapses.push_back({b, a, quadrics[b].Evaluate(positions[a])});
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {return x.cost < y.cost;});
+
+			// Half of what is left per pass, so later collapses are chosen with fresh costs
+			const size_t passGoal = std::max<size_t>(2, (liveTriangles - targetTriangles) / 2);
+			size_t removed = 0;
+			dead.assign(triangleCount, false);
+			touched.assign(positionCount, false);
+
+			auto corner = [&](uint32_t triangle, int k) {return remap[indices[(size_t)triangle * 3 + k]];};
+			auto contains = [&](uint32_t triangle, uint32_t p) {return corner(triangle, 0) == p || corner(triangle, 1) == p || corner(triangle, 2) == p;};
+			auto gatherNeighbors = [&](uint32_t p, std::vector<uint32_t>& neighbors)
+			{
+				neighbors.clear();
+				for (uint32_t k = offsets[p]; k < offsets[p + 1]; ++k)
+				{
+					if (dead[adjacency[k]]) continue;
+					for (int c = 0; c < 3; ++c)
+					{
+						if (corner(adjacency[k], c) != p) neighbors.push_back(corner(adjacency[k], c));
+					}
+				}
+				std::sort(neighbors.begin(), neighbors.end());
+				neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+			};
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (removed >= passGoal || liveTriangles - removed <= targetTriangles) break;
+				const uint32_t from = collapse.from;
+				const uint32_t to = collapse.to;
+				if (touched[from] || touched[to]) continue;
+
+				// The vertex of `to` the two triangles on the edge use, the rest of the fan of `from` joins them
+				uint32_t target = UNASSIGNED;
+				int shared = 0;
+				bool consistent = true;
+				bool flips = false;
+				for (uint32_t k = offsets[from]; k < offsets[from + 1]; ++k)
+				{
+					const uint32_t triangle = adjacency[k];
+					if (dead[triangle]) continue;
+					if (contains(triangle, to))
+					{
+						shared++;
+						for (int c = 0; c < 3; ++c)
+						{
+							if (corner(triangle, c) != to) continue;
+							const uint32_t index = indices[(size_t)triangle * 3 + c];
+							consistent &= target == UNASSIGNED || target == index;
+							target = index;
+						}
+						continue;
+					}
+
+					glm::vec3 before[3];
+					glm::vec3 after[3];
+					for (int c = 0; c < 3; ++c)
+					{
+						before[c] = positions[corner(triangle, c)];
+						after[c] = corner(triangle, c) == from? positions[to] : before[c];
+					}
+					const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					flips |= glm::dot(normalBefore, normalAfter) <= 0.0f;
+				}
+				if (!consistent || flips || shared != 2 || target == UNASSIGNED) continue;
+
+				// Link condition: the edge's two opposite corners must be the only shared neighbors,
+				// otherwise the collapse pinches the surface
+				gatherNeighbors(from, neighborsFrom);
+				gatherNeighbors(to, neighborsTo);
+				size_t common = 0;
+				for (size_t a = 0, b = 0; a < neighborsFrom.size() && b < neighborsTo.size();)
+				{
+					if (neighborsFrom[a] < neighborsTo[b]) a++;
+					else if (neighborsFrom[a] > neighborsTo[b]) b++;
+					else {common++; a++; b++;}
+				}
+				if (common != 2) continue;
+
+				for (uint32_t k = offsets[from]; k < offsets[from + 1]; ++k)
+				{
+					const uint32_t triangle = adjacency[k];
+					if (dead[triangle]) continue;
+					if (contains(triangle, to))
+					{
+						dead[triangle] = true;
+						removed++;
+						continue;
+					}
+					for (int c = 0; c < 3; ++c)
+					{
+						if (corner(triangle, c) == from) indices[(size_t)triangle * 3 + c] = target;
+					}
+				}
+				quadrics[to].Add(quadrics[from]);
+				maxError = std::max(maxError, collapse.cost);
+				touched[from] = true;
+				touched[to] = true;
+			}
+
+			if (removed == 0) break;
+			liveTriangles -= removed;
+
+			size_t write = 0;
+			for (size_t t = 0; t < triangleCount; ++t)
+			{
+				if (dead[t]) continue;
+				for (int c = 0; c < 3; ++c) indices[write++] = indices[t * 3 + c];
+			}
+			indices.resize(write);
+		}
+
+		return (float)std::sqrt(maxError);
+	}
+
+	std::vector<MeshLod> GenerateLods(const std::vector<Mesh>& meshes, bool optimize)
+	{
+		PROFILE_SCOPE("GenerateLods");
+		constexpr size_t LEVEL_COUNT = std::size(LOD_TARGET_RATIOS);
+		if (meshes.empty() || std::any_of(meshes.begin(), meshes.end(), [](const Mesh& mesh) {return mesh.IsQuantized();}))
+		{
+			return {};
+		}
+
+		// Every level of every submesh is independent. Import-time work, kept off the pool frames render on
+		std::vector<Mesh> simplified(LEVEL_COUNT * meshes.size(), Mesh({}, {}));
+		std::vector<float> errors(simplified.size(), 0.0f);
+		ThreadPool::GetImportInstance().ParallelFor(0, simplified.size(), 1,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t job = begin; job < end; ++job)
+				{
+					const Mesh& mesh = meshes[job % meshes.size()];
+					const float ratio = LOD_TARGET_RATIOS[job / meshes.size()];
+
+					std::vector<unsigned int> indices(mesh.indices.begin(), mesh.indices.end());
+					const size_t targetIndexCount = (size_t)((float)(indices.size() / 3) * ratio) * 3;
+					errors[job] = SimplifyMesh(indices, mesh.vertices, targetIndexCount);
+
+					// Also drops the vertices no triangle uses anymore
+					std::vector<Vertex> vertices(mesh.vertices.begin(), mesh.vertices.end());
+					if (optimize) OptimizeMesh(vertices, indices);
+					else OptimizeVertexFetch(vertices, indices);
+					simplified[job] = Mesh(std::move(vertices), std::move(indices));
+				}
+			});
+
+		std::vector<MeshLod> lods;
+		size_t previousTriangles = 0;
+		for (const Mesh& mesh : meshes) previousTriangles += mesh.indices.size() / 3;
+		for (size_t level = 0; level < LEVEL_COUNT; ++level)
+		{
+			// Never below the finer level, selection assumes the error grows along the chain
+			MeshLod lod;
+			lod.error = lods.empty()? 0.0f : lods.back().error;
+			size_t triangles = 0;
+			for (size_t i = 0; i < meshes.size(); ++i)
+			{
+				const size_t job = level * meshes.size() + i;
+				lod.meshes.push_back(std::move(simplified[job]));
+				lod.error = std::max(lod.error, errors[job]);
+				triangles += lod.meshes.back().indices.size() / 3;
+			}
+			if ((float)triangles > MIN_LOD_REDUCTION * (float)previousTriangles) break;
+
+			previousTriangles = triangles;
+			lods.push_back(std::move(lod));
+		}
+		return lods;
+	}
+}
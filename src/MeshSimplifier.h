@@ -0,0 +1,27 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "MeshAsset.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Mesh Simplifier
+	// ===============
+	// Quadric error edge collapse(Garland and Heckbert 1997). Every collapse moves a vertex onto one of its
+	// neighbors, so no vertex is created and attributes are never interpolated. Vertices on open borders,
+	// attribute seams and non-manifold edges stay, which keeps outlines and texture layout on every level
+
+	// Collapses edges, cheapest first, until at most targetIndexCount indices are left or nothing can collapse.
+	// Returns the error of the result: the root of the largest area weighted mean squared plane distance of any
+	// collapse, roughly how far the surface moved in object space units
+	float SimplifyMesh(std::vector<unsigned int>& indices, std::span<const Vertex> vertices, size_t targetIndexCount);
+
+	// Triangle count of each generated level relative to the source
+	constexpr float LOD_TARGET_RATIOS[] = {0.5f, 0.25f, 0.1f, 0.04f};
+
+	// Simplifies every submesh to each ratio in LOD_TARGET_RATIOS, from the full detail meshes each time. The chain
+	// ends early once a level can't get meaningfully smaller than the one before. Quantized meshes get no levels
+	std::vector<MeshLod> GenerateLods(const std::vector<Mesh>& meshes, bool optimize);
+}
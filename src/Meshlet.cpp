@@ -0,0 +1,111 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+
+#include "Model.h"
+
+namespace CPURDR
+{
+	static Meshlet ComputeMeshletBounds(const Mesh& mesh, uint32_t firstTriangle, uint32_t triangleCount)
+	{
+		Meshlet meshlet;
+		meshlet.firstTriangle = firstTriangle;
+		meshlet.triangleCount = triangleCount;
+
+		const size_t firstIndex = (size_t)firstTriangle * 3;
+		const size_t endIndex = firstIndex + (size_t)triangleCount * 3;
+
+		glm::vec3 boundsMin(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+		for (size_t i = firstIndex; i < endIndex; ++i)
+		{
+			const glm::vec3 position = mesh.GetPosition(mesh.indices[i]);
+			boundsMin = glm::min(boundsMin, position);
+			boundsMax = glm::max(boundsMax, position);
+		}
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		meshlet.radius = 0.0f;
+		for (size_t i = firstIndex; i < endIndex; ++i)
+		{
+			meshlet.radius = std::max(meshlet.radius, glm::length(mesh.GetPosition(mesh.indices[i]) - meshlet.center));
+		}
+
+		// Average face normal as the axis, the widest deviation from it decides the cutoff
+		std::vector<glm::vec3> normals;
+		normals.reserve(triangleCount);
+		glm::vec3 axis(0.0f);
+		for (size_t i = firstIndex; i < endIndex; i += 3)
+		{
+			const glm::vec3 p0 = mesh.GetPosition(mesh.indices[i]);
+			const glm::vec3 normal = glm::cross(mesh.GetPosition(mesh.indices[i + 1]) - p0, mesh.GetPosition(mesh.indices[i + 2]) - p0);
+			const float length = glm::length(normal);
+			// Degenerate triangles never rasterize
+			if (length <= 0.0f) continue;
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+
+		meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		meshlet.coneCutoff = MESHLET_NO_CONE;
+		const float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength <= 0.0f) return meshlet;
+
+		meshlet.coneAxis = axis / axisLength;
+		float minDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+		{
+			minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+		}
+		// Half a degree of slack for the rounding of the normals
+		if (minDot > 0.01f)
+		{
+			meshlet.coneCutoff = std::min(1.0f, std::sqrt(1.0f - minDot * minDot) + 0.01f);
+		}
+		return meshlet;
+	}
+
+	MeshletList BuildMeshlets(const Mesh& mesh)
+	{
+		auto meshlets = std::make_shared<std::vector<Meshlet>>();
+		const uint32_t triangleCount = (uint32_t)(mesh.indices.size() / 3);
+		if (triangleCount == 0) return meshlets;
+
+		// Stamped with the meshlet that last used the vertex
+		std::vector<uint32_t> usedBy(mesh.GetVertexCount(), 0xFFFFFFFF);
+		uint32_t meshletIndex = 0;
+		uint32_t first = 0;
+		uint32_t vertexCount = 0;
+		for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+		{
+			const unsigned int* corners = &mesh.indices[(size_t)triangle * 3];
+			auto countNewVertices = [&]()
+			{
+				uint32_t count = 0;
+				for (int j = 0; j < 3; ++j)
+				{
+					const bool repeated = (j > 0 && corners[j] == corners[0]) || (j > 1 && corners[j] == corners[1]);
+					count += usedBy[corners[j]] != meshletIndex && !repeated;
+				}
+				return count;
+			};
+
+			uint32_t newVertices = countNewVertices();
+			if (triangle - first == MESHLET_MAX_TRIANGLES || vertexCount + newVertices > MESHLET_MAX_VERTICES)
+			{
+				meshlets->push_back(ComputeMeshletBounds(mesh, first, triangle - first));
+				first = triangle;
+				vertexCount = 0;
+				meshletIndex++;
+				newVertices = countNewVertices();
+			}
+
+			for (int j = 0; j < 3; ++j)
+			{
+				usedBy[corners[j]] = meshletIndex;
+			}
+			vertexCount += newVertices;
+		}
+		meshlets->push_back(ComputeMeshletBounds(mesh, first, triangleCount - first));
+		return meshlets;
+	}
+}
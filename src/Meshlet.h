@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm.hpp"
+
+namespace CPURDR
+{
+	struct Mesh;
+
+	// ===============
+	// Meshlets
+	// ===============
+	// Consecutive triangles of a mesh's index buffer with bounds to cull them as a group. Built by scanning the
+	// index buffer in order, so a cache optimized mesh(see MeshOptimizer.h) gives compact meshlets
+	constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+	constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+	// coneCutoff above 1 means the normals spread too far for the meshlet to ever be entirely back facing
+	constexpr float MESHLET_NO_CONE = 2.0f;
+
+	struct Meshlet
+	{
+		uint32_t firstTriangle;
+		uint32_t triangleCount;
+
+		// Object space
+		glm::vec3 center;
+		float radius;
+
+		// Every triangle faces away from a camera at c when
+		// dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius
+		glm::vec3 coneAxis;
+		float coneCutoff;
+	};
+
+	// Triangles [first, end) of the index buffer
+	struct TriangleRange
+	{
+		uint32_t first;
+		uint32_t end;
+	};
+
+	using MeshletList = std::shared_ptr<const std::vector<Meshlet>>;
+
+	// Bounds come from the positions the mesh decodes to, so build after quantizing
+	MeshletList BuildMeshlets(const Mesh& mesh);
+}
@@ -11,6 +11,40 @@
 
 namespace CPURDR
 {
+	struct OwnedMeshData
+	{
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices)
+	{
+		auto data = std::make_shared<OwnedMeshData>(std::move(vertices), std::move(indices));
+		this->vertices = data->vertices;
+		this->indices = data->indices;
+		m_Storage = std::move(data);
+	}
+
+	Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, const std::vector<SDL_Color>& colors):
+		Mesh(std::move(vertices), std::move(indices))
+	{
+		this->colors = colors;
+	}
+
+	Mesh::Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices, std::shared_ptr<const void> storage):
+		vertices(vertices), indices(indices), m_Storage(std::move(storage))
+	{
+
+	}
+
+	Mesh::Mesh(std::span<const QuantizedVertex> vertices, std::span<const unsigned int> indices,
+		const glm::vec3& positionOffset, const glm::vec3& positionScale, std::shared_ptr<const void> storage):
+		indices(indices), quantizedVertices(vertices), positionOffset(positionOffset), positionScale(positionScale),
+		m_Storage(std::move(storage))
+	{
+
+	}
+
 	Model::Model(const std::string& file):
 		m_Rng(std::random_device{}()),
 		m_Dist(0, 255),
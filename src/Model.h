@@ -1,10 +1,13 @@
 #pragma once
+#include <memory>
 #include <random>
+#include <span>
 #include <string>
 #include <vector>
 #include <assimp/scene.h>
 
 #include "Camera.h"
+#include "Meshlet.h"
 #include "vec2.hpp"
 #include "vec3.hpp"
 #include "assimp/Importer.hpp"
@@ -21,23 +24,54 @@ namespace CPURDR
 		glm::vec3 normal;
 	};
 
+	// Compact layout of Vertex, 16 bytes instead of 32. Encoded and decoded by VertexQuantization.h
+	struct QuantizedVertex
+	{
+		// Fraction of the mesh bounds, see Mesh::positionScale
+		uint16_t position[3];
+		uint16_t unused;
+		// Octahedral unit vector, two snorm16
+		uint32_t normal;
+		// Two half floats
+		uint32_t texcoord;
+	};
+	static_assert(sizeof(QuantizedVertex) == 16);
+
+	// Vertex and index data are immutable views into shared storage, either arrays built in memory or a
+	// memory-mapped mesh cache file. Copies share the storage instead of duplicating it
 	struct Mesh
 	{
-		std::vector<Vertex> vertices;
-		std::vector<unsigned int> indices;
+		std::span<const Vertex> vertices;
+		std::span<const unsigned int> indices;
 		std::vector<SDL_Color> colors;
 
-		Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
-		: vertices(vertices), indices(indices)
-		{
+		// Used instead of vertices by quantized meshes, which leave vertices and colors empty
+		std::span<const QuantizedVertex> quantizedVertices;
+		glm::vec3 positionOffset = glm::vec3(0.0f);
+		glm::vec3 positionScale = glm::vec3(1.0f);
 
-		}
+		// Optional, lets RenderPipeline cull parts of the mesh. Must be rebuilt whenever the data above changes
+		MeshletList meshlets;
 
-		Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<SDL_Color>& colors)
-		: vertices(vertices), indices(indices), colors(colors)
-		{
+		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices);
+		Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, const std::vector<SDL_Color>& colors);
+		// Views memory that storage keeps alive
+		Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices, std::shared_ptr<const void> storage);
+		Mesh(std::span<const QuantizedVertex> vertices, std::span<const unsigned int> indices,
+			const glm::vec3& positionOffset, const glm::vec3& positionScale, std::shared_ptr<const void> storage);
+
+		bool IsQuantized() const {return !quantizedVertices.empty();}
+		size_t GetVertexCount() const {return IsQuantized()? quantizedVertices.size() : vertices.size();}
 
+		glm::vec3 GetPosition(size_t index) const
+		{
+			if (!IsQuantized()) return vertices[index].position;
+			const QuantizedVertex& vertex = quantizedVertices[index];
+			return positionOffset + glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]) * positionScale;
 		}
+
+	private:
+		std::shared_ptr<const void> m_Storage;
 	};
 
 	class Model
@@ -100,12 +100,12 @@ namespace CPURDR
 				unsigned int next = current + segments + 1;
 
 				indices.push_back(current);
-				indices.push_back(next);
 				indices.push_back(current + 1);
+				indices.push_back(next);
 
 				indices.push_back(current + 1);
-				indices.push_back(next);
 				indices.push_back(next + 1);
+				indices.push_back(next);
 			}
 		}
 
@@ -232,16 +232,16 @@ namespace CPURDR
         for (int i = 0; i < segments; i++)
         {
             indices.push_back(topCenterIdx);
-            indices.push_back(topCenterIdx + i + 1);
             indices.push_back(topCenterIdx + i + 2);
+            indices.push_back(topCenterIdx + i + 1);
         }
 
         // Bottom cap indices
         for (int i = 0; i < segments; i++)
         {
             indices.push_back(bottomCenterIdx);
-            indices.push_back(bottomCenterIdx + i + 2);
             indices.push_back(bottomCenterIdx + i + 1);
+            indices.push_back(bottomCenterIdx + i + 2);
         }
 
         // Side indices
@@ -253,12 +253,12 @@ namespace CPURDR
             unsigned int br = tr + 1;
 
             indices.push_back(tl);
-            indices.push_back(bl);
             indices.push_back(tr);
+            indices.push_back(bl);
 
             indices.push_back(tr);
-            indices.push_back(bl);
             indices.push_back(br);
+            indices.push_back(bl);
         }
 
 		auto colors = GenerateRandomColors(indices.size() / 3);
@@ -348,12 +348,12 @@ namespace CPURDR
                 unsigned int next = current + segments + 1;
 
                 indices.push_back(current);
-                indices.push_back(next);
                 indices.push_back(current + 1);
+                indices.push_back(next);
 
                 indices.push_back(current + 1);
-                indices.push_back(next);
                 indices.push_back(next + 1);
+                indices.push_back(next);
             }
         }
 
@@ -366,12 +366,12 @@ namespace CPURDR
                 unsigned int next = current + segments + 1;
 
                 indices.push_back(current);
-                indices.push_back(next);
                 indices.push_back(current + 1);
+                indices.push_back(next);
 
                 indices.push_back(current + 1);
-                indices.push_back(next);
                 indices.push_back(next + 1);
+                indices.push_back(next);
             }
         }
 
@@ -383,12 +383,12 @@ namespace CPURDR
 			unsigned int br = tr + 1;
 
 			indices.push_back(tl);
-			indices.push_back(bl);
 			indices.push_back(tr);
+			indices.push_back(bl);
 
 			indices.push_back(tr);
-			indices.push_back(bl);
 			indices.push_back(br);
+			indices.push_back(bl);
 		}
 
 		auto colors = GenerateRandomColors(indices.size() / 3);
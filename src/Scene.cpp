@@ -8,11 +8,12 @@
 #include "render/MaterialManager.h"
 #include "Primitives.h"
 #include "MeshLoader.h"
+#include "MeshResidency.h"
 #include "plog/Log.h"
 
 namespace CPURDR
 {
-	Scene::Scene(const std::string& name):m_Name(name)
+	Scene::Scene(const std::string& name):m_Name(name), m_LifetimeToken(std::make_shared<Scene*>(this))
 	{
 		PLOG_INFO << "Created scene" << name;
 	}
@@ -47,9 +48,7 @@ namespace CPURDR
 		entt::entity entity = CreateEntity(name);
 
 		auto& loader = MeshLoader::GetInstance();
-		std::vector<Mesh> meshes = loader.LoadMeshFromFile(meshPath);
-
-		m_Registry.emplace<MeshFilter>(entity, std::move(meshes));
+		m_Registry.emplace<MeshFilter>(entity, loader.LoadMeshFromFile(meshPath));
 		m_Registry.emplace<MeshRenderer>(entity);
 
 		return entity;
@@ -63,6 +62,41 @@ namespace CPURDR
 		return entity;
 	}
 
+	entt::entity Scene::CreateMeshEntityAsync(const std::string& name, const std::string& meshPath)
+	{
+		auto& loader = MeshLoader::GetInstance();
+		MeshAssetHandle placeholder = loader.GetPlaceholderAsset();
+		entt::entity entity = CreateMeshEntity(name, MeshFilter(placeholder));
+
+		std::weak_ptr<Scene*> token = m_LifetimeToken;
+		loader.LoadMeshAsync(meshPath, [token, entity, placeholder](MeshAssetHandle asset)
+		{
+			std::shared_ptr<Scene*> scene = token.lock();
+			if (!scene) return;
+
+			entt::registry& registry = (*scene)->m_Registry;
+			MeshFilter* meshFilter = registry.valid(entity)? registry.try_get<MeshFilter>(entity) : nullptr;
+			// Left alone if the entity was deleted or given another mesh meanwhile
+			if (meshFilter == nullptr || meshFilter->asset != placeholder) return;
+
+			if (asset)
+			{
+				meshFilter->asset = std::move(asset);
+			}
+			else
+			{
+				registry.remove<MeshFilter>(entity);
+			}
+		});
+
+		return entity;
+	}
+
+	entt::entity Scene::CreateStreamedMeshEntity(const std::string& name, const std::string& meshPath)
+	{
+		return CreateMeshEntity(name, MeshFilter(MeshResidency::GetInstance().LoadStreamedMesh(meshPath)));
+	}
+
 	entt::entity Scene::CreateDirectionalLightEntity(const std::string& name)
 	{
 		entt::entity entity = CreateEntity(name);
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include <string>
 #include "entt.hpp"
 
@@ -18,6 +19,10 @@ namespace CPURDR
 
 		entt::entity CreateMeshEntity(const std::string& name, const std::string& meshPath);
 		entt::entity CreateMeshEntity(const std::string& name, const MeshFilter& meshFilter);
+		// Returns at once with a placeholder mesh, the imported asset replaces it from MeshLoader::ProcessCompletedLoads()
+		entt::entity CreateMeshEntityAsync(const std::string& name, const std::string& meshPath);
+		// Pages the mesh's levels of detail in and out through MeshResidency, blocks while it is cooked the first time
+		entt::entity CreateStreamedMeshEntity(const std::string& name, const std::string& meshPath);
 
 		entt::entity CreateDirectionalLightEntity(const std::string& name = "Directional Light");
 
@@ -68,6 +73,9 @@ namespace CPURDR
 
 		std::unordered_map<entt::entity, size_t> m_EntityOrder;
 		size_t m_NextOrder = 0;
+
+		// Load callbacks hold it weakly, so they are dropped once the scene is gone
+		std::shared_ptr<Scene*> m_LifetimeToken;
 	};
 
 	class SceneManager
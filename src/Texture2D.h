@@ -64,6 +64,9 @@ namespace CPURDR
 	using Texture2D_RGBA = Texture2D<uint32_t>; // SDR
 	using Texture2D_S8 = Texture2D<uint8_t>;    // Stencil
 	using Texture2D_RFloat = Texture2D<float>;  // 32-bit Depth/Shadowmap
+	using Texture2D_D16 = Texture2D<uint16_t>;  // 16-bit unorm Depth
+	using Texture2D_D24S8 = Texture2D<uint32_t>;// 24-bit unorm Depth + 8-bit Stencil, packed as (depth << 8) | stencil
+	using Texture2D_R32UI = Texture2D<uint32_t>;// 32-bit counters
 
 	template<typename T>
 	Texture2D<T>::Texture2D(const size_t w, const size_t h):
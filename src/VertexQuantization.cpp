@@ -0,0 +1,75 @@
+#include "VertexQuantization.h"
+
+#include <limits>
+
+namespace CPURDR
+{
+	static constexpr float POSITION_STEPS = 65535.0f;
+
+	struct OwnedQuantizedMeshData
+	{
+		std::vector<QuantizedVertex> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	Mesh QuantizeMesh(const Mesh& mesh)
+	{
+		if (mesh.IsQuantized() || mesh.vertices.empty()) return mesh;
+
+		glm::vec3 boundsMin(std::numeric_limits<float>::max());
+		glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			boundsMin = glm::min(boundsMin, vertex.position);
+			boundsMax = glm::max(boundsMax, vertex.position);
+		}
+
+		const glm::vec3 extent = boundsMax - boundsMin;
+		const glm::vec3 scale = extent / POSITION_STEPS;
+		// Flat axes encode as 0
+		const glm::vec3 inverseExtent = glm::vec3(
+			extent.x > 0.0f? 1.0f / extent.x : 0.0f,
+			extent.y > 0.0f? 1.0f / extent.y : 0.0f,
+			extent.z > 0.0f? 1.0f / extent.z : 0.0f);
+
+		auto data = std::make_shared<OwnedQuantizedMeshData>();
+		data->vertices.resize(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			const Vertex& vertex = mesh.vertices[i];
+			const glm::vec3 position = glm::clamp((vertex.position - boundsMin) * inverseExtent, 0.0f, 1.0f) * POSITION_STEPS + 0.5f;
+
+			QuantizedVertex& quantized = data->vertices[i];
+			quantized.position[0] = (uint16_t)position.x;
+			quantized.position[1] = (uint16_t)position.y;
+			quantized.position[2] = (uint16_t)position.z;
+			quantized.unused = 0;
+			quantized.normal = EncodeOctahedral(vertex.normal);
+			quantized.texcoord = glm::packHalf2x16(vertex.texcoord);
+		}
+		data->indices.assign(mesh.indices.begin(), mesh.indices.end());
+
+		std::span<const QuantizedVertex> vertices = data->vertices;
+		std::span<const unsigned int> indices = data->indices;
+		Mesh quantized(vertices, indices, boundsMin, scale, std::move(data));
+		// Bounds follow the rounded positions
+		if (mesh.meshlets) quantized.meshlets = BuildMeshlets(quantized);
+		return quantized;
+	}
+
+	Mesh DequantizeMesh(const Mesh& mesh)
+	{
+		if (!mesh.IsQuantized()) return mesh;
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh.quantizedVertices.size());
+		for (const QuantizedVertex& vertex : mesh.quantizedVertices)
+		{
+			vertices.push_back(DecodeVertex(vertex, mesh.positionOffset, mesh.positionScale));
+		}
+		// Decodes to the very positions the meshlets were bounded with
+		Mesh dequantized(std::move(vertices), std::vector<unsigned int>(mesh.indices.begin(), mesh.indices.end()));
+		dequantized.meshlets = mesh.meshlets;
+		return dequantized;
+	}
+}
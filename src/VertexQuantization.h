@@ -0,0 +1,53 @@
+#pragma once
+#include <cmath>
+
+#include "gtc/packing.hpp"
+#include "Model.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Vertex Quantization
+	// ===============
+	// Positions are 16-bit fractions of the mesh bounds, normals octahedral-mapped onto two snorm16 and
+	// texcoords half floats. Decoding is cheap enough to happen on every vertex fetch
+
+	inline uint32_t EncodeOctahedral(const glm::vec3& normal)
+	{
+		const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length <= 0.0f) return glm::packSnorm2x16(glm::vec2(0.0f));
+
+		glm::vec2 encoded = glm::vec2(normal) / length;
+		if (normal.z < 0.0f)
+		{
+			const glm::vec2 folded = 1.0f - glm::abs(glm::vec2(encoded.y, encoded.x));
+			encoded = glm::vec2(encoded.x >= 0.0f? folded.x : -folded.x, encoded.y >= 0.0f? folded.y : -folded.y);
+		}
+		return glm::packSnorm2x16(encoded);
+	}
+
+	inline glm::vec3 DecodeOctahedral(uint32_t packed)
+	{
+		const glm::vec2 encoded = glm::unpackSnorm2x16(packed);
+		glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		const float fold = std::max(-normal.z, 0.0f);
+		normal.x += normal.x >= 0.0f? -fold : fold;
+		normal.y += normal.y >= 0.0f? -fold : fold;
+		return glm::normalize(normal);
+	}
+
+	inline Vertex DecodeVertex(const QuantizedVertex& vertex, const glm::vec3& positionOffset, const glm::vec3& positionScale)
+	{
+		Vertex decoded;
+		decoded.position = positionOffset +
+			glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]) * positionScale;
+		decoded.texcoord = glm::unpackHalf2x16(vertex.texcoord);
+		decoded.normal = DecodeOctahedral(vertex.normal);
+		return decoded;
+	}
+
+	// Copies of the mesh in the other layout, the index data is copied too so the source storage can be freed.
+	// Quantizing drops the debug triangle colors and rebuilds any meshlets
+	Mesh QuantizeMesh(const Mesh& mesh);
+	Mesh DequantizeMesh(const Mesh& mesh);
+}
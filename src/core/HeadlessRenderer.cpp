@@ -0,0 +1,97 @@
+#include "HeadlessRenderer.h"
+
+#include "plog/Log.h"
+#include "SDL3/SDL.h"
+#include "../Camera.h"
+#include "../Scene.h"
+#include "../ecs/systems/TransformSystem.h"
+#include "../render/MaterialManager.h"
+#include "../render/ShaderManager.h"
+
+namespace CPURDR
+{
+	HeadlessRenderer::HeadlessRenderer(int width, int height, DepthFormat depthFormat):
+		m_Context(std::make_unique<Context>(width, height, depthFormat)),
+		m_RenderPipeline(std::make_unique<RenderPipeline>()),
+		m_TransformSystem(std::make_unique<TransformSystem>())
+	{
+		// Matches SDL_PIXELFORMAT_ABGR8888, which is what SDL_SaveBMP gets without a conversion
+		m_Context->SetColorFormat(ColorFormat::ABGR8888);
+	}
+
+	HeadlessRenderer::~HeadlessRenderer() = default;
+
+	void HeadlessRenderer::InitializeRenderResources()
+	{
+		static bool initialized = false;
+		if (initialized) return;
+
+		ShaderManager::GetInstance().Initialize();
+		MaterialManager::GetInstance().Initialize();
+		initialized = true;
+	}
+
+	void HeadlessRenderer::SetReversedZ(bool reversedZ)
+	{
+		m_Context->SetDepthFunction(reversedZ? DepthFunction::Greater : DepthFunction::Less);
+	}
+
+	void HeadlessRenderer::RenderFrame(Scene& scene, const Camera& camera)
+	{
+		m_TransformSystem->Update(scene.GetRegistry());
+
+		ClearValue clearValue;
+		clearValue.color = m_ClearColor;
+		clearValue.depth = m_Context->GetClearDepth();
+		m_Context->BeginRenderPass(clearValue);
+
+		m_RenderPipeline->Render(scene.GetRegistry(), m_Context.get(), camera);
+
+		m_Context->EndRenderPass();
+	}
+
+	bool HeadlessRenderer::SaveColorBuffer(const std::string& filepath) const
+	{
+		const Texture2D_RGBA* colorBuffer = m_Context->GetColorBuffer();
+		if (!colorBuffer)
+		{
+			return false;
+		}
+
+		const SDL_PixelFormat pixelFormat = m_Context->GetColorFormat() == ColorFormat::ABGR8888?
+			SDL_PIXELFORMAT_ABGR8888 : SDL_PIXELFORMAT_RGBA8888;
+		const int width = (int)colorBuffer->GetWidth();
+		const int height = (int)colorBuffer->GetHeight();
+
+		// The surface only borrows the pixels
+		SDL_Surface* surface = SDL_CreateSurfaceFrom(width, height, pixelFormat,
+			const_cast<uint32_t*>(colorBuffer->GetData()), width * (int)sizeof(uint32_t));
+		if (!surface)
+		{
+			PLOG_ERROR << "SDL_CreateSurfaceFrom failed: " << SDL_GetError();
+			return false;
+		}
+
+		const bool saved = SDL_SaveBMP(surface, filepath.c_str());
+		if (!saved)
+		{
+			PLOG_ERROR << "Failed to save " << filepath << ": " << SDL_GetError();
+		}
+		SDL_DestroySurface(surface);
+		return saved;
+	}
+
+	void HeadlessRenderer::ReadColorBuffer(Texture2D_RGBA& image) const
+	{
+		const Texture2D_RGBA* colorBuffer = m_Context->GetColorBuffer();
+		if (!colorBuffer)
+		{
+			image.Resize(0, 0);
+			return;
+		}
+
+		image.Resize(colorBuffer->GetWidth(), colorBuffer->GetHeight());
+		ConvertPixels(colorBuffer->GetData(), m_Context->GetColorFormat(),
+			image.GetData(), ColorFormat::RGBA8888, colorBuffer->GetSize());
+	}
+}
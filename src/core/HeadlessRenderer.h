@@ -0,0 +1,43 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "../render/Context.h"
+#include "../render/RenderPipeline.h"
+
+namespace CPURDR
+{
+	class Camera;
+	class Scene;
+	class TransformSystem;
+
+	// Renders a Scene into an offscreen Context, no window, GPU device or ImGui involved
+	class HeadlessRenderer
+	{
+	public:
+		HeadlessRenderer(int width, int height, DepthFormat depthFormat = DepthFormat::D32_Float);
+		~HeadlessRenderer();
+
+		// Registers the built-in shaders and materials, call once before loading scenes
+		static void InitializeRenderResources();
+
+		void SetClearColor(uint32_t color) {m_ClearColor = color;}
+		void SetReversedZ(bool reversedZ);
+
+		void RenderFrame(Scene& scene, const Camera& camera);
+
+		Context* GetContext() const {return m_Context.get();}
+		RenderPipeline* GetRenderPipeline() const {return m_RenderPipeline.get();}
+
+		// Writes the color buffer as a 32-bit BMP
+		bool SaveColorBuffer(const std::string& filepath) const;
+		// Copies the color buffer out as 0xRRGGBBAA
+		void ReadColorBuffer(Texture2D_RGBA& image) const;
+
+	private:
+		std::unique_ptr<Context> m_Context;
+		std::unique_ptr<RenderPipeline> m_RenderPipeline;
+		std::unique_ptr<TransformSystem> m_TransformSystem;
+		uint32_t m_ClearColor = 0x141414FF;
+	};
+}
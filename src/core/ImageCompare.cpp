@@ -0,0 +1,138 @@
+#include "ImageCompare.h"
+
+#include <cmath>
+#include <limits>
+
+#include "glm.hpp"
+#include "plog/Log.h"
+#include "SDL3/SDL.h"
+
+namespace CPURDR
+{
+	static glm::vec3 RGBToYIQ(uint32_t rgba)
+	{
+		const float r = (float)(rgba >> 24 & 0xFF);
+		const float g = (float)(rgba >> 16 & 0xFF);
+		const float b = (float)(rgba >> 8 & 0xFF);
+		return glm::vec3(
+			r * 0.29889531f + g * 0.58662247f + b * 0.11448223f,
+			r * 0.59597799f - g * 0.27417610f - b * 0.32180189f,
+			r * 0.21147017f - g * 0.52261711f + b * 0.31114694f);
+	}
+
+	float GetPerceptualDelta(uint32_t a, uint32_t b)
+	{
+		if ((a | 0xFF) == (b | 0xFF)) return 0.0f;
+
+		// Weighted distance of black against white
+		constexpr float MAX_DELTA = 35215.0f;
+
+		const glm::vec3 d = RGBToYIQ(a) - RGBToYIQ(b);
+		const float delta = 0.5053f * d.x * d.x + 0.299f * d.y * d.y + 0.1957f * d.z * d.z;
+		return std::min(std::sqrt(delta / MAX_DELTA), 1.0f);
+	}
+
+	ImageDiff CompareImages(const Texture2D_RGBA& actual, const Texture2D_RGBA& expected, float threshold,
+		Texture2D_RGBA* diffImage)
+	{
+		ImageDiff diff;
+		if (actual.GetWidth() != expected.GetWidth() || actual.GetHeight() != expected.GetHeight())
+		{
+			diff.sizeMismatch = true;
+			return diff;
+		}
+
+		const size_t count = actual.GetSize();
+		const uint32_t* actualPixels = actual.GetData();
+		const uint32_t* expectedPixels = expected.GetData();
+		uint32_t* diffPixels = nullptr;
+		if (diffImage)
+		{
+			diffImage->Resize(actual.GetWidth(), actual.GetHeight());
+			diffPixels = diffImage->GetData();
+		}
+
+		double squaredError = 0.0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint32_t a = actualPixels[i];
+			const uint32_t e = expectedPixels[i];
+			for (int shift = 8; shift < 32; shift += 8)
+			{
+				const double channel = (double)(a >> shift & 0xFF) - (double)(e >> shift & 0xFF);
+				squaredError += channel * channel;
+			}
+
+			const float delta = GetPerceptualDelta(a, e);
+			diff.maxDelta = std::max(diff.maxDelta, delta);
+			const bool different = delta > threshold;
+			diff.differentPixels += different;
+
+			if (diffPixels)
+			{
+				if (different)
+				{
+					const uint32_t red = 128 + (uint32_t)(delta * 127.0f);
+					diffPixels[i] = red << 24 | 0xFF;
+				}
+				else
+				{
+					const uint32_t gray = 192 + (uint32_t)(RGBToYIQ(e).x * 0.25f);
+					diffPixels[i] = gray << 24 | gray << 16 | gray << 8 | 0xFF;
+				}
+			}
+		}
+
+		diff.totalPixels = count;
+		const double mse = count > 0? squaredError / (double)(count * 3) : 0.0;
+		diff.psnr = mse > 0.0? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+		return diff;
+	}
+
+	bool LoadImageBMP(const std::string& filepath, Texture2D_RGBA& image)
+	{
+		SDL_Surface* loaded = SDL_LoadBMP(filepath.c_str());
+		if (!loaded)
+		{
+			PLOG_ERROR << "Failed to load " << filepath << ": " << SDL_GetError();
+			return false;
+		}
+
+		SDL_Surface* surface = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA8888);
+		SDL_DestroySurface(loaded);
+		if (!surface)
+		{
+			PLOG_ERROR << "Failed to convert " << filepath << ": " << SDL_GetError();
+			return false;
+		}
+
+		image.Resize(surface->w, surface->h);
+		for (int y = 0; y < surface->h; ++y)
+		{
+			const auto* row = (const uint32_t*)((const uint8_t*)surface->pixels + (size_t)y * surface->pitch);
+			std::copy(row, row + surface->w, &image(0, y));
+		}
+		SDL_DestroySurface(surface);
+		return true;
+	}
+
+	bool SaveImageBMP(const std::string& filepath, const Texture2D_RGBA& image)
+	{
+		// The surface only borrows the pixels
+		SDL_Surface* surface = SDL_CreateSurfaceFrom((int)image.GetWidth(), (int)image.GetHeight(),
+			SDL_PIXELFORMAT_RGBA8888, const_cast<uint32_t*>(image.GetData()), (int)(image.GetWidth() * sizeof(uint32_t)));
+		if (!surface)
+		{
+			PLOG_ERROR << "SDL_CreateSurfaceFrom failed: " << SDL_GetError();
+			return false;
+		}
+
+		const bool saved = SDL_SaveBMP(surface, filepath.c_str());
+		if (!saved)
+		{
+			PLOG_ERROR << "Failed to save " << filepath << ": " << SDL_GetError();
+		}
+		SDL_DestroySurface(surface);
+		return saved;
+	}
+}
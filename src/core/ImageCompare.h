@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "../Texture2D.h"
+
+namespace CPURDR
+{
+	struct ImageDiff
+	{
+		uint64_t totalPixels = 0;
+		uint64_t differentPixels = 0;
+		// Perceptual delta of the worst pixel, 0 ~ 1
+		float maxDelta = 0.0f;
+		// Over RGB, infinite for identical images
+		double psnr = 0.0;
+		bool sizeMismatch = false;
+
+		double GetDifferentRatio() const {return totalPixels > 0? (double)differentPixels / (double)totalPixels : 0.0;}
+	};
+
+	// ===============
+	// Image Compare
+	// ===============
+	// Images are 0xRRGGBBAA. The per pixel delta is the weighted YIQ distance from
+	// Kotsarenko & Ramos, "Measuring perceived color difference using YIQ NTSC transmission color space",
+	// normalized so black against white is 1. Alpha is ignored, rendered frames are opaque
+	float GetPerceptualDelta(uint32_t a, uint32_t b);
+
+	// Pixels whose delta exceeds threshold count as different. diffImage, when given, is resized to the
+	// input and shows the expected image faded out with different pixels in red, brighter for larger deltas
+	ImageDiff CompareImages(const Texture2D_RGBA& actual, const Texture2D_RGBA& expected, float threshold,
+		Texture2D_RGBA* diffImage = nullptr);
+
+	bool LoadImageBMP(const std::string& filepath, Texture2D_RGBA& image);
+	bool SaveImageBMP(const std::string& filepath, const Texture2D_RGBA& image);
+}
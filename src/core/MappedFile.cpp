@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#include "plog/Log.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CPURDR
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+#if defined(_WIN32)
+	bool MappedFile::Open(const std::string& filepath)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			PLOG_ERROR << "Failed to open " << filepath << " for mapping";
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			PLOG_ERROR << "Can't map " << filepath << ": empty or unreadable";
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		const void* data = mapping? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!data)
+		{
+			PLOG_ERROR << "Failed to map " << filepath << ", error " << GetLastError();
+			if (mapping) CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		m_File = file;
+		m_Mapping = mapping;
+		m_Data = static_cast<const uint8_t*>(data);
+		m_Size = (size_t)size.QuadPart;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data) UnmapViewOfFile(m_Data);
+		if (m_Mapping) CloseHandle(m_Mapping);
+		if (m_File) CloseHandle(m_File);
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Mapping = nullptr;
+		m_File = nullptr;
+	}
+#else
+	bool MappedFile::Open(const std::string& filepath)
+	{
+		Close();
+
+		const int file = open(filepath.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			PLOG_ERROR << "Failed to open " << filepath << " for mapping";
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || info.st_size == 0)
+		{
+			PLOG_ERROR << "Can't map " << filepath << ": empty or unreadable";
+			close(file);
+			return false;
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (data == MAP_FAILED)
+		{
+			PLOG_ERROR << "Failed to map " << filepath;
+			return false;
+		}
+
+		m_Data = static_cast<const uint8_t*>(data);
+		m_Size = (size_t)info.st_size;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data)
+		{
+			munmap(const_cast<uint8_t*>(m_Data), m_Size);
+		}
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CPURDR
+{
+	// A whole file mapped read-only. Pages are read in on first access, so opening costs the same for any size
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Returns false and logs when the file can't be opened or mapped. Empty files can't be mapped
+		bool Open(const std::string& filepath);
+		void Close();
+
+		bool IsOpen() const {return m_Data != nullptr;}
+		const uint8_t* GetData() const {return m_Data;}
+		size_t GetSize() const {return m_Size;}
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+#if defined(_WIN32)
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,218 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "plog/Log.h"
+
+namespace CPURDR
+{
+	std::atomic<bool> Profiler::s_Enabled{false};
+	thread_local Profiler::ThreadRing* Profiler::t_Ring = nullptr;
+	thread_local std::string Profiler::t_ThreadName;
+
+	Profiler& Profiler::GetInstance()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler::Profiler()
+	{
+		m_MsPerTick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+	}
+
+	void Profiler::SetEnabled(bool enabled)
+	{
+		s_Enabled.store(enabled, std::memory_order_relaxed);
+	}
+
+	Profiler::ThreadRing* Profiler::GetThreadRing()
+	{
+		// Rings are never freed, a thread that exits leaves its last events to be drained
+		if (!t_Ring)
+		{
+			std::lock_guard<std::mutex> lock(m_RingMutex);
+			m_Rings.push_back(std::make_unique<ThreadRing>());
+			t_Ring = m_Rings.back().get();
+			t_Ring->threadIndex = (uint32_t)(m_Rings.size() - 1);
+			t_Ring->name = t_ThreadName.empty()? "Thread " + std::to_string(t_Ring->threadIndex) : t_ThreadName;
+		}
+		return t_Ring;
+	}
+
+	void Profiler::SetThreadName(const std::string& name)
+	{
+		t_ThreadName = name;
+		if (t_Ring)
+		{
+			std::lock_guard<std::mutex> lock(m_RingMutex);
+			t_Ring->name = name;
+		}
+	}
+
+	uint32_t Profiler::PushDepth()
+	{
+		return GetThreadRing()->depth++;
+	}
+
+	void Profiler::PopDepth()
+	{
+		GetThreadRing()->depth--;
+	}
+
+	void Profiler::Record(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		ThreadRing* ring = GetThreadRing();
+
+		const uint32_t head = ring->head.load(std::memory_order_relaxed);
+		const uint32_t tail = ring->tail.load(std::memory_order_acquire);
+		if (head - tail >= RING_CAPACITY)
+		{
+			ring->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		ProfileEvent& event = ring->events[head & (RING_CAPACITY - 1)];
+		event.name = name;
+		event.start = start;
+		event.end = end;
+		event.threadIndex = ring->threadIndex;
+		event.depth = depth;
+		ring->head.store(head + 1, std::memory_order_release);
+	}
+
+	void Profiler::Drain(std::vector<ProfileEvent>& out)
+	{
+		std::lock_guard<std::mutex> lock(m_RingMutex);
+		for (auto& ring : m_Rings)
+		{
+			const uint32_t head = ring->head.load(std::memory_order_acquire);
+			uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+			for (; tail != head; ++tail)
+			{
+				out.push_back(ring->events[tail & (RING_CAPACITY - 1)]);
+			}
+			ring->tail.store(tail, std::memory_order_release);
+		}
+	}
+
+	void Profiler::BeginFrame()
+	{
+		m_FrameStart = SDL_GetPerformanceCounter();
+	}
+
+	void Profiler::EndFrame()
+	{
+		if (!IsEnabled() || m_FrameStart == 0) return;
+
+		m_DrainBuffer.clear();
+		Drain(m_DrainBuffer);
+
+		if (m_Capturing)
+		{
+			const size_t room = MAX_CAPTURE_EVENTS - m_CaptureEvents.size();
+			const size_t count = std::min(room, m_DrainBuffer.size());
+			m_CaptureEvents.insert(m_CaptureEvents.end(), m_DrainBuffer.begin(), m_DrainBuffer.begin() + count);
+			if (count < m_DrainBuffer.size())
+			{
+				PLOG_WARNING << "Profiler capture is full, stopping at " << m_CaptureEvents.size() << " events";
+				m_Capturing = false;
+			}
+		}
+
+		if (m_Paused) return;
+
+		m_Frames.push_back({m_FrameStart, SDL_GetPerformanceCounter()});
+		m_Events.insert(m_Events.end(), m_DrainBuffer.begin(), m_DrainBuffer.end());
+
+		if (m_Frames.size() > MAX_HISTORY_FRAMES)
+		{
+			m_Frames.pop_front();
+			const uint64_t oldest = m_Frames.front().start;
+			std::erase_if(m_Events, [oldest](const ProfileEvent& event) {return event.end < oldest;});
+		}
+	}
+
+	std::vector<std::string> Profiler::GetThreadNames() const
+	{
+		std::lock_guard<std::mutex> lock(m_RingMutex);
+		std::vector<std::string> names;
+		names.reserve(m_Rings.size());
+		for (const auto& ring : m_Rings)
+		{
+			names.push_back(ring->name);
+		}
+		return names;
+	}
+
+	uint64_t Profiler::GetDroppedEventCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_RingMutex);
+		uint64_t dropped = 0;
+		for (const auto& ring : m_Rings)
+		{
+			dropped += ring->dropped.load(std::memory_order_relaxed);
+		}
+		return dropped;
+	}
+
+	void Profiler::StartCapture()
+	{
+		m_CaptureEvents.clear();
+		m_Capturing = true;
+	}
+
+	void Profiler::StopCapture()
+	{
+		m_Capturing = false;
+	}
+
+	bool Profiler::ExportChromeTrace(const std::string& filepath) const
+	{
+		std::ofstream file(filepath);
+		if (!file.is_open())
+		{
+			PLOG_ERROR << "Failed to open " << filepath;
+			return false;
+		}
+
+		uint64_t origin = UINT64_MAX;
+		for (const ProfileEvent& event : m_CaptureEvents)
+		{
+			origin = std::min(origin, event.start);
+		}
+
+		// Complete events("X"), timestamps and durations in microseconds
+		const double usPerTick = m_MsPerTick * 1000.0;
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file.setf(std::ios::fixed);
+		file.precision(3);
+
+		const std::vector<std::string> threadNames = GetThreadNames();
+		for (size_t i = 0; i < threadNames.size(); ++i)
+		{
+			file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+				<< ",\"args\":{\"name\":\"" << threadNames[i] << "\"}},\n";
+		}
+
+		for (size_t i = 0; i < m_CaptureEvents.size(); ++i)
+		{
+			const ProfileEvent& event = m_CaptureEvents[i];
+			file << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadIndex
+				<< ",\"ts\":" << (double)(event.start - origin) * usPerTick
+				<< ",\"dur\":" << (double)(event.end - event.start) * usPerTick << "},\n";
+		}
+
+		// Closes the trailing comma
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPURenderer\"}}\n]}\n";
+
+		if (!file.good())
+		{
+			PLOG_ERROR << "Failed to write " << filepath;
+			return false;
+		}
+		PLOG_INFO << "Exported " << m_CaptureEvents.size() << " profiler events to " << filepath;
+		return true;
+	}
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "SDL3/SDL_timer.h"
+
+// Build with CPURDR_ENABLE_PROFILER to compile the scopes in, they can then be switched on at runtime.
+// Names must outlive the profiler, pass string literals
+#ifdef CPURDR_ENABLE_PROFILER
+	#define CPURDR_PROFILE_CONCAT_INNER(a, b) a##b
+	#define CPURDR_PROFILE_CONCAT(a, b) CPURDR_PROFILE_CONCAT_INNER(a, b)
+	#define PROFILE_SCOPE(name) ::CPURDR::ProfileScope CPURDR_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+	#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+#endif
+
+namespace CPURDR
+{
+	struct ProfileEvent
+	{
+		const char* name = nullptr;
+		uint64_t start = 0;
+		uint64_t end = 0;
+		uint32_t threadIndex = 0;
+		uint32_t depth = 0;
+	};
+
+	// Main thread frame boundaries, in performance counter ticks
+	struct ProfileFrame
+	{
+		uint64_t start = 0;
+		uint64_t end = 0;
+	};
+
+	// ===============
+	// Profiler
+	// ===============
+	// Each thread records into its own single-producer single-consumer ring, so a scope costs two counter
+	// reads and a store. EndFrame() drains every ring on the main thread into the frame history.
+	// A full ring drops events instead of blocking, see GetDroppedEventCount()
+	class Profiler
+	{
+	public:
+		static Profiler& GetInstance();
+
+		static bool IsEnabled() {return s_Enabled.load(std::memory_order_relaxed);}
+		void SetEnabled(bool enabled);
+
+		// Shown as the lane name in the timeline and the trace, call from the thread itself
+		void SetThreadName(const std::string& name);
+
+		void BeginFrame();
+		void EndFrame();
+
+		// While paused, EndFrame() keeps draining but the history stays as it is
+		void SetPaused(bool paused) {m_Paused = paused;}
+		bool IsPaused() const {return m_Paused;}
+
+		const std::deque<ProfileFrame>& GetFrames() const {return m_Frames;}
+		// In the order their scopes closed, covers the frames in GetFrames()
+		const std::vector<ProfileEvent>& GetEvents() const {return m_Events;}
+		std::vector<std::string> GetThreadNames() const;
+		uint64_t GetDroppedEventCount() const;
+
+		// Capture keeps every event from StartCapture() to StopCapture() for ExportChromeTrace()
+		void StartCapture();
+		void StopCapture();
+		bool IsCapturing() const {return m_Capturing;}
+		size_t GetCapturedEventCount() const {return m_CaptureEvents.size();}
+		// chrome://tracing and Perfetto JSON
+		bool ExportChromeTrace(const std::string& filepath) const;
+
+		double TicksToMs(uint64_t ticks) const {return (double)ticks * m_MsPerTick;}
+
+		void Record(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+		uint32_t PushDepth();
+		void PopDepth();
+
+		static constexpr size_t MAX_HISTORY_FRAMES = 240;
+		static constexpr size_t MAX_CAPTURE_EVENTS = 4 * 1024 * 1024;
+
+	private:
+		Profiler();
+		~Profiler() = default;
+
+		Profiler(const Profiler&) = delete;
+		Profiler& operator=(const Profiler&) = delete;
+
+		static constexpr uint32_t RING_CAPACITY = 1 << 15;
+
+		struct ThreadRing
+		{
+			std::array<ProfileEvent, RING_CAPACITY> events;
+			std::atomic<uint32_t> head{0}; // written by the owning thread
+			std::atomic<uint32_t> tail{0}; // written by the draining thread
+			std::atomic<uint64_t> dropped{0};
+			uint32_t threadIndex = 0;
+			uint32_t depth = 0;
+			std::string name;
+		};
+
+		ThreadRing* GetThreadRing();
+		void Drain(std::vector<ProfileEvent>& out);
+
+		static std::atomic<bool> s_Enabled;
+		// Allocated on the thread's first recorded event
+		static thread_local ThreadRing* t_Ring;
+		static thread_local std::string t_ThreadName;
+
+		mutable std::mutex m_RingMutex;
+		std::vector<std::unique_ptr<ThreadRing>> m_Rings;
+
+		std::deque<ProfileFrame> m_Frames;
+		std::vector<ProfileEvent> m_Events;
+		std::vector<ProfileEvent> m_DrainBuffer;
+		uint64_t m_FrameStart = 0;
+		bool m_Paused = false;
+
+		std::vector<ProfileEvent> m_CaptureEvents;
+		bool m_Capturing = false;
+
+		double m_MsPerTick = 0.0;
+	};
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(const char* name)
+		{
+			if (!Profiler::IsEnabled()) return;
+
+			m_Name = name;
+			m_Depth = Profiler::GetInstance().PushDepth();
+			m_Start = Now();
+		}
+
+		~ProfileScope()
+		{
+			if (!m_Name) return;
+
+			const uint64_t end = Now();
+			Profiler& profiler = Profiler::GetInstance();
+			profiler.PopDepth();
+			profiler.Record(m_Name, m_Start, end, m_Depth);
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		static uint64_t Now() {return SDL_GetPerformanceCounter();}
+
+		const char* m_Name = nullptr;
+		uint64_t m_Start = 0;
+		uint32_t m_Depth = 0;
+	};
+}
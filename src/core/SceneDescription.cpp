@@ -0,0 +1,236 @@
+#include "SceneDescription.h"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "plog/Log.h"
+#include "../Camera.h"
+#include "../Primitives.h"
+#include "../Scene.h"
+#include "../ecs/components/Light.h"
+#include "../ecs/components/MeshRenderer.h"
+#include "../ecs/components/Transform.h"
+#include "../render/MaterialManager.h"
+
+namespace CPURDR
+{
+	static bool ReadVec3(std::istringstream& stream, glm::vec3& value)
+	{
+		return static_cast<bool>(stream >> value.x >> value.y >> value.z);
+	}
+
+	static bool CreatePrimitive(const std::string& name, std::vector<Mesh>& meshes)
+	{
+		if (name == "cube")          meshes.push_back(Primitives::Cube());
+		else if (name == "sphere")   meshes.push_back(Primitives::Sphere());
+		else if (name == "plane")    meshes.push_back(Primitives::Plane());
+		else if (name == "quad")     meshes.push_back(Primitives::Quad());
+		else if (name == "cylinder") meshes.push_back(Primitives::Cylinder());
+		else if (name == "capsule")  meshes.push_back(Primitives::Capsule());
+		else return false;
+		return true;
+	}
+
+	// Reads the optional attributes of a mesh/primitive statement
+	static bool ReadObjectAttributes(std::istringstream& stream, Transform& transform, MeshRenderer& renderer)
+	{
+		std::string key;
+		while (stream >> key)
+		{
+			if (key == "position")
+			{
+				if (!ReadVec3(stream, transform.position)) return false;
+			}
+			else if (key == "rotation")
+			{
+				glm::vec3 euler;
+				if (!ReadVec3(stream, euler)) return false;
+				transform.SetRotationEuler(euler.x, euler.y, euler.z);
+			}
+			else if (key == "scale")
+			{
+				// Either uniform or per axis
+				float x;
+				if (!(stream >> x)) return false;
+				transform.scale = glm::vec3(x);
+
+				// A failed float extraction leaves the next keyword in the stream
+				float y, z;
+				if (stream >> y)
+				{
+					if (!(stream >> z)) return false;
+					transform.scale = glm::vec3(x, y, z);
+				}
+				else
+				{
+					stream.clear();
+				}
+			}
+			else if (key == "material")
+			{
+				std::string material;
+				if (!(stream >> material)) return false;
+				if (material == "default")
+					renderer.materialId = MaterialManager::GetInstance().GetDefaultMaterial();
+				else if (material == "pbr")
+					renderer.materialId = MaterialManager::GetInstance().GetDefaultPBRMaterial();
+				else
+					return false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		transform.MarkDirty();
+		return true;
+	}
+
+	bool SceneDescription::LoadFromFile(const std::string& filepath, Scene& scene)
+	{
+		std::ifstream file(filepath);
+		if (!file.is_open())
+		{
+			PLOG_ERROR << "Failed to open scene description: " << filepath;
+			return false;
+		}
+
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+		return LoadFromString(buffer.str(), scene, filepath);
+	}
+
+	bool SceneDescription::LoadFromString(const std::string& source, Scene& scene, const std::string& sourceName)
+	{
+		std::istringstream lines(source);
+		// Repeated primitives of one description share an asset
+		std::unordered_map<std::string, MeshAssetHandle> primitives;
+		std::string line;
+		int lineNumber = 0;
+
+		while (std::getline(lines, line))
+		{
+			lineNumber++;
+
+			const size_t comment = line.find('#');
+			if (comment != std::string::npos)
+			{
+				line.erase(comment);
+			}
+
+			std::istringstream stream(line);
+			std::string statement;
+			if (!(stream >> statement)) continue;
+
+			bool ok = true;
+			if (statement == "resolution")
+			{
+				ok = static_cast<bool>(stream >> width >> height) && width > 0 && height > 0;
+			}
+			else if (statement == "clear")
+			{
+				ok = static_cast<bool>(stream >> std::hex >> clearColor);
+			}
+			else if (statement == "camera")
+			{
+				std::string key;
+				while (ok && stream >> key)
+				{
+					if (key == "position")       ok = ReadVec3(stream, cameraPosition);
+					else if (key == "target")    ok = ReadVec3(stream, cameraTarget);
+					else if (key == "fov")       ok = static_cast<bool>(stream >> cameraFOV);
+					else if (key == "near")      ok = static_cast<bool>(stream >> cameraNear);
+					else if (key == "far")       ok = static_cast<bool>(stream >> cameraFar);
+					else if (key == "reversedz") reversedZ = true;
+					else ok = false;
+				}
+			}
+			else if (statement == "light")
+			{
+				entt::entity entity = scene.CreateDirectionalLightEntity("Directional Light");
+				auto& registry = scene.GetRegistry();
+				auto& light = registry.get<DirectionalLight>(entity);
+				auto& transform = registry.get<Transform>(entity);
+
+				std::string key;
+				while (ok && stream >> key)
+				{
+					if (key == "rotation")
+					{
+						glm::vec3 euler;
+						ok = ReadVec3(stream, euler);
+						transform.SetRotationEuler(euler.x, euler.y, euler.z);
+					}
+					else if (key == "color")     ok = ReadVec3(stream, light.color);
+					else if (key == "intensity") ok = static_cast<bool>(stream >> light.intensity);
+					else ok = false;
+				}
+				transform.MarkDirty();
+			}
+			else if (statement == "mesh" || statement == "stream" || statement == "primitive")
+			{
+				std::string name;
+				ok = static_cast<bool>(stream >> name);
+
+				entt::entity entity = entt::null;
+				if (ok && statement == "mesh")
+				{
+					entity = scene.CreateMeshEntity(name, name);
+				}
+				else if (ok && statement == "stream")
+				{
+					entity = scene.CreateStreamedMeshEntity(name, name);
+				}
+				else if (ok)
+				{
+					MeshAssetHandle& asset = primitives[name];
+					if (!asset)
+					{
+						std::vector<Mesh> meshes;
+						ok = CreatePrimitive(name, meshes);
+						if (ok) asset = CreateMeshAsset(std::move(meshes));
+					}
+					if (ok)
+					{
+						entity = scene.CreateMeshEntity(name, MeshFilter(asset));
+					}
+				}
+
+				// A scene missing one of its meshes would still render, fail rather than draw something else
+				if (ok && !scene.GetRegistry().get<MeshFilter>(entity).asset)
+				{
+					PLOG_ERROR << sourceName << "(" << lineNumber << "): failed to load mesh " << name;
+					return false;
+				}
+
+				if (ok)
+				{
+					auto& registry = scene.GetRegistry();
+					ok = ReadObjectAttributes(stream, registry.get<Transform>(entity), registry.get<MeshRenderer>(entity));
+				}
+			}
+			else
+			{
+				ok = false;
+			}
+
+			if (!ok)
+			{
+				PLOG_ERROR << sourceName << "(" << lineNumber << "): invalid statement: " << line;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void SceneDescription::ApplyToCamera(Camera& camera) const
+	{
+		camera.SetPosition(cameraPosition);
+		camera.SetFOV(cameraFOV);
+		camera.SetClipPlanes(cameraNear, cameraFar);
+		camera.SetReversedZ(reversedZ);
+		camera.LookAt(cameraTarget);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+
+#include "glm.hpp"
+
+namespace CPURDR
+{
+	class Camera;
+	class Scene;
+
+	// ===============
+	// Scene Description
+	// ===============
+	// Plain text, one statement per line, '#' starts a comment. Attributes are optional keyword/value pairs
+	//
+	// resolution <width> <height>
+	// clear <0xRRGGBBAA>
+	// camera [position x y z] [target x y z] [fov degrees] [near n] [far f] [reversedz]
+	// light [rotation pitch yaw roll] [color r g b] [intensity i]
+	// mesh <path> [position x y z] [rotation pitch yaw roll] [scale s | scale x y z] [material default|pbr]
+	// primitive <cube|sphere|plane|quad|cylinder|capsule> [same attributes as mesh]
+	// stream <path> [same attributes as mesh], a mesh whose levels of detail are paged in and out, see MeshResidency.h
+	struct SceneDescription
+	{
+		int width = 1280;
+		int height = 720;
+		uint32_t clearColor = 0x141414FF;
+
+		glm::vec3 cameraPosition = glm::vec3(0.0f, 0.0f, 5.0f);
+		glm::vec3 cameraTarget = glm::vec3(0.0f);
+		float cameraFOV = 60.0f;
+		float cameraNear = 0.1f;
+		float cameraFar = 100.0f;
+		bool reversedZ = false;
+
+		// Populates scene, returns false and logs the offending line on a parse error
+		bool LoadFromFile(const std::string& filepath, Scene& scene);
+		bool LoadFromString(const std::string& source, Scene& scene, const std::string& sourceName = "<string>");
+
+		void ApplyToCamera(Camera& camera) const;
+	};
+}
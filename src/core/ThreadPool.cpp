@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+
+#include "Profiler.h"
+#include "plog/Log.h"
+
+namespace CPURDR
+{
+	ThreadPool& ThreadPool::GetInstance()
+	{
+		// Leave one hardware thread for the main thread
+		static ThreadPool instance(std::max(1u, std::thread::hardware_concurrency()) - 1, "Worker");
+		return instance;
+	}
+
+	ThreadPool& ThreadPool::GetImportInstance()
+	{
+		// Half the hardware threads, imports shouldn't starve the frame
+		static ThreadPool instance(std::thread::hardware_concurrency() / 2, "Import Worker");
+		return instance;
+	}
+
+	ThreadPool::ThreadPool(size_t workerCount, const std::string& name)
+	{
+		m_Workers.reserve(workerCount);
+		for (size_t i = 0; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back([this, i, name]()
+			{
+				Profiler::GetInstance().SetThreadName(name + " " + std::to_string(i));
+				WorkerLoop();
+			});
+		}
+		PLOG_INFO << "ThreadPool started with " << workerCount << " " << name << " threads";
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			if (worker.joinable())
+			{
+				worker.join();
+			}
+		}
+	}
+
+	void ThreadPool::Enqueue(std::function<void()> job)
+	{
+		if (m_Workers.empty())
+		{
+			job();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push(std::move(job));
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Condition.wait(lock, [this]() {return m_Stopping || !m_Jobs.empty();});
+				if (m_Stopping && m_Jobs.empty())
+				{
+					return;
+				}
+				job = std::move(m_Jobs.front());
+				m_Jobs.pop();
+			}
+			job();
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace CPURDR
+{
+	class ThreadPool
+	{
+	public:
+		static ThreadPool& GetInstance();
+		// Separate workers for mesh import and streaming, so their long jobs never queue ahead of a frame's
+		// jobs. The OS shares the cores between both pools
+		static ThreadPool& GetImportInstance();
+
+		size_t GetWorkerCount() const {return m_Workers.size();}
+
+		template<typename Func>
+		auto Submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>>
+		{
+			using ResultType = std::invoke_result_t<std::decay_t<Func>>;
+			auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+			std::future<ResultType> future = task->get_future();
+			Enqueue([task]() {(*task)();});
+			return future;
+		}
+
+		// Splits [begin, end) into chunks of at least minChunk and runs func(chunkBegin, chunkEnd)
+		// on the workers and the calling thread, returns once every chunk is done
+		template<typename Func>
+		void ParallelFor(size_t begin, size_t end, size_t minChunk, Func&& func)
+		{
+			if (begin >= end) return;
+
+			const size_t count = end - begin;
+			const size_t maxChunks = GetWorkerCount() + 1;
+			const size_t chunkCount = std::clamp(count / std::max<size_t>(minChunk, 1), (size_t)1, maxChunks);
+			if (chunkCount == 1)
+			{
+				func(begin, end);
+				return;
+			}
+
+			const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+			const size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+			// The calling thread and helpers queued for the workers claim chunks in order, so the caller only
+			// ever waits for chunks already running, never for unrelated jobs queued ahead of the helpers.
+			// A helper that starts once every chunk is claimed returns without touching func
+			struct Group
+			{
+				std::atomic<size_t> next = 0;
+				std::atomic<size_t> remaining = 0;
+			};
+			auto group = std::make_shared<Group>();
+			group->remaining = chunks;
+			auto runChunks = [group, &func, begin, end, chunkSize, chunks]()
+			{
+				for (size_t chunk = group->next.fetch_add(1); chunk < chunks; chunk = group->next.fetch_add(1))
+				{
+					const size_t chunkBegin = begin + chunk * chunkSize;
+					func(chunkBegin, std::min(chunkBegin + chunkSize, end));
+					if (group->remaining.fetch_sub(1) == 1)
+					{
+						group->remaining.notify_all();
+					}
+				}
+			};
+
+			for (size_t helper = 1; helper < chunks; ++helper)
+			{
+				Enqueue(runChunks);
+			}
+			runChunks();
+
+			for (size_t left = group->remaining.load(); left != 0; left = group->remaining.load())
+			{
+				group->remaining.wait(left);
+			}
+		}
+
+	private:
+		ThreadPool(size_t workerCount, const std::string& name);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		void Enqueue(std::function<void()> job);
+		void WorkerLoop();
+
+		std::vector<std::thread> m_Workers;
+		std::queue<std::function<void()>> m_Jobs;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Stopping = false;
+	};
+}
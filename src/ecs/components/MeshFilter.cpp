@@ -1,27 +1,20 @@
 #include "MeshFilter.h"
-#include "assimp/Importer.hpp"
-#include "assimp/postprocess.h"
-#include "plog/Log.h"
 
 namespace CPURDR
 {
+	const std::vector<Mesh>& MeshFilter::GetMeshes() const
+	{
+		static const std::vector<Mesh> empty;
+		return asset? asset->meshes : empty;
+	}
+
 	size_t MeshFilter::GetTotalVertexCount() const
 	{
-		size_t count = 0;
-		for (const auto& mesh: meshes)
-		{
-			count += mesh.vertices.size();
-		}
-		return count;
+		return asset? asset->GetVertexCount() : 0;
 	}
 
 	size_t MeshFilter::GetTotalTriangleCount() const
 	{
-		size_t count = 0;
-		for (const auto& mesh: meshes)
-		{
-			count += mesh.indices.size() / 3;
-		}
-		return count;
+		return asset? asset->GetTriangleCount() : 0;
 	}
 }
@@ -1,16 +1,21 @@
 #pragma once
 #include <vector>
-#include "../../Model.h"
+#include "../../MeshAsset.h"
 
 namespace CPURDR
 {
+	// Copying a MeshFilter shares its asset, instances of a model cost no mesh memory
 	struct MeshFilter
 	{
-		std::vector<Mesh> meshes;
+		MeshAssetHandle asset;
 
 		MeshFilter() = default;
-		explicit MeshFilter(const std::vector<Mesh>& m): meshes(m){}
-		explicit MeshFilter(std::vector<Mesh>&& m): meshes(std::move(m)){}
+		explicit MeshFilter(MeshAssetHandle asset): asset(std::move(asset)){}
+		// Wraps meshes in a new asset of their own
+		explicit MeshFilter(std::vector<Mesh> meshes): asset(CreateMeshAsset(std::move(meshes))){}
+
+		// Empty while no asset is set
+		const std::vector<Mesh>& GetMeshes() const;
 
 		size_t GetTotalVertexCount() const;
 		size_t GetTotalTriangleCount() const;
@@ -0,0 +1,20 @@
+#pragma once
+#include "glm.hpp"
+
+namespace CPURDR
+{
+	// World space matrices of an entity as the renderer reads them. TransformSystem rebuilds it only when the
+	// Transform changed, so a static entity costs no matrix inversion per frame
+	struct RenderTransform
+	{
+		glm::mat4 objectToWorld = glm::mat4(1.0f);
+		glm::mat4 worldToObject = glm::mat4(1.0f);
+		glm::mat3 objectToWorldNormal = glm::mat3(1.0f);
+
+		RenderTransform() = default;
+		explicit RenderTransform(const glm::mat4& objectToWorld):
+			objectToWorld(objectToWorld),
+			worldToObject(glm::inverse(objectToWorld)),
+			objectToWorldNormal(glm::transpose(glm::mat3(worldToObject))){}
+	};
+}
@@ -50,7 +50,7 @@ namespace CPURDR
 		glm::mat4 viewMatrix = camera.GetViewMatrix();
 		glm::mat4 projectionMatrix = camera.GetProjectionMatrix(aspectRatio);
 
-		for (const auto& mesh: meshFilter.meshes)
+		for (const auto& mesh: meshFilter.GetMeshes())
 		{
 			DrawMesh(mesh, modelMatrix, viewMatrix, projectionMatrix, context, 0xFFFFFFFF);
 		}
@@ -66,14 +66,13 @@ namespace CPURDR
 
 		glm::mat4 mvpMatrix = projectionMatrix * viewMatrix * modelMatrix;
 
-		const auto& vertices = mesh.vertices;
 		const auto& indices = mesh.indices;
 
 		for (size_t j = 0, t = 0; j < indices.size(); j+=3, t++)
 		{
-			glm::vec3 p0 = vertices[indices[j]].position;
-			glm::vec3 p1 = vertices[indices[j + 1]].position;
-			glm::vec3 p2 = vertices[indices[j + 2]].position;
+			glm::vec3 p0 = mesh.GetPosition(indices[j]);
+			glm::vec3 p1 = mesh.GetPosition(indices[j + 1]);
+			glm::vec3 p2 = mesh.GetPosition(indices[j + 2]);
 
 			glm::vec4 clip0 = mvpMatrix * glm::vec4(p0, 1.0f);
 			glm::vec4 clip1 = mvpMatrix * glm::vec4(p1, 1.0f);
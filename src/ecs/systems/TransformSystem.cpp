@@ -3,11 +3,14 @@
 #include "gtx/matrix_decompose.hpp"
 
 #include "../components/Hierarchy.h"
+#include "../components/RenderTransform.h"
+#include "../../core/Profiler.h"
 
 namespace CPURDR
 {
 	void TransformSystem::Update(entt::registry& registry)
 	{
+		PROFILE_SCOPE("TransformSystem::Update");
 		auto transformView = registry.view<Transform>();
 
 		for (auto entity: transformView)
@@ -33,7 +36,12 @@ namespace CPURDR
 		bool needsUpdate = transform->isDirty || parentDirty;
 		UpdateWorldTransform(*transform, parentWorldMatrix, parentDirty);
 
-		glm::mat4 currentWorldMatrix = transform->GetWorldModelMatrix();
+		const RenderTransform* renderTransform = registry.try_get<RenderTransform>(entity);
+		if (!renderTransform || needsUpdate)
+		{
+			renderTransform = &registry.emplace_or_replace<RenderTransform>(entity, transform->GetWorldModelMatrix());
+		}
+		const glm::mat4 currentWorldMatrix = renderTransform->objectToWorld;
 
 		auto* hierarchy = registry.try_get<Hierarchy>(entity);
 		if (hierarchy && hierarchy->HasChildren())
@@ -12,6 +12,7 @@ namespace CPURDR
 		TransformSystem() = default;
 		~TransformSystem() = default;
 
+		// Also keeps the RenderTransform of every entity current
 		void Update(entt::registry& registry);
 	private:
 		// Update transforms recursively
@@ -0,0 +1,68 @@
+#include "ColorFormat.h"
+
+#include <cstring>
+
+#include "../core/ThreadPool.h"
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define CPURDR_COLOR_SSSE3 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CPURDR_COLOR_SSE2 1
+#endif
+
+namespace CPURDR
+{
+	// Below this the job overhead outweighs the copy
+	static constexpr size_t PARALLEL_CHUNK_PIXELS = 64 * 1024;
+
+	static void SwapColorChannelsSpan(const uint32_t* src, uint32_t* dst, size_t count)
+	{
+		size_t i = 0;
+#if defined(CPURDR_COLOR_SSSE3)
+		// Reverse the bytes of every 32-bit lane
+		const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(pixels, shuffle));
+		}
+#elif defined(CPURDR_COLOR_SSE2)
+		// Swap bytes within 16-bit halves, then swap the halves
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+			pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+			pixels = _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(2, 3, 0, 1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pixels);
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i] = SwapColorChannels(src[i]);
+		}
+	}
+
+	void ConvertPixels(const uint32_t* src, ColorFormat srcFormat,
+		uint32_t* dst, ColorFormat dstFormat, size_t pixelCount)
+	{
+		if (!src || !dst || pixelCount == 0) return;
+
+		if (srcFormat == dstFormat)
+		{
+			if (src != dst)
+			{
+				std::memcpy(dst, src, pixelCount * sizeof(uint32_t));
+			}
+			return;
+		}
+
+		ThreadPool::GetInstance().ParallelFor(0, pixelCount, PARALLEL_CHUNK_PIXELS,
+			[src, dst](size_t begin, size_t end)
+			{
+				SwapColorChannelsSpan(src + begin, dst + begin, end - begin);
+			});
+	}
+}
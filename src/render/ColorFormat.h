@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "glm.hpp"
+
+namespace CPURDR
+{
+	// Names follow SDL_PixelFormat, as a packed uint32_t from the high byte to the low byte
+	// RGBA8888: 0xRRGGBBAA, the renderer's canonical color layout
+	// ABGR8888: 0xAABBGGRR, bytes in memory are R, G, B, A on little-endian, matching R8G8B8A8_UNORM
+	enum class ColorFormat : uint8_t
+	{
+		RGBA8888,
+		ABGR8888
+	};
+
+	inline const char* GetColorFormatName(ColorFormat format)
+	{
+		switch (format)
+		{
+		case ColorFormat::RGBA8888: return "RGBA8888";
+		case ColorFormat::ABGR8888: return "ABGR8888";
+		}
+		return "Unknown";
+	}
+
+	// Both formats are a byte reversal of each other
+	inline uint32_t SwapColorChannels(uint32_t c)
+	{
+		return (c >> 24) | ((c >> 8) & 0x0000FF00) | ((c << 8) & 0x00FF0000) | (c << 24);
+	}
+
+	// 0xRRGGBBAA -> format
+	inline uint32_t EncodeColor(uint32_t rgba, ColorFormat format)
+	{
+		return format == ColorFormat::RGBA8888? rgba : SwapColorChannels(rgba);
+	}
+
+	// format -> 0xRRGGBBAA
+	inline uint32_t DecodeColor(uint32_t color, ColorFormat format)
+	{
+		return format == ColorFormat::RGBA8888? color : SwapColorChannels(color);
+	}
+
+	inline uint32_t PackColor(const glm::vec4& c, ColorFormat format)
+	{
+		const glm::vec4 clamped = glm::clamp(c, 0.0f, 1.0f);
+		const uint32_t r = (uint8_t)(clamped.r * 255.0f);
+		const uint32_t g = (uint8_t)(clamped.g * 255.0f);
+		const uint32_t b = (uint8_t)(clamped.b * 255.0f);
+		const uint32_t a = (uint8_t)(clamped.a * 255.0f);
+		return format == ColorFormat::RGBA8888?
+			(r << 24 | g << 16 | b << 8 | a) :
+			(a << 24 | b << 16 | g << 8 | r);
+	}
+
+	// Copies pixelCount pixels from src to dst, converting between formats when they differ.
+	// Large images are split across the ThreadPool
+	void ConvertPixels(const uint32_t* src, ColorFormat srcFormat,
+		uint32_t* dst, ColorFormat dstFormat, size_t pixelCount);
+}
@@ -1,10 +1,14 @@
 #include "Context.h"
 
+#include "Upscale.h"
+#include "../core/Profiler.h"
+
 namespace CPURDR
 {
-	Context::Context(int width, int height):
+	Context::Context(int width, int height, DepthFormat depthFormat):
 		m_FramebufferWidth(width), m_FramebufferHeight(height), m_InRenderPass(false)
 	{
+		m_Framebuffer.depthFormat = depthFormat;
 		CreateFramebuffer(width, height);
 
 		m_Viewport.x = 0;
@@ -30,8 +34,194 @@ namespace CPURDR
 		m_FramebufferWidth = width;
 		m_FramebufferHeight = height;
 
-		m_Framebuffer.colorBuffer = std::make_shared<Texture2D_RGBA>(width, height, 0x000000FF);
-		m_Framebuffer.depthBuffer = std::make_shared<Texture2D_RFloat>(width, height, 0.0f);
+		const size_t chainLength = std::max<size_t>(m_ColorBufferChain.size(), 1);
+		m_ColorBufferChain.clear();
+		m_ColorDamageChain.resize(chainLength);
+		for (size_t i = 0; i < chainLength; ++i)
+		{
+			m_ColorBufferChain.push_back(std::make_shared<Texture2D_RGBA>(width, height, EncodeColor(0x000000FF)));
+			m_ColorDamageChain[i].Reset(width, height);
+		}
+		m_BackBufferIndex = 0;
+		m_PresentBufferIndex = 0;
+		m_Framebuffer.colorBuffer = m_ColorBufferChain[m_BackBufferIndex];
+
+		m_Framebuffer.depthBuffer.reset();
+		m_Framebuffer.depthStencilBuffer.reset();
+		m_Framebuffer.depthBuffer16.reset();
+
+		switch (m_Framebuffer.depthFormat)
+		{
+		case DepthFormat::D32_Float:
+			m_Framebuffer.depthBuffer = std::make_shared<Texture2D_RFloat>(width, height, 0.0f);
+			break;
+		case DepthFormat::D24_UNorm_S8_UInt:
+			m_Framebuffer.depthStencilBuffer = std::make_shared<Texture2D_D24S8>(width, height, 0u);
+			break;
+		case DepthFormat::D16_UNorm:
+			m_Framebuffer.depthBuffer16 = std::make_shared<Texture2D_D16>(width, height, (uint16_t)0);
+			break;
+		}
+
+		CreateDebugBuffers();
+		CreateTemporalHistory();
+	}
+
+	void Context::CreateDebugBuffers()
+	{
+		m_OverdrawBuffer.reset();
+		m_ShadingCostBuffer.reset();
+
+		switch (m_DebugView)
+		{
+		case DebugView::None:
+			break;
+		case DebugView::Overdraw:
+			m_OverdrawBuffer = std::make_unique<Texture2D_S8>(m_FramebufferWidth, m_FramebufferHeight, (uint8_t)0);
+			break;
+		case DebugView::ShadingCost:
+			m_ShadingCostBuffer = std::make_unique<Texture2D_R32UI>(m_FramebufferWidth, m_FramebufferHeight, 0u);
+			break;
+		}
+	}
+
+	void Context::SetDebugView(DebugView view)
+	{
+		if (m_InRenderPass || view == m_DebugView)
+		{
+			return;
+		}
+
+		m_DebugView = view;
+		m_DebugViewRange = 0;
+		CreateDebugBuffers();
+	}
+
+	void Context::CreateTemporalHistory()
+	{
+		m_TemporalHistory.reset();
+		if (m_TemporalMode != TemporalMode::Off)
+		{
+			m_TemporalHistory = std::make_unique<TemporalHistory>(m_FramebufferWidth, m_FramebufferHeight);
+		}
+	}
+
+	void Context::SetTemporalMode(TemporalMode mode)
+	{
+		if (m_InRenderPass || mode == m_TemporalMode)
+		{
+			return;
+		}
+
+		m_TemporalMode = mode;
+		m_TemporalResolveResult = TemporalResolveResult();
+		CreateTemporalHistory();
+	}
+
+	void Context::ResolveTemporal(const glm::mat4& viewProjection)
+	{
+		if (!m_InRenderPass || !m_TemporalHistory)
+		{
+			return;
+		}
+
+		Texture2D_RGBA& color = *m_Framebuffer.colorBuffer;
+		const int parity = GetCheckerboardParity();
+		const float clearDepth = m_ClearValue.depth;
+		switch (m_Framebuffer.depthFormat)
+		{
+		case DepthFormat::D32_Float:
+			m_TemporalResolveResult = ResolveCheckerboard<DepthFormat::D32_Float>(*m_Framebuffer.depthBuffer,
+				clearDepth, viewProjection, parity, color, *m_TemporalHistory);
+			break;
+		case DepthFormat::D24_UNorm_S8_UInt:
+			m_TemporalResolveResult = ResolveCheckerboard<DepthFormat::D24_UNorm_S8_UInt>(*m_Framebuffer.depthStencilBuffer,
+				clearDepth, viewProjection, parity, color, *m_TemporalHistory);
+			break;
+		case DepthFormat::D16_UNorm:
+			m_TemporalResolveResult = ResolveCheckerboard<DepthFormat::D16_UNorm>(*m_Framebuffer.depthBuffer16,
+				clearDepth, viewProjection, parity, color, *m_TemporalHistory);
+			break;
+		}
+	}
+
+	void Context::ResolveDebugView()
+	{
+		Texture2D_RGBA* colorBuffer = m_Framebuffer.colorBuffer.get();
+		if (!colorBuffer) return;
+
+		PROFILE_SCOPE("Context::ResolveDebugView");
+		switch (m_DebugView)
+		{
+		case DebugView::None:
+			return;
+		case DebugView::Overdraw:
+			ResolveOverdrawHeatmap(*m_OverdrawBuffer, *colorBuffer, m_Framebuffer.colorFormat);
+			m_DebugViewRange = OVERDRAW_HEATMAP_RANGE;
+			break;
+		case DebugView::ShadingCost:
+			m_DebugViewRange = ResolveShadingCostHeatmap(*m_ShadingCostBuffer, *colorBuffer, m_Framebuffer.colorFormat);
+			break;
+		}
+		GetColorDamage()->unknown = true;
+	}
+
+	void Context::SetDepthFormat(DepthFormat format)
+	{
+		if (m_InRenderPass || format == m_Framebuffer.depthFormat)
+		{
+			return;
+		}
+
+		m_Framebuffer.depthFormat = format;
+		CreateFramebuffer(m_FramebufferWidth, m_FramebufferHeight);
+	}
+
+	void Context::SetColorFormat(ColorFormat format)
+	{
+		if (m_InRenderPass || format == m_Framebuffer.colorFormat)
+		{
+			return;
+		}
+
+		for (auto& colorBuffer : m_ColorBufferChain)
+		{
+			auto& pixels = colorBuffer->GetDataVector();
+			ConvertPixels(pixels.data(), m_Framebuffer.colorFormat, pixels.data(), format, pixels.size());
+		}
+		for (auto& damage : m_ColorDamageChain)
+		{
+			damage.clearColor = SwapColorChannels(damage.clearColor);
+		}
+		m_Framebuffer.colorFormat = format;
+		if (m_TemporalHistory)
+		{
+			m_TemporalHistory->valid = false;
+		}
+	}
+
+	void Context::SetFramebufferCount(int count)
+	{
+		count = std::clamp(count, 1, MAX_FRAMEBUFFER_COUNT);
+		if (m_InRenderPass || count == GetFramebufferCount())
+		{
+			return;
+		}
+
+		m_ColorBufferChain.resize(count);
+		CreateFramebuffer(m_FramebufferWidth, m_FramebufferHeight);
+	}
+
+	void Context::SwapFramebuffers()
+	{
+		if (m_InRenderPass)
+		{
+			return;
+		}
+
+		m_PresentBufferIndex = m_BackBufferIndex;
+		m_BackBufferIndex = (m_BackBufferIndex + 1) % GetFramebufferCount();
+		m_Framebuffer.colorBuffer = m_ColorBufferChain[m_BackBufferIndex];
 	}
 
 	void Context::ResizeFramebuffer(int width, int height)
@@ -41,7 +231,14 @@ namespace CPURDR
 			return;
 		}
 
+		const std::shared_ptr<Texture2D_RGBA> presented = m_ColorBufferChain.empty()?
+			nullptr : m_ColorBufferChain[m_PresentBufferIndex];
+
 		CreateFramebuffer(width, height);
+		if (presented)
+		{
+			UpscaleBilinear(*presented, *m_ColorBufferChain[m_PresentBufferIndex]);
+		}
 
 		m_Viewport.width = width;
 		m_Viewport.height = height;
@@ -58,6 +255,8 @@ namespace CPURDR
 
 		m_InRenderPass = true;
 		m_ClearValue = clearValue;
+		m_TemporalFrameIndex++;
+		m_PendingStatistics = PipelineStatistics();
 
 		Clear(clearValue);
 	}
@@ -69,6 +268,14 @@ namespace CPURDR
 			return;
 		}
 		m_InRenderPass = false;
+		m_PipelineStatistics = m_PendingStatistics;
+		ResolveDebugView();
+	}
+
+	void Context::MergePipelineStatistics(const PipelineStatistics& statistics)
+	{
+		std::lock_guard<std::mutex> lock(m_StatisticsMutex);
+		m_PendingStatistics.Merge(statistics);
 	}
 
 	void Context::SetViewport(const Viewport& viewport)
@@ -95,23 +302,72 @@ namespace CPURDR
 	{
 		if (m_Framebuffer.colorBuffer)
 		{
-			m_Framebuffer.colorBuffer->Clear(color);
+			const uint32_t encoded = EncodeColor(color);
+			m_Framebuffer.colorBuffer->Clear(encoded);
+
+			ColorDamage* damage = GetColorDamage();
+			std::fill(damage->writtenTiles.begin(), damage->writtenTiles.end(), (uint8_t)0);
+			damage->clearColor = encoded;
+			damage->unknown = false;
 		}
 	}
 
+	void Context::MarkColorWritten(int minX, int minY, int maxX, int maxY)
+	{
+		minX = std::max(minX, 0);
+		minY = std::max(minY, 0);
+		maxX = std::min(maxX, m_FramebufferWidth - 1);
+		maxY = std::min(maxY, m_FramebufferHeight - 1);
+		if (minX > maxX || minY > maxY) return;
 
-	void Context::ClearDepth(float depth)
+		GetColorDamage()->MarkRect(minX, minY, maxX, maxY);
+	}
+
+	void ColorDamage::MarkRect(int minX, int minY, int maxX, int maxY)
+	{
+		for (int tileY = minY >> TILE_SHIFT; tileY <= (maxY >> TILE_SHIFT); ++tileY)
+		{
+			for (int tileX = minX >> TILE_SHIFT; tileX <= (maxX >> TILE_SHIFT); ++tileX)
+			{
+				writtenTiles[(size_t)tileY * tileColumns + tileX] = 1;
+			}
+		}
+	}
+
+
+	void Context::ClearDepth(float depth, uint8_t stencil)
 	{
 		if (m_Framebuffer.depthBuffer)
 		{
-			m_Framebuffer.depthBuffer->Clear(depth);
+			m_Framebuffer.depthBuffer->Clear(
+				DepthFormatTraits<DepthFormat::D32_Float>::Clear(depth, stencil));
+		}
+		if (m_Framebuffer.depthStencilBuffer)
+		{
+			m_Framebuffer.depthStencilBuffer->Clear(
+				DepthFormatTraits<DepthFormat::D24_UNorm_S8_UInt>::Clear(depth, stencil));
+		}
+		if (m_Framebuffer.depthBuffer16)
+		{
+			m_Framebuffer.depthBuffer16->Clear(
+				DepthFormatTraits<DepthFormat::D16_UNorm>::Clear(depth, stencil));
 		}
 	}
 
 	void Context::Clear(const ClearValue& clearValue)
 	{
+		PROFILE_SCOPE("Context::Clear");
+		const uint64_t start = m_StatsEnabled? RenderStats::Now() : 0;
+
 		ClearColor(clearValue.color);
-		ClearDepth(clearValue.depth);
+		ClearDepth(clearValue.depth, clearValue.stencil);
+		if (m_OverdrawBuffer) m_OverdrawBuffer->Clear(0);
+		if (m_ShadingCostBuffer) m_ShadingCostBuffer->Clear(0);
+
+		if (m_StatsEnabled)
+		{
+			m_Stats.AddTicks(RenderStage::Clear, (int64_t)(RenderStats::Now() - start));
+		}
 	}
 
 }
\ No newline at end of file
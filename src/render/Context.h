@@ -1,6 +1,14 @@
 #pragma once
 #include <memory>
-
+#include <mutex>
+#include <vector>
+
+#include "ColorFormat.h"
+#include "DebugView.h"
+#include "DepthFormat.h"
+#include "PipelineStatistics.h"
+#include "RenderStats.h"
+#include "TemporalUpsampling.h"
 #include "../Texture2D.h"
 
 namespace CPURDR
@@ -25,29 +33,109 @@ namespace CPURDR
 
 	struct FramebufferAttachments
 	{
+		// The back buffer of the color chain, see Context::SwapFramebuffers
 		std::shared_ptr<Texture2D_RGBA> colorBuffer;
+		ColorFormat colorFormat = ColorFormat::RGBA8888;
+		// Only the attachment matching depthFormat is allocated
 		std::shared_ptr<Texture2D_RFloat> depthBuffer;
+		std::shared_ptr<Texture2D_D24S8> depthStencilBuffer;
+		std::shared_ptr<Texture2D_D16> depthBuffer16;
+		DepthFormat depthFormat = DepthFormat::D32_Float;
+	};
+
+	// Which 64x64 tiles of a color buffer were drawn into since its last clear.
+	// Every other pixel still holds clearColor
+	struct ColorDamage
+	{
+		static constexpr int TILE_SIZE = 64;
+		static constexpr int TILE_SHIFT = 6;
+
+		int tileColumns = 0;
+		int tileRows = 0;
+		std::vector<uint8_t> writtenTiles;
+		// Encoded in the framebuffer's color format
+		uint32_t clearColor = 0;
+		// Contents are unknown(never cleared, or written outside the rasterizer), treat every tile as written
+		bool unknown = true;
+
+		void Reset(int width, int height)
+		{
+			tileColumns = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+			tileRows = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+			writtenTiles.assign((size_t)tileColumns * tileRows, 0);
+			unknown = true;
+		}
+
+		void MarkPixel(int x, int y) {writtenTiles[(size_t)(y >> TILE_SHIFT) * tileColumns + (x >> TILE_SHIFT)] = 1;}
+		void MarkRect(int minX, int minY, int maxX, int maxY);
+		bool IsTileWritten(int tileX, int tileY) const {return unknown || writtenTiles[(size_t)tileY * tileColumns + tileX];}
+	};
+
+	// Front faces are counter-clockwise
+	enum class CullMode : uint8_t
+	{
+		None,
+		Back,
+		Front
 	};
 
 	struct ClearValue
 	{
+		// 0xRRGGBBAA, encoded to the framebuffer's color format on clear
 		uint32_t color = 0xFF000000;
 		float depth = 1.0f;
+		uint8_t stencil = 0;
 	};
 
 
 	class Context
 	{
 	public:
-		Context(int width, int height);
+		static constexpr int MAX_FRAMEBUFFER_COUNT = 3;
+
+		Context(int width, int height, DepthFormat depthFormat = DepthFormat::D32_Float);
 		~Context();
 
 		void CreateFramebuffer(int width, int height);
+		// The presented image is carried over scaled, so a resize doesn't flash an empty frame
 		void ResizeFramebuffer(int width, int height);
 		const FramebufferAttachments& GetFramebuffer() const {return m_Framebuffer;}
 
+		// Color buffers in the swap chain, 1 ~ MAX_FRAMEBUFFER_COUNT. Depth is only needed while rendering and stays single
+		void SetFramebufferCount(int count);
+		int GetFramebufferCount() const {return (int)m_ColorBufferChain.size();}
+		// The back buffer becomes the present buffer, and rendering moves on to the next buffer in the chain
+		void SwapFramebuffers();
+		// Last completed frame, safe to read while the back buffer is being rendered
+		const Texture2D_RGBA* GetPresentColorBuffer() const {return m_ColorBufferChain[m_PresentBufferIndex].get();}
+
+		// Damage of the back buffer, writers outside RenderPipeline should mark what they draw
+		ColorDamage* GetColorDamage() {return &m_ColorDamageChain[m_BackBufferIndex];}
+		const ColorDamage& GetPresentColorDamage() const {return m_ColorDamageChain[m_PresentBufferIndex];}
+		// Inclusive pixel bounds, clamped to the framebuffer
+		void MarkColorWritten(int minX, int minY, int maxX, int maxY);
+
+		void SetDepthFormat(DepthFormat format);
+		DepthFormat GetDepthFormat() const {return m_Framebuffer.depthFormat;}
+
+		// Layout the rasterizer writes pixels in, pick the presentation target's layout to skip conversion
+		void SetColorFormat(ColorFormat format);
+		ColorFormat GetColorFormat() const {return m_Framebuffer.colorFormat;}
+		uint32_t EncodeColor(uint32_t rgba) const {return CPURDR::EncodeColor(rgba, m_Framebuffer.colorFormat);}
+
+		void SetDepthFunction(DepthFunction function) {m_DepthFunction = function;}
+		DepthFunction GetDepthFunction() const {return m_DepthFunction;}
+		bool IsReversedZ() const {return m_DepthFunction == DepthFunction::Greater;}
+		// Depth of the far plane, which is what the depth buffer should be cleared to
+		float GetClearDepth() const {return IsReversedZ()? 0.0f : 1.0f;}
+
+		void SetCullMode(CullMode mode) {m_CullMode = mode;}
+		CullMode GetCullMode() const {return m_CullMode;}
+
 		void BeginRenderPass(const ClearValue& clearValue);
 		void EndRenderPass();
+		// Of the current, or else the last, render pass
+		const ClearValue& GetClearValue() const {return m_ClearValue;}
 
 		void SetViewport(const Viewport& viewport);
 		void SetScissor(const ScissorRect& scissor);
@@ -55,10 +143,40 @@ namespace CPURDR
 		const ScissorRect& GetScissor() const {return m_Scissor;}
 
 		// Clear
+		// color is 0xRRGGBBAA
 		void ClearColor(uint32_t color);
-		void ClearDepth(float depth);
+		void ClearDepth(float depth, uint8_t stencil = 0);
 		void Clear(const ClearValue& clearValue);
 
+		// Stage timing for benchmarks, ticks accumulate until GetStats().Reset()
+		void SetStatsEnabled(bool enabled) {m_StatsEnabled = enabled;}
+		bool IsStatsEnabled() const {return m_StatsEnabled;}
+		RenderStats* GetStats() {return m_StatsEnabled? &m_Stats : nullptr;}
+
+		// Allocates the counter buffer the view needs, the rasterizer fills it and EndRenderPass()
+		// replaces the color buffer with its heatmap
+		void SetDebugView(DebugView view);
+		DebugView GetDebugView() const {return m_DebugView;}
+		// nullptr unless the matching view is selected
+		Texture2D_S8* GetOverdrawBuffer() const {return m_OverdrawBuffer.get();}
+		Texture2D_R32UI* GetShadingCostBuffer() const {return m_ShadingCostBuffer.get();}
+		// Value drawn as red in the last heatmap, fragments for Overdraw and cycles for ShadingCost
+		uint32_t GetDebugViewRange() const {return m_DebugViewRange;}
+
+		// Checkerboard halves the shaded pixels, ResolveTemporal() reconstructs the rest
+		void SetTemporalMode(TemporalMode mode);
+		TemporalMode GetTemporalMode() const {return m_TemporalMode;}
+		// Pixels with (x + y) & 1 == parity are shaded this pass, the others only write depth. -1 shades every pixel
+		int GetCheckerboardParity() const {return m_TemporalMode == TemporalMode::Checkerboard? (int)(m_TemporalFrameIndex & 1) : -1;}
+		// Call once the scene is drawn, with the matrix it was drawn with. Does nothing while the mode is Off
+		void ResolveTemporal(const glm::mat4& viewProjection);
+		const TemporalResolveResult& GetTemporalResolveResult() const {return m_TemporalResolveResult;}
+
+		// Rendering threads merge their counters once per pass, thread safe
+		void MergePipelineStatistics(const PipelineStatistics& statistics);
+		// Results of the last completed render pass
+		const PipelineStatistics& GetPipelineStatistics() const {return m_PipelineStatistics;}
+
 		bool IsInRenderPass() const {return m_InRenderPass;}
 		int GetFramebufferWidth() const {return m_FramebufferWidth;}
 		int GetFramebufferHeight() const {return m_FramebufferHeight;}
@@ -66,7 +184,23 @@ namespace CPURDR
 		Texture2D_RGBA* GetColorBuffer() const {return m_Framebuffer.colorBuffer.get();}
 		Texture2D_RFloat* GetDepthBuffer() const {return m_Framebuffer.depthBuffer.get();}
 
+		// nullptr unless Format is the current depth format
+		template<DepthFormat Format>
+		typename DepthFormatTraits<Format>::TextureType* GetDepthAttachment() const
+		{
+			if constexpr (Format == DepthFormat::D32_Float)
+				return m_Framebuffer.depthBuffer.get();
+			else if constexpr (Format == DepthFormat::D24_UNorm_S8_UInt)
+				return m_Framebuffer.depthStencilBuffer.get();
+			else
+				return m_Framebuffer.depthBuffer16.get();
+		}
+
 	private:
+		void CreateDebugBuffers();
+		void CreateTemporalHistory();
+		void ResolveDebugView();
+
 		FramebufferAttachments m_Framebuffer;
 		Viewport m_Viewport;
 		ScissorRect m_Scissor;
@@ -74,7 +208,31 @@ namespace CPURDR
 		int m_FramebufferWidth;
 		int m_FramebufferHeight;
 
+		std::vector<std::shared_ptr<Texture2D_RGBA>> m_ColorBufferChain;
+		std::vector<ColorDamage> m_ColorDamageChain;
+		int m_BackBufferIndex = 0;
+		int m_PresentBufferIndex = 0;
+
 		bool m_InRenderPass;
 		ClearValue m_ClearValue;
+		DepthFunction m_DepthFunction = DepthFunction::Less;
+		CullMode m_CullMode = CullMode::None;
+
+		std::mutex m_StatisticsMutex;
+		PipelineStatistics m_PendingStatistics;
+		PipelineStatistics m_PipelineStatistics;
+
+		RenderStats m_Stats;
+		bool m_StatsEnabled = false;
+
+		DebugView m_DebugView = DebugView::None;
+		std::unique_ptr<Texture2D_S8> m_OverdrawBuffer;
+		std::unique_ptr<Texture2D_R32UI> m_ShadingCostBuffer;
+		uint32_t m_DebugViewRange = 0;
+
+		TemporalMode m_TemporalMode = TemporalMode::Off;
+		std::unique_ptr<TemporalHistory> m_TemporalHistory;
+		uint32_t m_TemporalFrameIndex = 0;
+		TemporalResolveResult m_TemporalResolveResult;
 	};
 }
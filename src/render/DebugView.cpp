@@ -0,0 +1,79 @@
+#include "DebugView.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace CPURDR
+{
+	uint32_t HeatmapColor(float t)
+	{
+		if (t <= 0.0f) return 0x000000FF;
+		if (t > 1.0f) return 0xFFFFFFFF;
+
+		static const glm::vec3 stops[] =
+		{
+			{0.0f, 0.0f, 1.0f},
+			{0.0f, 1.0f, 1.0f},
+			{0.0f, 1.0f, 0.0f},
+			{1.0f, 1.0f, 0.0f},
+			{1.0f, 0.0f, 0.0f}
+		};
+		constexpr int segments = (int)(sizeof(stops) / sizeof(stops[0])) - 1;
+
+		const float x = t * segments;
+		const int i = std::min((int)x, segments - 1);
+		const glm::vec3 c = stops[i] + (stops[i + 1] - stops[i]) * (x - (float)i);
+		return PackColor(glm::vec4(c, 1.0f), ColorFormat::RGBA8888);
+	}
+
+	void ResolveOverdrawHeatmap(const Texture2D_S8& overdraw, Texture2D_RGBA& dst, ColorFormat format)
+	{
+		// Count 0 stays black, 1 ~ OVERDRAW_HEATMAP_RANGE span the gradient
+		uint32_t palette[256];
+		palette[0] = EncodeColor(HeatmapColor(0.0f), format);
+		for (uint32_t count = 1; count < 256; ++count)
+		{
+			const float t = (float)(count - 1) / (float)(OVERDRAW_HEATMAP_RANGE - 1);
+			palette[count] = EncodeColor(HeatmapColor(std::max(t, 1e-3f)), format);
+		}
+
+		const uint8_t* src = overdraw.GetData();
+		uint32_t* pixels = dst.GetData();
+		const size_t count = std::min(overdraw.GetSize(), dst.GetSize());
+		for (size_t i = 0; i < count; ++i)
+		{
+			pixels[i] = palette[src[i]];
+		}
+	}
+
+	uint32_t ResolveShadingCostHeatmap(const Texture2D_R32UI& shadingCost, Texture2D_RGBA& dst, ColorFormat format)
+	{
+		const uint32_t* src = shadingCost.GetData();
+		uint32_t* pixels = dst.GetData();
+		const size_t count = std::min(shadingCost.GetSize(), dst.GetSize());
+
+		std::vector<uint32_t> shaded;
+		shaded.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (src[i] > 0) shaded.push_back(src[i]);
+		}
+
+		uint32_t range = 1;
+		if (!shaded.empty())
+		{
+			const auto percentile = shaded.begin() + (ptrdiff_t)((shaded.size() - 1) * 99 / 100);
+			std::nth_element(shaded.begin(), percentile, shaded.end());
+			range = std::max(*percentile, 1u);
+		}
+
+		const float invRange = 1.0f / (float)range;
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Keep the cheapest shaded pixels off black
+			const float t = src[i] > 0? std::max((float)src[i] * invRange, 1e-3f) : 0.0f;
+			pixels[i] = EncodeColor(HeatmapColor(t), format);
+		}
+		return range;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+#include "ColorFormat.h"
+#include "RenderStats.h"
+#include "../Texture2D.h"
+
+namespace CPURDR
+{
+	// Shown in place of the lit image, the counters are only recorded while a view is selected
+	enum class DebugView : uint8_t
+	{
+		None,
+		Overdraw,    // fragments shaded per pixel
+		ShadingCost  // fragment shader cycles per pixel, summed over every fragment shaded there
+	};
+
+	inline const char* GetDebugViewName(DebugView view)
+	{
+		switch (view)
+		{
+		case DebugView::None: return "None";
+		case DebugView::Overdraw: return "Overdraw";
+		case DebugView::ShadingCost: return "Shading Cost";
+		}
+		return "Unknown";
+	}
+
+	// Fragment count shown as red, anything above is white
+	constexpr uint32_t OVERDRAW_HEATMAP_RANGE = 5;
+
+	// 0 is black, (0, 1] goes blue -> cyan -> green -> yellow -> red, above 1 is white. Returns 0xRRGGBBAA
+	uint32_t HeatmapColor(float t);
+
+	// 1 fragment is blue, OVERDRAW_HEATMAP_RANGE fragments red
+	void ResolveOverdrawHeatmap(const Texture2D_S8& overdraw, Texture2D_RGBA& dst, ColorFormat format);
+
+	// Scaled to the 99th percentile of the shaded pixels so a few outliers do not flatten the rest.
+	// Returns the cost shown as red
+	uint32_t ResolveShadingCostHeatmap(const Texture2D_R32UI& shadingCost, Texture2D_RGBA& dst, ColorFormat format);
+}
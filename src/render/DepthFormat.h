@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+
+#include "../Texture2D.h"
+
+namespace CPURDR
+{
+	enum class DepthFormat : uint8_t
+	{
+		D32_Float,
+		D24_UNorm_S8_UInt,
+		D16_UNorm
+	};
+
+	// Less: standard-Z, near = 0.0, far = 1.0
+	// Greater: reversed-Z, near = 1.0, far = 0.0
+	enum class DepthFunction : uint8_t
+	{
+		Less,
+		Greater
+	};
+
+	template<DepthFunction Function, typename T>
+	inline bool PassesDepthTest(T incoming, T stored)
+	{
+		if constexpr (Function == DepthFunction::Less)
+			return incoming < stored;
+		else
+			return incoming > stored;
+	}
+
+	inline const char* GetDepthFormatName(DepthFormat format)
+	{
+		switch (format)
+		{
+		case DepthFormat::D32_Float: return "D32 Float";
+		case DepthFormat::D24_UNorm_S8_UInt: return "D24 UNorm S8";
+		case DepthFormat::D16_UNorm: return "D16 UNorm";
+		}
+		return "Unknown";
+	}
+
+	// ===============
+	// Depth Format Traits
+	// ===============
+	// Encode:  NDC depth(0.0 ~ 1.0) -> value the depth test compares
+	// Load:    texel -> value the depth test compares
+	// Store:   write a new depth into a texel, keeping any stencil bits
+	// Decode:  texel -> NDC depth, for visualization and reconstruction
+	template<DepthFormat Format>
+	struct DepthFormatTraits;
+
+	template<>
+	struct DepthFormatTraits<DepthFormat::D32_Float>
+	{
+		using StorageType = float;
+		using DepthType = float;
+		using TextureType = Texture2D_RFloat;
+
+		static DepthType Encode(float depth) {return depth;}
+		static DepthType Load(StorageType texel) {return texel;}
+		static StorageType Store(StorageType, DepthType depth) {return depth;}
+		static float Decode(StorageType texel) {return texel;}
+		static StorageType Clear(float depth, uint8_t) {return depth;}
+	};
+
+	template<>
+	struct DepthFormatTraits<DepthFormat::D24_UNorm_S8_UInt>
+	{
+		using StorageType = uint32_t;
+		using DepthType = uint32_t;
+		using TextureType = Texture2D_D24S8;
+
+		static constexpr uint32_t MAX_DEPTH = 0x00FFFFFF;
+
+		static DepthType Encode(float depth)
+		{
+			return (uint32_t)(std::clamp(depth, 0.0f, 1.0f) * (float)MAX_DEPTH + 0.5f);
+		}
+		static DepthType Load(StorageType texel) {return texel >> 8;}
+		static StorageType Store(StorageType texel, DepthType depth) {return (depth << 8) | (texel & 0xFF);}
+		static float Decode(StorageType texel) {return (float)(texel >> 8) * (1.0f / (float)MAX_DEPTH);}
+		static StorageType Clear(float depth, uint8_t stencil) {return (Encode(depth) << 8) | stencil;}
+	};
+
+	template<>
+	struct DepthFormatTraits<DepthFormat::D16_UNorm>
+	{
+		using StorageType = uint16_t;
+		using DepthType = uint16_t;
+		using TextureType = Texture2D_D16;
+
+		static constexpr uint16_t MAX_DEPTH = 0xFFFF;
+
+		static DepthType Encode(float depth)
+		{
+			return (uint16_t)(std::clamp(depth, 0.0f, 1.0f) * (float)MAX_DEPTH + 0.5f);
+		}
+		static DepthType Load(StorageType texel) {return texel;}
+		static StorageType Store(StorageType, DepthType depth) {return depth;}
+		static float Decode(StorageType texel) {return (float)texel * (1.0f / (float)MAX_DEPTH);}
+		static StorageType Clear(float depth, uint8_t) {return Encode(depth);}
+	};
+}
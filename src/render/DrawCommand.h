@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "glm.hpp"
+#include "Material.h"
+#include "../ecs/components/RenderTransform.h"
+
+namespace CPURDR
+{
+	struct Mesh;
+
+	// One mesh draw as the pipeline executes it, together with FrameUniforms it is everything the draw reads
+	struct DrawCommand
+	{
+		const Mesh* mesh = nullptr;
+		uint32_t materialIndex = 0;
+		RenderTransform transform;
+		// Instanced when instanceCount > 0: draws the mesh once per DrawList::instanceTransforms entry in
+		// [firstInstance, firstInstance + instanceCount) and transform is unused
+		uint32_t firstInstance = 0;
+		uint32_t instanceCount = 0;
+
+		bool IsInstanced() const {return instanceCount > 0;}
+		uint32_t GetInstanceCount() const {return IsInstanced()? instanceCount : 1;}
+	};
+
+	// Draws in submission order. Effective materials are shared by every mesh of an entity, or of an instance group
+	struct DrawList
+	{
+		std::vector<Material> materials;
+		std::vector<DrawCommand> commands;
+		std::vector<RenderTransform> instanceTransforms;
+
+		void Clear()
+		{
+			materials.clear();
+			commands.clear();
+			instanceTransforms.clear();
+		}
+	};
+}
@@ -0,0 +1,65 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CPURDR
+{
+	// Weight of the newest frame in the smoothed time
+	static constexpr float SMOOTHING = 0.2f;
+	// Steps the scale may rise per change, dropping is not limited so a slow frame recovers at once
+	static constexpr int MAX_UPSCALE_STEPS = 2;
+
+	void DynamicResolution::SetSettings(const DynamicResolutionSettings& settings)
+	{
+		m_Settings = settings;
+		m_Settings.minScale = std::clamp(m_Settings.minScale, SCALE_STEP, 1.0f);
+		m_Settings.maxScale = std::clamp(m_Settings.maxScale, m_Settings.minScale, 1.0f);
+		m_Settings.targetFrameMs = std::max(m_Settings.targetFrameMs, 0.1f);
+		m_Scale = std::clamp(m_Scale, m_Settings.minScale, m_Settings.maxScale);
+	}
+
+	void DynamicResolution::Reset(float scale)
+	{
+		m_Scale = std::clamp(scale, m_Settings.minScale, m_Settings.maxScale);
+		m_SmoothedMs = 0.0f;
+		m_FramesSinceChange = 0;
+	}
+
+	float DynamicResolution::Update(float rasterMs)
+	{
+		if (rasterMs <= 0.0f)
+		{
+			return m_Scale;
+		}
+
+		m_SmoothedMs = m_SmoothedMs > 0.0f? m_SmoothedMs + (rasterMs - m_SmoothedMs) * SMOOTHING : rasterMs;
+		if (++m_FramesSinceChange < COOLDOWN_FRAMES)
+		{
+			return m_Scale;
+		}
+
+		const float target = m_Settings.targetFrameMs;
+		if (m_SmoothedMs <= target && m_SmoothedMs >= target * UPSCALE_THRESHOLD)
+		{
+			return m_Scale;
+		}
+
+		// Aim for the middle of the band, so the next measurement doesn't land right on an edge
+		const float aim = target * (1.0f + UPSCALE_THRESHOLD) * 0.5f;
+		const float ideal = m_Scale * std::sqrt(aim / m_SmoothedMs);
+		float scale = std::floor(ideal / SCALE_STEP) * SCALE_STEP;
+		scale = std::min(scale, m_Scale + MAX_UPSCALE_STEPS * SCALE_STEP);
+		scale = std::clamp(scale, m_Settings.minScale, m_Settings.maxScale);
+		if (std::abs(scale - m_Scale) < SCALE_STEP * 0.5f)
+		{
+			return m_Scale;
+		}
+
+		// Predict the time at the new scale until fresh measurements come in
+		m_SmoothedMs *= (scale * scale) / (m_Scale * m_Scale);
+		m_Scale = scale;
+		m_FramesSinceChange = 0;
+		return m_Scale;
+	}
+}
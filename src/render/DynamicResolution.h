@@ -0,0 +1,44 @@
+#pragma once
+
+namespace CPURDR
+{
+	struct DynamicResolutionSettings
+	{
+		float targetFrameMs = 16.0f;
+		float minScale = 0.25f;
+		float maxScale = 1.0f;
+	};
+
+	// ===============
+	// Dynamic Resolution
+	// ===============
+	// Picks the render scale for the next frame from the measured raster time. Raster cost is taken to grow
+	// with the pixel count, i.e. the square of the scale. The scale moves in SCALE_STEP increments and holds
+	// for COOLDOWN_FRAMES after a change, since every change reallocates the framebuffer
+	class DynamicResolution
+	{
+	public:
+		void SetSettings(const DynamicResolutionSettings& settings);
+		const DynamicResolutionSettings& GetSettings() const {return m_Settings;}
+
+		// Restarts from scale, e.g. when the controller is switched on
+		void Reset(float scale);
+
+		// rasterMs was measured at GetScale(), returns the scale to render the next frame at
+		float Update(float rasterMs);
+
+		float GetScale() const {return m_Scale;}
+		float GetSmoothedMs() const {return m_SmoothedMs;}
+
+		static constexpr float SCALE_STEP = 0.05f;
+		static constexpr int COOLDOWN_FRAMES = 15;
+		// Below this share of the target the scale goes up, above the target it goes down
+		static constexpr float UPSCALE_THRESHOLD = 0.8f;
+
+	private:
+		DynamicResolutionSettings m_Settings;
+		float m_Scale = 1.0f;
+		float m_SmoothedMs = 0.0f;
+		int m_FramesSinceChange = 0;
+	};
+}
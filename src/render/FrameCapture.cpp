@@ -0,0 +1,412 @@
+#include "FrameCapture.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+
+#include "plog/Log.h"
+#include "../VertexQuantization.h"
+
+namespace CPURDR
+{
+	static constexpr char CAPTURE_MAGIC[4] = {'C', 'P', 'F', 'C'};
+
+	// Little-endian raw values, the capture is read back on the same kind of machine it was written on
+	class CaptureWriter
+	{
+	public:
+		explicit CaptureWriter(std::ofstream& file): m_File(file) {}
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			m_File.write(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		void WriteArray(const T* values, size_t count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			Write((uint32_t)count);
+			m_File.write(reinterpret_cast<const char*>(values), (std::streamsize)(count * sizeof(T)));
+		}
+
+		void WriteString(const std::string& value) {WriteArray(value.data(), value.size());}
+
+	private:
+		std::ofstream& m_File;
+	};
+
+	// Every read fails once the file is exhausted, callers check Good() after a section
+	class CaptureReader
+	{
+	public:
+		explicit CaptureReader(std::ifstream& file): m_File(file) {}
+
+		template<typename T>
+		T Read()
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			T value{};
+			m_File.read(reinterpret_cast<char*>(&value), sizeof(T));
+			return value;
+		}
+
+		template<typename T>
+		bool ReadArray(std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			const uint32_t count = Read<uint32_t>();
+			if (!Good() || count > MAX_ARRAY_BYTES / sizeof(T)) return false;
+			values.resize(count);
+			m_File.read(reinterpret_cast<char*>(values.data()), (std::streamsize)(count * sizeof(T)));
+			return Good();
+		}
+
+		bool ReadString(std::string& value)
+		{
+			std::vector<char> chars;
+			if (!ReadArray(chars)) return false;
+			value.assign(chars.begin(), chars.end());
+			return true;
+		}
+
+		bool Good() const {return m_File.good();}
+
+	private:
+		// Guards against allocating garbage sizes from a corrupt file
+		static constexpr size_t MAX_ARRAY_BYTES = (size_t)1 << 31;
+		std::ifstream& m_File;
+	};
+
+	static void WriteFrameUniforms(CaptureWriter& writer, const FrameUniforms& uniforms)
+	{
+		writer.Write(uniforms.viewMatrix);
+		writer.Write(uniforms.projectionMatrix);
+		writer.Write(uniforms.viewProjectionMatrix);
+		writer.Write(uniforms.cameraPosition);
+		writer.Write((uint8_t)uniforms.hasMainLight);
+		writer.Write(uniforms.mainLightDirection);
+		writer.Write(uniforms.mainLightColor);
+		writer.Write(uniforms.mainLightIntensity);
+		writer.Write((int32_t)uniforms.additionalLightsCount);
+		for (const LightData& light : uniforms.additionalLights)
+		{
+			writer.Write(light.position);
+			writer.Write(light.direction);
+			writer.Write(light.color);
+			writer.Write(light.intensity);
+			writer.Write(light.range);
+			writer.Write((int32_t)light.type);
+		}
+		writer.Write(uniforms.ambientLight);
+		writer.Write(uniforms.time);
+	}
+
+	static void ReadFrameUniforms(CaptureReader& reader, FrameUniforms& uniforms)
+	{
+		uniforms.viewMatrix = reader.Read<glm::mat4>();
+		uniforms.projectionMatrix = reader.Read<glm::mat4>();
+		uniforms.viewProjectionMatrix = reader.Read<glm::mat4>();
+		uniforms.cameraPosition = reader.Read<glm::vec3>();
+		uniforms.hasMainLight = reader.Read<uint8_t>() != 0;
+		uniforms.mainLightDirection = reader.Read<glm::vec3>();
+		uniforms.mainLightColor = reader.Read<glm::vec3>();
+		uniforms.mainLightIntensity = reader.Read<float>();
+		uniforms.additionalLightsCount = reader.Read<int32_t>();
+		for (LightData& light : uniforms.additionalLights)
+		{
+			light.position = reader.Read<glm::vec3>();
+			light.direction = reader.Read<glm::vec3>();
+			light.color = reader.Read<glm::vec3>();
+			light.intensity = reader.Read<float>();
+			light.range = reader.Read<float>();
+			light.type = reader.Read<int32_t>();
+		}
+		uniforms.ambientLight = reader.Read<glm::vec3>();
+		uniforms.time = reader.Read<float>();
+	}
+
+	// Enums are stored as bytes, a value past the last enumerator would index past the pipeline's tables
+	template<typename Enum>
+	static bool ReadEnum(CaptureReader& reader, Enum last, Enum& value, const char* name, const std::string& filepath)
+	{
+		const uint8_t raw = reader.Read<uint8_t>();
+		if (raw > (uint8_t)last)
+		{
+			PLOG_ERROR << filepath << " has an invalid " << name << " (" << (int)raw << ")";
+			return false;
+		}
+		value = (Enum)raw;
+		return true;
+	}
+
+	static void WriteMaterial(CaptureWriter& writer, const Material& material)
+	{
+		writer.WriteString(material.name);
+		writer.Write(material.shaderId);
+		writer.Write((uint32_t)material.properties.size());
+		for (const auto& [name, value] : material.properties)
+		{
+			writer.WriteString(name);
+			writer.Write((uint8_t)value.index());
+			std::visit([&writer](const auto& v) {writer.Write(v);}, value);
+		}
+	}
+
+	// Indices follow the alternatives of PropertyValue
+	template<size_t Index = 0>
+	static bool ReadPropertyValue(CaptureReader& reader, uint8_t typeIndex, PropertyValue& value)
+	{
+		if constexpr (Index < std::variant_size_v<PropertyValue>)
+		{
+			if (typeIndex == Index)
+			{
+				value.emplace<Index>(reader.Read<std::variant_alternative_t<Index, PropertyValue>>());
+				return true;
+			}
+			return ReadPropertyValue<Index + 1>(reader, typeIndex, value);
+		}
+		return false;
+	}
+
+	static bool ReadMaterial(CaptureReader& reader, Material& material)
+	{
+		if (!reader.ReadString(material.name)) return false;
+		material.shaderId = reader.Read<uint32_t>();
+
+		const uint32_t propertyCount = reader.Read<uint32_t>();
+		material.properties.clear();
+		for (uint32_t i = 0; i < propertyCount && reader.Good(); ++i)
+		{
+			std::string name;
+			if (!reader.ReadString(name)) return false;
+
+			PropertyValue value;
+			if (!ReadPropertyValue(reader, reader.Read<uint8_t>(), value)) return false;
+			material.properties[name] = value;
+		}
+		return reader.Good();
+	}
+
+	void FrameCapture::Record(const Context& context, const FrameUniforms& uniforms, const DrawList& drawList)
+	{
+		width = context.GetFramebufferWidth();
+		height = context.GetFramebufferHeight();
+		depthFormat = context.GetDepthFormat();
+		depthFunction = context.GetDepthFunction();
+		cullMode = context.GetCullMode();
+		colorFormat = context.GetColorFormat();
+		clearValue = context.GetClearValue();
+		frameUniforms = uniforms;
+
+		meshes.clear();
+		materials = drawList.materials;
+		draws.clear();
+		draws.reserve(drawList.commands.size());
+		instanceTransforms.clear();
+		instanceTransforms.reserve(drawList.instanceTransforms.size());
+		for (const RenderTransform& transform : drawList.instanceTransforms)
+		{
+			instanceTransforms.push_back(transform.objectToWorld);
+		}
+
+		std::unordered_map<const Mesh*, uint32_t> meshIndices;
+		for (const DrawCommand& command : drawList.commands)
+		{
+			auto [it, inserted] = meshIndices.try_emplace(command.mesh, (uint32_t)meshes.size());
+			if (inserted)
+			{
+				// Captures stay in the float layout
+				meshes.push_back(DequantizeMesh(*command.mesh));
+			}
+			draws.push_back({it->second, command.materialIndex, command.transform.objectToWorld,
+				command.firstInstance, command.instanceCount});
+		}
+	}
+
+	bool FrameCapture::Save(const std::string& filepath) const
+	{
+		std::ofstream file(filepath, std::ios::binary);
+		if (!file.is_open())
+		{
+			PLOG_ERROR << "Failed to open " << filepath;
+			return false;
+		}
+
+		CaptureWriter writer(file);
+		file.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+		writer.Write(VERSION);
+
+		writer.Write((int32_t)width);
+		writer.Write((int32_t)height);
+		writer.Write((uint8_t)depthFormat);
+		writer.Write((uint8_t)depthFunction);
+		writer.Write((uint8_t)cullMode);
+		writer.Write((uint8_t)colorFormat);
+		writer.Write(clearValue.color);
+		writer.Write(clearValue.depth);
+		writer.Write(clearValue.stencil);
+
+		WriteFrameUniforms(writer, frameUniforms);
+
+		static_assert(sizeof(Vertex) == 8 * sizeof(float), "Vertex layout changed, bump FrameCapture::VERSION");
+		static_assert(sizeof(Meshlet) == 10 * sizeof(float), "Meshlet layout changed, bump FrameCapture::VERSION");
+		writer.Write((uint32_t)meshes.size());
+		size_t triangleCount = 0;
+		for (const Mesh& mesh : meshes)
+		{
+			writer.WriteArray(mesh.vertices.data(), mesh.vertices.size());
+			writer.WriteArray(mesh.indices.data(), mesh.indices.size());
+			// Stored rather than rebuilt, the bounds of quantized meshes came from the quantized positions
+			const size_t meshletCount = mesh.meshlets? mesh.meshlets->size() : 0;
+			writer.WriteArray(mesh.meshlets? mesh.meshlets->data() : nullptr, meshletCount);
+			triangleCount += mesh.indices.size() / 3;
+		}
+
+		writer.Write((uint32_t)materials.size());
+		for (const Material& material : materials)
+		{
+			WriteMaterial(writer, material);
+		}
+
+		writer.WriteArray(draws.data(), draws.size());
+		writer.WriteArray(instanceTransforms.data(), instanceTransforms.size());
+
+		if (!file.good())
+		{
+			PLOG_ERROR << "Failed to write " << filepath;
+			return false;
+		}
+		PLOG_INFO << "Captured " << draws.size() << " draws, " << meshes.size() << " meshes("
+			<< triangleCount << " triangles) to " << filepath;
+		return true;
+	}
+
+	bool FrameCapture::Load(const std::string& filepath)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file.is_open())
+		{
+			PLOG_ERROR << "Failed to open " << filepath;
+			return false;
+		}
+
+		CaptureReader reader(file);
+		char magic[sizeof(CAPTURE_MAGIC)] = {};
+		file.read(magic, sizeof(magic));
+		if (std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0)
+		{
+			PLOG_ERROR << filepath << " is not a frame capture";
+			return false;
+		}
+
+		const uint32_t version = reader.Read<uint32_t>();
+		if (version != VERSION)
+		{
+			PLOG_ERROR << filepath << " is capture version " << version << ", expected " << VERSION;
+			return false;
+		}
+
+		width = reader.Read<int32_t>();
+		height = reader.Read<int32_t>();
+		if (!ReadEnum(reader, DepthFormat::D16_UNorm, depthFormat, "depth format", filepath) ||
+			!ReadEnum(reader, DepthFunction::Greater, depthFunction, "depth function", filepath) ||
+			!ReadEnum(reader, CullMode::Front, cullMode, "cull mode", filepath) ||
+			!ReadEnum(reader, ColorFormat::ABGR8888, colorFormat, "color format", filepath))
+		{
+			return false;
+		}
+		clearValue.color = reader.Read<uint32_t>();
+		clearValue.depth = reader.Read<float>();
+		clearValue.stencil = reader.Read<uint8_t>();
+
+		ReadFrameUniforms(reader, frameUniforms);
+		if (frameUniforms.additionalLightsCount < 0 || frameUniforms.additionalLightsCount > MAX_ADDITIONAL_LIGHTS)
+		{
+			PLOG_ERROR << filepath << " has an invalid light count (" << frameUniforms.additionalLightsCount << ")";
+			return false;
+		}
+
+		bool ok = reader.Good() && width > 0 && height > 0;
+		const uint32_t meshCount = ok? reader.Read<uint32_t>() : 0;
+		meshes.clear();
+		for (uint32_t i = 0; ok && i < meshCount; ++i)
+		{
+			std::vector<Vertex> vertices;
+			std::vector<unsigned int> indices;
+			std::vector<Meshlet> meshlets;
+			ok = reader.ReadArray(vertices) && reader.ReadArray(indices) && reader.ReadArray(meshlets);
+			for (unsigned int index : indices)
+			{
+				ok &= index < vertices.size();
+			}
+			const size_t triangleCount = indices.size() / 3;
+			for (const Meshlet& meshlet : meshlets)
+			{
+				ok &= meshlet.firstTriangle <= triangleCount && meshlet.triangleCount <= triangleCount - meshlet.firstTriangle;
+			}
+			if (!ok) break;
+
+			Mesh& mesh = meshes.emplace_back(vertices, indices);
+			if (!meshlets.empty())
+			{
+				mesh.meshlets = std::make_shared<const std::vector<Meshlet>>(std::move(meshlets));
+			}
+		}
+
+		const uint32_t materialCount = ok? reader.Read<uint32_t>() : 0;
+		materials.assign(ok? materialCount : 0, Material());
+		for (uint32_t i = 0; ok && i < materialCount; ++i)
+		{
+			ok = ReadMaterial(reader, materials[i]);
+		}
+
+		ok = ok && reader.ReadArray(draws) && reader.ReadArray(instanceTransforms);
+		for (const CapturedDraw& draw : draws)
+		{
+			ok &= draw.meshIndex < meshes.size() && draw.materialIndex < materials.size();
+			ok &= draw.firstInstance <= instanceTransforms.size() &&
+				draw.instanceCount <= instanceTransforms.size() - draw.firstInstance;
+		}
+
+		if (!ok)
+		{
+			PLOG_ERROR << filepath << " is truncated or corrupt";
+			return false;
+		}
+		return true;
+	}
+
+	void FrameCapture::BuildDrawList(DrawList& drawList) const
+	{
+		drawList.materials = materials;
+		drawList.commands.clear();
+		drawList.commands.reserve(draws.size());
+		for (const CapturedDraw& draw : draws)
+		{
+			drawList.commands.push_back({&meshes[draw.meshIndex], draw.materialIndex, RenderTransform(draw.objectToWorld),
+				draw.firstInstance, draw.instanceCount});
+		}
+		drawList.instanceTransforms.clear();
+		drawList.instanceTransforms.reserve(instanceTransforms.size());
+		for (const glm::mat4& objectToWorld : instanceTransforms)
+		{
+			drawList.instanceTransforms.emplace_back(objectToWorld);
+		}
+	}
+
+	void FrameCapture::ApplyToContext(Context& context) const
+	{
+		context.SetDepthFormat(depthFormat);
+		context.SetColorFormat(colorFormat);
+		context.SetDepthFunction(depthFunction);
+		context.SetCullMode(cullMode);
+		if (context.GetFramebufferWidth() != width || context.GetFramebufferHeight() != height)
+		{
+			context.ResizeFramebuffer(width, height);
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Context.h"
+#include "DrawCommand.h"
+#include "ShaderUniforms.h"
+#include "../Model.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Frame Capture
+	// ===============
+	// Everything RenderPipeline::RenderDrawList() reads for one frame: framebuffer setup, frame uniforms,
+	// and the draws in order with copies of their meshes, meshlets included, and effective materials. Saved as a
+	// compact binary file so a frame can be replayed without the scene it came from.
+	// Textures are not captured, materials keep their handles
+	struct FrameCapture
+	{
+		struct CapturedDraw
+		{
+			uint32_t meshIndex = 0;
+			uint32_t materialIndex = 0;
+			glm::mat4 objectToWorld = glm::mat4(1.0f);
+			// Like DrawCommand, instanced draws use instanceTransforms instead of objectToWorld
+			uint32_t firstInstance = 0;
+			uint32_t instanceCount = 0;
+		};
+
+		int width = 0;
+		int height = 0;
+		DepthFormat depthFormat = DepthFormat::D32_Float;
+		DepthFunction depthFunction = DepthFunction::Less;
+		CullMode cullMode = CullMode::None;
+		ColorFormat colorFormat = ColorFormat::RGBA8888;
+		ClearValue clearValue;
+
+		FrameUniforms frameUniforms;
+		// Deduplicated, a mesh drawn several times is stored once
+		std::vector<Mesh> meshes;
+		std::vector<Material> materials;
+		std::vector<CapturedDraw> draws;
+		std::vector<glm::mat4> instanceTransforms;
+
+		void Record(const Context& context, const FrameUniforms& uniforms, const DrawList& drawList);
+
+		bool Save(const std::string& filepath) const;
+		// Returns false and logs on a missing, truncated or incompatible file, or one with out-of-range values
+		bool Load(const std::string& filepath);
+
+		// Points into meshes, valid while this capture is alive and unchanged
+		void BuildDrawList(DrawList& drawList) const;
+		// Framebuffer size and formats, depth function and cull mode, call outside a render pass
+		void ApplyToContext(Context& context) const;
+
+		static constexpr uint32_t VERSION = 2;
+	};
+}
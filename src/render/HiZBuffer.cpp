@@ -0,0 +1,126 @@
+#include "HiZBuffer.h"
+
+#include "../core/Profiler.h"
+#include "../core/ThreadPool.h"
+
+namespace CPURDR
+{
+	static constexpr size_t PARALLEL_CHUNK_TILE_ROWS = 2;
+
+	// Slack for the meshlet bounds being projected apart from the vertex shader, a few float ulps near 1.0
+	static constexpr float DEPTH_EPSILON = 1e-5f;
+
+	template<DepthFormat Format>
+	void HiZBuffer::Build(const typename DepthFormatTraits<Format>::TextureType& depthBuffer, bool reversedZ)
+	{
+		using DepthTraits = DepthFormatTraits<Format>;
+		PROFILE_SCOPE("HiZBuffer::Build");
+
+		m_Width = (int)depthBuffer.GetWidth();
+		m_Height = (int)depthBuffer.GetHeight();
+		m_ReversedZ = reversedZ;
+
+		int levelWidth = (m_Width + TILE_SIZE - 1) / TILE_SIZE;
+		int levelHeight = (m_Height + TILE_SIZE - 1) / TILE_SIZE;
+		size_t levelCount = 1;
+		for (int size = std::max(levelWidth, levelHeight); size > 1; size = (size + 1) / 2) levelCount++;
+		m_Levels.resize(levelCount);
+
+		for (Level& level : m_Levels)
+		{
+			level.width = levelWidth;
+			level.height = levelHeight;
+			level.farthest.resize((size_t)levelWidth * levelHeight);
+			levelWidth = (levelWidth + 1) / 2;
+			levelHeight = (levelHeight + 1) / 2;
+		}
+
+		Level& base = m_Levels[0];
+		ThreadPool::GetInstance().ParallelFor(0, (size_t)base.height, PARALLEL_CHUNK_TILE_ROWS,
+			[&](size_t begin, size_t end)
+			{
+				for (int ty = (int)begin; ty < (int)end; ++ty)
+				{
+					const int y0 = ty * TILE_SIZE;
+					const int y1 = std::min(y0 + TILE_SIZE, m_Height);
+					for (int tx = 0; tx < base.width; ++tx)
+					{
+						const int x0 = tx * TILE_SIZE;
+						const int x1 = std::min(x0 + TILE_SIZE, m_Width);
+						float farthest = 0.0f;
+						for (int y = y0; y < y1; ++y)
+						{
+							for (int x = x0; x < x1; ++x)
+							{
+								const float depth = DepthTraits::Decode(depthBuffer(x, y));
+								farthest = std::max(farthest, reversedZ? 1.0f - depth : depth);
+							}
+						}
+						base.farthest[(size_t)ty * base.width + tx] = farthest;
+					}
+				}
+			});
+
+		for (size_t l = 1; l < m_Levels.size(); ++l)
+		{
+			const Level& source = m_Levels[l - 1];
+			Level& level = m_Levels[l];
+			for (int y = 0; y < level.height; ++y)
+			{
+				const int sy0 = y * 2;
+				const int sy1 = std::min(sy0 + 1, source.height - 1);
+				for (int x = 0; x < level.width; ++x)
+				{
+					const int sx0 = x * 2;
+					const int sx1 = std::min(sx0 + 1, source.width - 1);
+					level.farthest[(size_t)y * level.width + x] = std::max({source(sx0, sy0), source(sx1, sy0),
+						source(sx0, sy1), source(sx1, sy1)});
+				}
+			}
+		}
+		m_Valid = true;
+	}
+
+	bool HiZBuffer::IsOccluded(int minX, int minY, int maxX, int maxY, float nearestDepth) const
+	{
+		if (!m_Valid) return false;
+
+		minX = std::max(minX, 0);
+		minY = std::max(minY, 0);
+		maxX = std::min(maxX, m_Width - 1);
+		maxY = std::min(maxY, m_Height - 1);
+		if (minX > maxX || minY > maxY) return false;
+
+		// The finest level where the rectangle spans at most 2x2 texels
+		int x0 = minX / TILE_SIZE;
+		int y0 = minY / TILE_SIZE;
+		int x1 = maxX / TILE_SIZE;
+		int y1 = maxY / TILE_SIZE;
+		size_t l = 0;
+		while (l + 1 < m_Levels.size() && (x1 - x0 > 1 || y1 - y0 > 1))
+		{
+			x0 >>= 1;
+			y0 >>= 1;
+			x1 >>= 1;
+			y1 >>= 1;
+			l++;
+		}
+
+		const Level& level = m_Levels[l];
+		float farthest = 0.0f;
+		for (int y = y0; y <= y1; ++y)
+		{
+			for (int x = x0; x <= x1; ++x)
+			{
+				farthest = std::max(farthest, level(x, y));
+			}
+		}
+
+		const float nearest = m_ReversedZ? 1.0f - nearestDepth : nearestDepth;
+		return nearest > farthest + DEPTH_EPSILON;
+	}
+
+	template void HiZBuffer::Build<DepthFormat::D32_Float>(const Texture2D_RFloat&, bool);
+	template void HiZBuffer::Build<DepthFormat::D24_UNorm_S8_UInt>(const Texture2D_D24S8&, bool);
+	template void HiZBuffer::Build<DepthFormat::D16_UNorm>(const Texture2D_D16&, bool);
+}
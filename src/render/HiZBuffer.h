@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+
+#include "DepthFormat.h"
+
+namespace CPURDR
+{
+	// ===============
+	// Hi-Z Buffer
+	// ===============
+	// Farthest depth over TILE_SIZE squared pixel tiles, then halved level by level. Depths are kept in the
+	// standard-Z convention(smaller is nearer) whatever the depth function, so every level takes the maximum
+	class HiZBuffer
+	{
+	public:
+		static constexpr int TILE_SIZE = 8;
+
+		template<DepthFormat Format>
+		void Build(const typename DepthFormatTraits<Format>::TextureType& depthBuffer, bool reversedZ);
+
+		// Until the next Build(), e.g. after the depth buffer was cleared
+		void Invalidate() {m_Valid = false;}
+		bool IsValid() const {return m_Valid;}
+
+		// Whether every pixel in [minX, maxX] x [minY, maxY] already holds a depth nearer than nearestDepth,
+		// which is in the depth function's own convention. Conservative, false when unsure
+		bool IsOccluded(int minX, int minY, int maxX, int maxY, float nearestDepth) const;
+
+	private:
+		struct Level
+		{
+			int width = 0;
+			int height = 0;
+			std::vector<float> farthest;
+
+			float operator()(int x, int y) const {return farthest[(size_t)y * width + x];}
+		};
+
+		std::vector<Level> m_Levels;
+		int m_Width = 0;
+		int m_Height = 0;
+		bool m_ReversedZ = false;
+		bool m_Valid = false;
+	};
+}
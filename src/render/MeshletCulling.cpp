@@ -0,0 +1,148 @@
+#include "MeshletCulling.h"
+
+#include "HiZBuffer.h"
+#include "RasterKernels.h"
+#include "../Model.h"
+
+namespace CPURDR
+{
+	// Corners closer to the camera plane than this leave the occlusion test to the pipeline
+	static constexpr float MIN_CLIP_W = 0.001f;
+
+	static glm::vec3 ToScreen(const glm::mat4& viewProjection, const glm::vec3& position, int width, int height)
+	{
+		const glm::vec4 clip = viewProjection * glm::vec4(position, 1.0f);
+		return glm::vec3((clip.x / clip.w + 1.0f) * 0.5f * (float)width, (clip.y / clip.w + 1.0f) * 0.5f * (float)height, 0.0f);
+	}
+
+	MeshletCullingView MakeMeshletCullingView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition,
+		const Context& context)
+	{
+		MeshletCullingView view;
+		view.viewProjection = viewProjection;
+		view.cameraPosition = cameraPosition;
+		view.width = context.GetFramebufferWidth();
+		view.height = context.GetFramebufferHeight();
+		view.reversedZ = context.IsReversedZ();
+		view.cullMode = context.GetCullMode();
+
+		// Gribb-Hartmann, w +- x and w +- y
+		const glm::mat4 rows = glm::transpose(viewProjection);
+		const glm::vec4 planes[4] = {rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1]};
+		for (int i = 0; i < 4; ++i)
+		{
+			const float length = glm::length(glm::vec3(planes[i]));
+			view.planes[i] = length > 0.0f? planes[i] / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+
+		// Project a small triangle in front of the camera that faces it
+		const glm::vec3 forward = glm::normalize(glm::vec3(rows[3]));
+		const glm::vec3 helper = std::abs(forward.y) < 0.9f? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		const glm::vec3 tangent = glm::normalize(glm::cross(helper, forward));
+		const glm::vec3 bitangent = glm::cross(-forward, tangent);
+		const glm::vec3 center = cameraPosition + forward;
+		const float area = EdgeFunction(ToScreen(viewProjection, center, view.width, view.height),
+			ToScreen(viewProjection, center + tangent * 0.1f, view.width, view.height),
+			ToScreen(viewProjection, center + bitangent * 0.1f, view.width, view.height));
+		view.frontFacingSign = area >= 0.0f? 1.0f : -1.0f;
+		return view;
+	}
+
+	bool IsSphereInView(const MeshletCullingView& view, const glm::vec3& center, float radius)
+	{
+		bool outside = false;
+		for (const glm::vec4& plane : view.planes)
+		{
+			outside |= glm::dot(glm::vec3(plane), center) + plane.w < -radius;
+		}
+		return !outside;
+	}
+
+	// The world space box around the bounding sphere
+	static bool IsOccluded(const glm::vec3& center, float worldRadius, const MeshletCullingView& view)
+	{
+		glm::vec2 screenMin(std::numeric_limits<float>::max());
+		glm::vec2 screenMax(std::numeric_limits<float>::lowest());
+		float nearest = view.reversedZ? 0.0f : 1.0f;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 offset((corner & 1)? worldRadius : -worldRadius, (corner & 2)? worldRadius : -worldRadius,
+				(corner & 4)? worldRadius : -worldRadius);
+			const glm::vec4 clip = view.viewProjection * glm::vec4(center + offset, 1.0f);
+			if (clip.w < MIN_CLIP_W) return false;
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			const glm::vec2 screen = (glm::vec2(ndc) + 1.0f) * 0.5f * glm::vec2(view.width, view.height);
+			screenMin = glm::min(screenMin, screen);
+			screenMax = glm::max(screenMax, screen);
+			nearest = view.reversedZ? std::max(nearest, ndc.z) : std::min(nearest, ndc.z);
+		}
+
+		return view.hiZ->IsOccluded((int)std::floor(screenMin.x), (int)std::floor(screenMin.y),
+			(int)std::floor(screenMax.x), (int)std::floor(screenMax.y), nearest);
+	}
+
+	void CullMeshlets(const Mesh& mesh, const RenderTransform& transform, const MeshletCullingView& view,
+		PipelineStatistics& statistics, std::vector<TriangleRange>& visible)
+	{
+		visible.clear();
+		const uint32_t triangleCount = (uint32_t)(mesh.indices.size() / 3);
+		if (!mesh.meshlets)
+		{
+			if (triangleCount > 0) visible.push_back({0, triangleCount});
+			return;
+		}
+
+		const glm::mat4& objectToWorld = transform.objectToWorld;
+		const glm::mat3 linear(objectToWorld);
+		const float maxScale = std::sqrt(std::max({glm::dot(linear[0], linear[0]), glm::dot(linear[1], linear[1]),
+			glm::dot(linear[2], linear[2])}));
+
+		// The cones are tested in object space, where a mirroring transform flips which side is the back.
+		// Meshlets facing entirely away are only dropped when the rasterizer would reject them too
+		const float determinant = glm::determinant(linear);
+		const float awaySign = -view.frontFacingSign * (determinant < 0.0f? -1.0f : 1.0f);
+		const bool coneCulling = view.cullMode != CullMode::None && determinant != 0.0f &&
+			(awaySign > 0.0f) == (view.cullMode == CullMode::Front);
+		const glm::vec3 cameraObject = glm::vec3(transform.worldToObject * glm::vec4(view.cameraPosition, 1.0f));
+
+		for (const Meshlet& meshlet : *mesh.meshlets)
+		{
+			const glm::vec3 center = glm::vec3(objectToWorld * glm::vec4(meshlet.center, 1.0f));
+			const float radius = meshlet.radius * maxScale;
+
+			if (!IsSphereInView(view, center, radius))
+			{
+				statistics.meshletsFrustumCulled++;
+				continue;
+			}
+
+			if (coneCulling && meshlet.coneCutoff <= 1.0f)
+			{
+				const glm::vec3 toCenter = meshlet.center - cameraObject;
+				if (glm::dot(toCenter, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius)
+				{
+					statistics.meshletsBackfaceCulled++;
+					continue;
+				}
+			}
+
+			if (view.hiZ && IsOccluded(center, radius, view))
+			{
+				statistics.meshletsOcclusionCulled++;
+				continue;
+			}
+
+			statistics.meshletsDrawn++;
+			const uint32_t end = meshlet.firstTriangle + meshlet.triangleCount;
+			if (!visible.empty() && visible.back().end == meshlet.firstTriangle)
+			{
+				visible.back().end = end;
+			}
+			else
+			{
+				visible.push_back({meshlet.firstTriangle, end});
+			}
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+
+#include "glm.hpp"
+#include "Context.h"
+#include "PipelineStatistics.h"
+#include "../Meshlet.h"
+#include "../ecs/components/RenderTransform.h"
+
+namespace CPURDR
+{
+	class HiZBuffer;
+
+	// What CullMeshlets() needs from the frame, prepared once per draw list
+	struct MeshletCullingView
+	{
+		// Left, right, bottom, top, normalized. Near and far are left to the triangle clipper
+		glm::vec4 planes[4];
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+		glm::vec3 cameraPosition = glm::vec3(0.0f);
+		int width = 0;
+		int height = 0;
+		bool reversedZ = false;
+		CullMode cullMode = CullMode::None;
+		// Screen area sign of a triangle facing the camera, depends on the projection's handedness
+		float frontFacingSign = 1.0f;
+		// Skips the occlusion test when nullptr
+		const HiZBuffer* hiZ = nullptr;
+	};
+
+	MeshletCullingView MakeMeshletCullingView(const glm::mat4& viewProjection, const glm::vec3& cameraPosition,
+		const Context& context);
+
+	// False when a world space sphere lies wholly outside one of the view's side planes
+	bool IsSphereInView(const MeshletCullingView& view, const glm::vec3& center, float radius);
+
+	// Replaces visible with the triangle ranges of the meshes' meshlets that may still be seen, adjacent ones
+	// merged. Only drops meshlets whose every triangle the pipeline would reject or hide, so the image is
+	// unchanged. A mesh without meshlets is a single range
+	void CullMeshlets(const Mesh& mesh, const RenderTransform& transform, const MeshletCullingView& view,
+		PipelineStatistics& statistics, std::vector<TriangleRange>& visible);
+}
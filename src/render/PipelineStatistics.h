@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+
+namespace CPURDR
+{
+	// Counters of one render pass, the CPU side equivalent of a GPU pipeline statistics query.
+	// Each rendering thread fills its own copy and merges it into the Context once it is done
+	struct PipelineStatistics
+	{
+		// Draw commands, an instanced one counts once in draws and once per instance in instances
+		uint64_t draws = 0;
+		uint64_t instances = 0;
+
+		// Meshlets, see MeshletCulling.h
+		uint64_t meshletsDrawn = 0;
+		uint64_t meshletsFrustumCulled = 0;
+		uint64_t meshletsBackfaceCulled = 0;
+		uint64_t meshletsOcclusionCulled = 0;
+
+		// Geometry
+		uint64_t verticesShaded = 0;
+		uint64_t vertexCacheHits = 0;   // indices served by the post-transform cache instead of the vertex shader
+		uint64_t trianglesSubmitted = 0;
+		uint64_t backfaceCulled = 0;
+		uint64_t frustumRejected = 0;   // fully outside one clip plane, or behind the camera
+		uint64_t nearClipped = 0;       // crossed the near plane and were split
+		uint64_t zeroAreaRejected = 0;  // degenerate, or too small to cover a pixel center
+		uint64_t trianglesRasterized = 0;
+
+		// Pixels
+		uint64_t pixelsCovered = 0;
+		uint64_t depthFailed = 0;
+		uint64_t fragmentsShaded = 0;
+		uint64_t pixelsWritten = 0;     // fragments that were not discarded
+
+		void Merge(const PipelineStatistics& other)
+		{
+			draws += other.draws;
+			instances += other.instances;
+			meshletsDrawn += other.meshletsDrawn;
+			meshletsFrustumCulled += other.meshletsFrustumCulled;
+			meshletsBackfaceCulled += other.meshletsBackfaceCulled;
+			meshletsOcclusionCulled += other.meshletsOcclusionCulled;
+			verticesShaded += other.verticesShaded;
+			vertexCacheHits += other.vertexCacheHits;
+			trianglesSubmitted += other.trianglesSubmitted;
+			backfaceCulled += other.backfaceCulled;
+			frustumRejected += other.frustumRejected;
+			nearClipped += other.nearClipped;
+			zeroAreaRejected += other.zeroAreaRejected;
+			trianglesRasterized += other.trianglesRasterized;
+			pixelsCovered += other.pixelsCovered;
+			depthFailed += other.depthFailed;
+			fragmentsShaded += other.fragmentsShaded;
+			pixelsWritten += other.pixelsWritten;
+		}
+
+		// Fragments shaded per framebuffer pixel, 1.0 is every pixel shaded exactly once
+		double GetOverdraw(uint64_t framebufferPixels) const
+		{
+			return framebufferPixels > 0? (double)fragmentsShaded / (double)framebufferPixels : 0.0;
+		}
+
+		// Average cache miss ratio, vertex shader invocations per submitted triangle, 3.0 without any reuse
+		double GetACMR() const
+		{
+			return trianglesSubmitted > 0? (double)verticesShaded / (double)trianglesSubmitted : 0.0;
+		}
+
+		// Share of submitted triangles dropped before rasterization
+		double GetCullEfficiency() const
+		{
+			const uint64_t rejected = backfaceCulled + frustumRejected + zeroAreaRejected;
+			return trianglesSubmitted > 0? (double)rejected / (double)trianglesSubmitted : 0.0;
+		}
+	};
+}
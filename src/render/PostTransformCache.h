@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "IShader.h"
+
+namespace CPURDR
+{
+	// Shaded vertices of the most recent indices, replaced first in first out like a GPU's post-transform
+	// cache. MeshOptimizer orders triangles for this exact policy and size
+	class PostTransformCache
+	{
+	public:
+		static constexpr uint32_t SIZE = 32;
+
+		PostTransformCache() {Clear();}
+
+		// Between instances, the same index shades differently
+		void Clear()
+		{
+			m_Tags.fill(INVALID_INDEX);
+			m_Next = 0;
+		}
+
+		const Varyings* Find(uint32_t index) const
+		{
+			for (uint32_t slot = 0; slot < SIZE; ++slot)
+			{
+				if (m_Tags[slot] == index) return &m_Entries[slot];
+			}
+			return nullptr;
+		}
+
+		const Varyings& Insert(uint32_t index, const Varyings& varyings)
+		{
+			const uint32_t slot = m_Next;
+			m_Next = (m_Next + 1) % SIZE;
+			m_Tags[slot] = index;
+			m_Entries[slot] = varyings;
+			return m_Entries[slot];
+		}
+
+	private:
+		static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+		std::array<uint32_t, SIZE> m_Tags;
+		std::array<Varyings, SIZE> m_Entries;
+		uint32_t m_Next = 0;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cmath>
+
+#include "IShader.h"
+
+// Per triangle and per pixel building blocks of RenderPipeline, kept here so the microbenchmarks
+// run the exact code the rasterizer does
+namespace CPURDR
+{
+	constexpr float EDGE_EPSILON = 1e-5f;
+
+	// Twice the signed area of (v0, v1, p), positive when counter-clockwise in screen space
+	inline float EdgeFunction(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& p)
+	{
+		return (p.x - v0.x) * (v1.y - v0.y) - (p.y - v0.y) * (v1.x - v0.x);
+	}
+
+	// E(x, y) = A * x + B * y + C
+	struct EdgeEquation
+	{
+		float A, B, C;
+		bool topLeft;
+
+		float Evaluate(float x, float y) const {return A * x + B * y + C;}
+	};
+
+	inline EdgeEquation MakeEdgeEquation(const glm::vec3& a, const glm::vec3& b)
+	{
+		EdgeEquation e;
+		e.A = b.y - a.y;
+		e.B = a.x - b.x;
+		e.C = b.x * a.y - a.x * b.y;
+
+		// Top-Left rule
+		// A > 0 means y going down for CCW triangle -> left edge
+		// A <= EPS && e.B > 0 -> top edge
+		e.topLeft = (e.A > 0 || (std::abs(e.A) <= EDGE_EPSILON && e.B > 0));
+		return e;
+	}
+
+	// positiveArea is the sign of the triangle's EdgeFunction
+	inline bool IsInsideEdge(float edgeValue, bool topLeft, bool positiveArea)
+	{
+		return positiveArea? (edgeValue >= EDGE_EPSILON || (std::abs(edgeValue) <= EDGE_EPSILON && topLeft)) :
+							(edgeValue <= -EDGE_EPSILON || (std::abs(edgeValue) <= EDGE_EPSILON && topLeft));
+	}
+
+	// Point where the edge from inside to outside crosses w = nearPlane, in clip space
+	inline Varyings ClipLerpVaryings(const Varyings& inside, const Varyings& outside, float nearPlane)
+	{
+		float t = (nearPlane - inside.positionCS.w) / (outside.positionCS.w - inside.positionCS.w);
+
+		Varyings result;
+		result.positionCS = inside.positionCS + t * (outside.positionCS - inside.positionCS);
+		result.positionWS = inside.positionWS + t * (outside.positionWS - inside.positionWS);
+		result.normalWS = glm::normalize(inside.normalWS + t * (outside.normalWS - inside.normalWS));
+		result.uv = inside.uv + t * (outside.uv - inside.uv);
+
+		return result;
+	}
+
+	// Perspective correct, w0 ~ w2 are the screen barycentrics times each vertex's 1/w and invInvW is
+	// one over their sum. positionCS is left untouched
+	inline void InterpolateVaryings(const Varyings& v0, const Varyings& v1, const Varyings& v2,
+		float w0, float w1, float w2, float invInvW, Varyings& result)
+	{
+		result.positionWS = (w0 * v0.positionWS + w1 * v1.positionWS + w2 * v2.positionWS) * invInvW;
+		result.normalWS = glm::normalize((w0 * v0.normalWS + w1 * v1.normalWS + w2 * v2.normalWS) * invInvW);
+		result.uv = (w0 * v0.uv + w1 * v1.uv + w2 * v2.uv) * invInvW;
+	}
+}
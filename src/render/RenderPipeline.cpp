@@ -1,12 +1,22 @@
 #include "RenderPipeline.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
 
 #include "EffectiveMaterial.h"
+#include "FrameCapture.h"
 #include "plog/Log.h"
 #include "ShaderManager.h"
 #include "MaterialManager.h"
 #include "IShader.h"
+#include "PostTransformCache.h"
+#include "RasterKernels.h"
 #include "../Model.h"
+#include "../MeshResidency.h"
+#include "../VertexQuantization.h"
+#include "../core/Profiler.h"
+#include "../core/ThreadPool.h"
 #include "../ecs/components/Transform.h"
 #include "../ecs/components/MeshFilter.h"
 #include "../ecs/components/MeshRenderer.h"
@@ -20,13 +30,62 @@ namespace CPURDR
 		Context* context, const Camera& camera)
 	{
 		if (!context) return;
-
+		PROFILE_SCOPE("RenderPipeline::Render");
 
 		float aspectRatio = (float)context->GetFramebufferWidth() / context->GetFramebufferHeight();
 
 		SetupFrameUniforms(registry, camera, aspectRatio);
+		BuildDrawList(registry, MakeMeshletCullingView(m_FrameUniforms.viewProjectionMatrix, m_FrameUniforms.cameraPosition,
+			*context), m_DrawList);
+
+		if (!m_CapturePath.empty())
+		{
+			FrameCapture capture;
+			capture.Record(*context, m_FrameUniforms, m_DrawList);
+			capture.Save(m_CapturePath);
+			m_CapturePath.clear();
+		}
+
+		RenderDrawList(context, m_FrameUniforms, m_DrawList);
+	}
+
+	void RenderPipeline::RenderDrawList(Context* context, const FrameUniforms& frameUniforms, const DrawList& drawList)
+	{
+		if (!context) return;
+		PROFILE_SCOPE("RenderPipeline::RenderDrawList");
 
-		RenderOpaqueObject(registry, context);
+		if (&frameUniforms != &m_FrameUniforms)
+		{
+			m_FrameUniforms = frameUniforms;
+		}
+
+		PipelineStatistics statistics;
+		MeshletCullingView cullingView = MakeMeshletCullingView(m_FrameUniforms.viewProjectionMatrix,
+			m_FrameUniforms.cameraPosition, *context);
+
+		// The depth buffer only ever gets nearer during the pass, so a stale Hi-Z buffer is merely less effective.
+		// Rebuilt once the draws since the last build covered an eighth of the screen
+		const bool occlusionCulling = m_MeshletCulling && m_OcclusionCulling;
+		const uint64_t rebuildPixels = (uint64_t)context->GetFramebufferWidth() * context->GetFramebufferHeight() / 8;
+		uint64_t coveredAtBuild = 0;
+		m_HiZBuffer.Invalidate();
+
+		for (const DrawCommand& command : drawList.commands)
+		{
+			if (occlusionCulling && statistics.pixelsCovered - coveredAtBuild >= std::max<uint64_t>(rebuildPixels, 1))
+			{
+				BuildHiZBuffer(context);
+				cullingView.hiZ = &m_HiZBuffer;
+				coveredAtBuild = statistics.pixelsCovered;
+			}
+			const std::span<const RenderTransform> instanceTransforms = command.IsInstanced()?
+				std::span<const RenderTransform>(drawList.instanceTransforms).subspan(command.firstInstance, command.instanceCount) :
+				std::span<const RenderTransform>(&command.transform, 1);
+			DrawMesh(*command.mesh, drawList.materials[command.materialIndex], instanceTransforms, context,
+				m_MeshletCulling? &cullingView : nullptr, statistics);
+		}
+		context->MergePipelineStatistics(statistics);
+		context->ResolveTemporal(m_FrameUniforms.viewProjectionMatrix);
 	}
 
 	void RenderPipeline::SetupFrameUniforms(
@@ -58,13 +117,81 @@ namespace CPURDR
 		m_FrameUniforms.ambientLight = glm::vec3(0.15f);
 	}
 
-	void RenderPipeline::RenderOpaqueObject(entt::registry& registry, Context* context)
+	// The bounding sphere of an asset placed in the world
+	struct ProjectedBounds
 	{
-		auto view = registry.view<Transform, MeshFilter, MeshRenderer>();
+		glm::vec3 center;
+		float radius;
+		// Pixels an object space unit covers at the nearest point of the sphere, infinite inside it
+		float pixelsPerUnit;
+	};
+
+	// errorScale converts object space size over distance to pixels
+	static ProjectedBounds ProjectBounds(const MeshAsset& asset, const glm::mat4& objectToWorld,
+		const glm::vec3& cameraPosition, float errorScale)
+	{
+		const float worldScale = std::max({glm::length(glm::vec3(objectToWorld[0])),
+			glm::length(glm::vec3(objectToWorld[1])), glm::length(glm::vec3(objectToWorld[2]))});
+		ProjectedBounds bounds;
+		bounds.center = glm::vec3(objectToWorld * glm::vec4(asset.boundsCenter, 1.0f));
+		bounds.radius = asset.boundsRadius * worldScale;
+		const float distance = glm::length(cameraPosition - bounds.center) - bounds.radius;
+		bounds.pixelsPerUnit = distance > 1e-4f? errorScale * worldScale / distance : std::numeric_limits<float>::infinity();
+		return bounds;
+	}
+
+	// Coarsest level whose error, scaled like the mesh and seen from the nearest point of its bounding sphere,
+	// stays within threshold. Inside the bounds every level is arbitrarily close
+	static size_t SelectLod(const MeshAsset& asset, float pixelsPerUnit, float threshold)
+	{
+		if (threshold <= 0.0f || std::isinf(pixelsPerUnit)) return 0;
+
+		size_t level = 0;
+		while (level + 1 < asset.GetLodCount() && asset.GetLodError(level + 1) * pixelsPerUnit <= threshold)
+		{
+			level++;
+		}
+		return level;
+	}
+
+	void RenderPipeline::BuildDrawList(entt::registry& registry, const MeshletCullingView& cullingView, DrawList& drawList) const
+	{
+		drawList.Clear();
+		// Pixels per world unit at distance 1 along the view direction
+		const float errorScale = 0.5f * (float)cullingView.height * std::abs(m_FrameUniforms.projectionMatrix[1][1]);
+		// RenderTransform is kept current by TransformSystem
+		auto view = registry.view<RenderTransform, MeshFilter, MeshRenderer>();
+
+		// Entities drawing the same meshes with the same material, in the order the first of each was met
+		struct DrawGroup
+		{
+			const std::vector<Mesh>* meshes;
+			const Material* baseMaterial;
+			const MeshRenderer* renderer;
+			uint32_t instanceCount;
+			uint32_t firstInstance;
+		};
+		struct GroupKey
+		{
+			const std::vector<Mesh>* meshes;
+			const Material* material;
+			bool operator==(const GroupKey& other) const = default;
+		};
+		struct GroupKeyHash
+		{
+			size_t operator()(const GroupKey& key) const
+			{
+				return std::hash<const void*>()(key.meshes) ^ (std::hash<const void*>()(key.material) * 31);
+			}
+		};
+		std::vector<DrawGroup> groups;
+		std::unordered_map<GroupKey, uint32_t, GroupKeyHash> groupIndices;
+		// Group of every entity with its transform, in view order
+		std::vector<std::pair<uint32_t, const RenderTransform*>> members;
 
 		for (auto entity : view)
 		{
-			const auto& transform = view.get<Transform>(entity);
+			const auto& transform = view.get<RenderTransform>(entity);
 			const auto& meshFilter = view.get<MeshFilter>(entity);
 			const auto& meshRenderer = view.get<MeshRenderer>(entity);
 
@@ -78,37 +205,169 @@ namespace CPURDR
 			}
 			if (!baseMaterial) continue;
 
+			if (!meshFilter.asset) continue;
+			const MeshAsset& asset = *meshFilter.asset;
+
+			size_t lod = 0;
+			if (!asset.lods.empty())
+			{
+				const ProjectedBounds bounds = ProjectBounds(asset, transform.objectToWorld, cullingView.cameraPosition, errorScale);
+				lod = SelectLod(asset, bounds.pixelsPerUnit, m_LodErrorThreshold);
+				if (asset.stream)
+				{
+					// Only what may be in view asks for finer levels, by how large it is on screen
+					if (IsSphereInView(cullingView, bounds.center, bounds.radius))
+					{
+						asset.stream->Request(lod, asset.boundsRadius * bounds.pixelsPerUnit);
+					}
+					lod = asset.stream->GetResidentLevel(lod);
+				}
+			}
+			const std::vector<Mesh>* meshes = asset.stream? &asset.stream->GetMeshes(lod) : &asset.GetLodMeshes(lod);
+			if (meshes->empty()) continue;
+
+			// Property overrides make the effective material the entity's own
+			uint32_t groupIndex = (uint32_t)groups.size();
+			if (m_Instancing && meshRenderer.propertyOverrides.empty())
+			{
+				groupIndex = groupIndices.try_emplace(GroupKey{meshes, baseMaterial}, groupIndex).first->second;
+			}
+			if (groupIndex == groups.size())
+			{
+				groups.push_back({meshes, baseMaterial, &meshRenderer, 0, 0});
+			}
+			groups[groupIndex].instanceCount++;
+			members.emplace_back(groupIndex, &transform);
+		}
+
+		// Transforms of every group with several instances, contiguous per group
+		uint32_t instanceCount = 0;
+		for (DrawGroup& group : groups)
+		{
+			if (group.instanceCount < 2) continue;
+			group.firstInstance = instanceCount;
+			instanceCount += group.instanceCount;
+		}
+		drawList.instanceTransforms.resize(instanceCount);
+		std::vector<uint32_t> filled(groups.size(), 0);
+		std::vector<const RenderTransform*> singleTransforms(groups.size(), nullptr);
+		for (const auto& [groupIndex, transform] : members)
+		{
+			const DrawGroup& group = groups[groupIndex];
+			if (group.instanceCount < 2)
+			{
+				singleTransforms[groupIndex] = transform;
+				continue;
+			}
+			drawList.instanceTransforms[group.firstInstance + filled[groupIndex]++] = *transform;
+		}
+
+		for (size_t g = 0; g < groups.size(); ++g)
+		{
+			const DrawGroup& group = groups[g];
+
 			// Create effective material with overrides
-			Material effectiveMaterial = CreateEffectiveMaterial(*baseMaterial, meshRenderer);
+			const uint32_t materialIndex = (uint32_t)drawList.materials.size();
+			drawList.materials.push_back(CreateEffectiveMaterial(*group.baseMaterial, *group.renderer));
 
-			for (const auto& mesh : meshFilter.meshes)
+			for (const auto& mesh : *group.meshes)
 			{
-				DrawMesh(mesh, effectiveMaterial, transform, context);
+				if (group.instanceCount < 2)
+				{
+					drawList.commands.push_back({&mesh, materialIndex, *singleTransforms[g]});
+				}
+				else
+				{
+					drawList.commands.push_back({&mesh, materialIndex, RenderTransform(), group.firstInstance, group.instanceCount});
+				}
 			}
 		}
 	}
 
-	Varyings ClipLerpVaryings(const Varyings& inside, const Varyings& outside, float nearPlane)
+	template<DepthFormat Format, DepthFunction Function>
+	static RasterTarget<Format, Function> MakeRasterTarget(Context* context, PipelineStatistics& statistics)
 	{
-		float t = (nearPlane - inside.positionCS.w) / (outside.positionCS.w - inside.positionCS.w);
-
-		Varyings result;
-		result.positionCS = inside.positionCS + t * (outside.positionCS - inside.positionCS);
-		result.positionWS = inside.positionWS + t * (outside.positionWS - inside.positionWS);
-		result.normalWS = glm::normalize(inside.normalWS + t * (outside.normalWS - inside.normalWS));
-		result.uv = inside.uv + t * (outside.uv - inside.uv);
+		RasterTarget<Format, Function> target;
+		target.width = context->GetFramebufferWidth();
+		target.height = context->GetFramebufferHeight();
+		target.colorBuffer = context->GetColorBuffer();
+		target.colorFormat = context->GetColorFormat();
+		target.colorDamage = context->GetColorDamage();
+		target.cullMode = context->GetCullMode();
+		target.statistics = &statistics;
+		target.stats = context->GetStats();
+		target.overdrawBuffer = context->GetOverdrawBuffer();
+		target.shadingCostBuffer = context->GetShadingCostBuffer();
+		target.checkerboardParity = context->GetCheckerboardParity();
+		target.depthBuffer = context->GetDepthAttachment<Format>();
+		return target;
+	}
 
-		return result;
+	void RenderPipeline::BuildHiZBuffer(Context* context)
+	{
+		const bool reversedZ = context->IsReversedZ();
+		switch (context->GetDepthFormat())
+		{
+		case DepthFormat::D32_Float:
+			m_HiZBuffer.Build<DepthFormat::D32_Float>(*context->GetDepthAttachment<DepthFormat::D32_Float>(), reversedZ);
+			break;
+		case DepthFormat::D24_UNorm_S8_UInt:
+			m_HiZBuffer.Build<DepthFormat::D24_UNorm_S8_UInt>(*context->GetDepthAttachment<DepthFormat::D24_UNorm_S8_UInt>(), reversedZ);
+			break;
+		case DepthFormat::D16_UNorm:
+			m_HiZBuffer.Build<DepthFormat::D16_UNorm>(*context->GetDepthAttachment<DepthFormat::D16_UNorm>(), reversedZ);
+			break;
+		}
 	}
 
-	void RenderPipeline::DrawMesh(const Mesh& mesh, const Material& material,
-		const Transform& transform, Context* context) const
+	void RenderPipeline::DrawMesh(const Mesh& mesh, const Material& material, std::span<const RenderTransform> instanceTransforms,
+		Context* context, const MeshletCullingView* cullingView, PipelineStatistics& statistics)
 	{
-		ObjectUniforms objectUniforms;
-		objectUniforms.objectToWorld = transform.GetWorldModelMatrix();
-		objectUniforms.worldToObject = glm::inverse(objectUniforms.objectToWorld);
-		objectUniforms.objectToWorldNormal = glm::transpose(glm::mat3(objectUniforms.worldToObject));
-		objectUniforms.mvp = m_FrameUniforms.viewProjectionMatrix * objectUniforms.objectToWorld;
+		PROFILE_SCOPE("RenderPipeline::DrawMesh");
+		statistics.draws++;
+		statistics.instances += instanceTransforms.size();
+		if (mesh.indices.empty()) return;
+
+		// The inverse and normal matrices come from RenderTransform, only the MVP depends on the frame
+		static constexpr size_t PARALLEL_CHUNK_INSTANCES = 256;
+		const glm::mat4 viewProjection = m_FrameUniforms.viewProjectionMatrix;
+		m_InstanceUniforms.resize(instanceTransforms.size());
+		ThreadPool::GetInstance().ParallelFor(0, instanceTransforms.size(), PARALLEL_CHUNK_INSTANCES,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const RenderTransform& transform = instanceTransforms[i];
+					ObjectUniforms& objectUniforms = m_InstanceUniforms[i];
+					objectUniforms.objectToWorld = transform.objectToWorld;
+					objectUniforms.worldToObject = transform.worldToObject;
+					objectUniforms.objectToWorldNormal = transform.objectToWorldNormal;
+					objectUniforms.mvp = viewProjection * transform.objectToWorld;
+				}
+			});
+
+		m_VisibleInstances.clear();
+		m_VisibleRanges.clear();
+		for (size_t i = 0; i < instanceTransforms.size(); ++i)
+		{
+			const uint32_t firstRange = (uint32_t)m_VisibleRanges.size();
+			if (cullingView)
+			{
+				CullMeshlets(mesh, instanceTransforms[i], *cullingView, statistics, m_MeshletRanges);
+				m_VisibleRanges.insert(m_VisibleRanges.end(), m_MeshletRanges.begin(), m_MeshletRanges.end());
+			}
+			else
+			{
+				m_VisibleRanges.push_back({0, (uint32_t)(mesh.indices.size() / 3)});
+			}
+			if (m_VisibleRanges.size() > firstRange)
+			{
+				m_VisibleInstances.push_back({&m_InstanceUniforms[i], firstRange, (uint32_t)m_VisibleRanges.size()});
+			}
+		}
+		if (m_VisibleInstances.empty()) return;
+		const std::span<const VisibleInstance> instances = m_VisibleInstances;
+		const std::span<const TriangleRange> ranges = m_VisibleRanges;
 
 		IShader* shader = ShaderManager::GetInstance().GetShader(material.shaderId);
 		if (!shader)
@@ -117,179 +376,262 @@ namespace CPURDR
 		}
 		if (!shader) return;
 
+		// DrawTriangles() points object at each instance
 		ShaderUniforms uniforms;
 		uniforms.frame = &m_FrameUniforms;
-		uniforms.object = &objectUniforms;
 		uniforms.material = &material;
 
-		int width = context->GetFramebufferWidth();
-		int height = context->GetFramebufferHeight();
-		Texture2D_RGBA* colorBuffer = context->GetColorBuffer();
-		Texture2D_RFloat* depthBuffer = context->GetDepthBuffer();
+		const bool reversedZ = context->IsReversedZ();
+		switch (context->GetDepthFormat())
+		{
+		case DepthFormat::D32_Float:
+			if (reversedZ)
+				DrawTriangles(mesh, instances, ranges, shader, uniforms, MakeRasterTarget<DepthFormat::D32_Float, DepthFunction::Greater>(context, statistics));
+			else
+				DrawTriangles(mesh, instances, ranges, shader, uniforms, MakeRasterTarget<DepthFormat::D32_Float, DepthFunction::Less>(context, statistics));
+			break;
+		case DepthFormat::D24_UNorm_S8_UInt:
+			if (reversedZ)
+				DrawTriangles(mesh, instances, ranges, shader, uniforms, MakeRasterTarget<DepthFormat::D24_UNorm_S8_UInt, DepthFunction::Greater>(context, statistics));
+			else
+				DrawTriangles(mesh, instances, ranges, shader, uniforms, MakeRasterTarget<DepthFormat::D24_UNorm_S8_UInt, DepthFunction::Less>(context, statistics));
+			break;
+		case DepthFormat::D16_UNorm:
+			if (reversedZ)
+				DrawTriangles(mesh, instances, ranges, shader, uniforms, MakeRasterTarget<DepthFormat::D16_UNorm, DepthFunction::Greater>(context, statistics));
+			else
+				DrawTriangles(mesh, instances, ranges, shader, uniforms, MakeRasterTarget<DepthFormat::D16_UNorm, DepthFunction::Less>(context, statistics));
+			break;
+		}
+	}
+
+	template<DepthFormat Format, DepthFunction Function>
+	void RenderPipeline::DrawTriangles(const Mesh& mesh, std::span<const VisibleInstance> instances,
+		std::span<const TriangleRange> ranges, const IShader* shader, const ShaderUniforms& frameUniforms,
+		const RasterTarget<Format, Function>& target)
+	{
+		if (!target.colorBuffer || !target.depthBuffer) return;
+		PROFILE_SCOPE("RenderPipeline::RasterizeTriangles");
 
 		const auto& vertices = mesh.vertices;
 		const auto& indices = mesh.indices;
 		const float NEAR_PLANE = 0.001;
 
-		for (size_t i = 0; i < indices.size(); i+=3)
+		// Quantized meshes decode right here, the full precision vertex never exists in memory
+		const bool quantized = mesh.IsQuantized();
+		auto fetchVertex = [&](unsigned int index) -> VertexInput
 		{
-			VertexInput v0in =
+			if (quantized)
 			{
-				vertices[indices[i]].position,
-				vertices[indices[i]].normal,
-				vertices[indices[i]].texcoord
-			};
+				const Vertex vertex = DecodeVertex(mesh.quantizedVertices[index], mesh.positionOffset, mesh.positionScale);
+				return {vertex.position, vertex.normal, vertex.texcoord};
+			}
+			return {vertices[index].position, vertices[index].normal, vertices[index].texcoord};
+		};
 
-			VertexInput v1in =
-			{
-				vertices[indices[i + 1]].position,
-				vertices[indices[i + 1]].normal,
-				vertices[indices[i + 1]].texcoord
-			};
+		// Charges the time since the previous lap to a stage, whatever runs between laps outside
+		// vertex processing and rasterization is rejection and clipping
+		RenderStats* stats = target.stats;
+		uint64_t lapStart = stats? RenderStats::Now() : 0;
+		auto lap = [stats, &lapStart](RenderStage stage)
+		{
+			if (!stats) return;
+			const uint64_t now = RenderStats::Now();
+			stats->AddTicks(stage, (int64_t)(now - lapStart));
+			lapStart = now;
+		};
+		PipelineStatistics& statistics = *target.statistics;
+		for (const TriangleRange& range : ranges)
+		{
+			statistics.trianglesSubmitted += range.end - range.first;
+		}
 
-			VertexInput v2in =
+		ShaderUniforms uniforms = frameUniforms;
+		PostTransformCache vertexCache;
+		auto shadeVertex = [&](unsigned int index) -> Varyings
+		{
+			if (const Varyings* cached = vertexCache.Find(index))
 			{
-				vertices[indices[i + 2]].position,
-				vertices[indices[i + 2]].normal,
-				vertices[indices[i + 2]].texcoord
-			};
-
-			Varyings v0 = shader->Vertex(v0in, uniforms);
-			Varyings v1 = shader->Vertex(v1in, uniforms);
-			Varyings v2 = shader->Vertex(v2in, uniforms);
-
-			bool front0 = v0.positionCS.w >= NEAR_PLANE;
-			bool front1 = v1.positionCS.w >= NEAR_PLANE;
-			bool front2 = v2.positionCS.w >= NEAR_PLANE;
-
-			int behindCount = (!front0) + (!front1) + (!front2);
-
-			if (behindCount == 3) continue;
+				statistics.vertexCacheHits++;
+				return *cached;
+			}
+			statistics.verticesShaded++;
+			return vertexCache.Insert(index, shader->Vertex(fetchVertex(index), uniforms));
+		};
 
-			if (behindCount == 0)
+		// The ranges of the instances follow each other, every instance starts with an empty cache
+		const VisibleInstance* instance = instances.data();
+		for (size_t r = 0; r < ranges.size(); ++r)
+		{
+			if (r == instance->endRange) instance++;
+			if (r == instance->firstRange)
+			{
+				uniforms.object = instance->object;
+				vertexCache.Clear();
+			}
+			const TriangleRange& range = ranges[r];
+			for (size_t i = (size_t)range.first * 3; i < (size_t)range.end * 3; i+=3)
 			{
-				// Store invW for perspective correction
-				float invW0 = 1.0f / v0.positionCS.w;
-				float invW1 = 1.0f / v1.positionCS.w;
-				float invW2 = 1.0f / v2.positionCS.w;
+				lap(RenderStage::Clip);
 
-				v0.positionCS *= invW0;
-				v1.positionCS *= invW1;
-				v2.positionCS *= invW2;
+				Varyings v0 = shadeVertex(indices[i]);
+				Varyings v1 = shadeVertex(indices[i + 1]);
+				Varyings v2 = shadeVertex(indices[i + 2]);
+				lap(RenderStage::Vertex);
 
-				v0.positionCS.w = invW0;
-				v1.positionCS.w = invW1;
-				v2.positionCS.w = invW2;
+				bool front0 = v0.positionCS.w >= NEAR_PLANE;
+				bool front1 = v1.positionCS.w >= NEAR_PLANE;
+				bool front2 = v2.positionCS.w >= NEAR_PLANE;
 
-				bool clipX = (v0.positionCS.x < -1 && v1.positionCS.x < -1 && v2.positionCS.x < -1) ||
-							 (v0.positionCS.x > 1 && v1.positionCS.x > 1 && v2.positionCS.x > 1);
-				bool clipY = (v0.positionCS.y < -1 && v1.positionCS.y < -1 && v2.positionCS.y < -1) ||
-							 (v0.positionCS.y > 1 && v1.positionCS.y > 1 && v2.positionCS.y > 1);
-				bool clipZ = (v0.positionCS.z < 0 && v1.positionCS.z < 0 && v2.positionCS.z < 0) ||
-							 (v0.positionCS.z > 1 && v1.positionCS.z > 1 && v2.positionCS.z > 1);
+				int behindCount = (!front0) + (!front1) + (!front2);
 
-				if (clipX || clipY || clipZ) continue;
+				if (behindCount == 3)
+				{
+					statistics.frustumRejected++;
+					continue;
+				}
 
-				RasterizeTriangle(v0, v1, v2, shader, uniforms, width, height,
-					*depthBuffer, *colorBuffer);
+				if (behindCount == 0)
+				{
+					// Store invW for perspective correction
+					float invW0 = 1.0f / v0.positionCS.w;
+					float invW1 = 1.0f / v1.positionCS.w;
+					float invW2 = 1.0f / v2.positionCS.w;
+
+					v0.positionCS *= invW0;
+					v1.positionCS *= invW1;
+					v2.positionCS *= invW2;
+
+					v0.positionCS.w = invW0;
+					v1.positionCS.w = invW1;
+					v2.positionCS.w = invW2;
+
+					bool clipX = (v0.positionCS.x < -1 && v1.positionCS.x < -1 && v2.positionCS.x < -1) ||
+								 (v0.positionCS.x > 1 && v1.positionCS.x > 1 && v2.positionCS.x > 1);
+					bool clipY = (v0.positionCS.y < -1 && v1.positionCS.y < -1 && v2.positionCS.y < -1) ||
+								 (v0.positionCS.y > 1 && v1.positionCS.y > 1 && v2.positionCS.y > 1);
+					// Reversed-Z uses an infinite far plane, so only the near side(z > 1) can reject
+					bool clipZ = (v0.positionCS.z > 1 && v1.positionCS.z > 1 && v2.positionCS.z > 1);
+					if constexpr (Function == DepthFunction::Less)
+					{
+						clipZ |= (v0.positionCS.z < 0 && v1.positionCS.z < 0 && v2.positionCS.z < 0);
+					}
+
+					if (clipX || clipY || clipZ)
+					{
+						statistics.frustumRejected++;
+						continue;
+					}
+
+					lap(RenderStage::Clip);
+					RasterizeTriangle(v0, v1, v2, shader, uniforms, target);
+					lap(RenderStage::Raster);
+
+					continue;;
+				}
 
-				continue;;
+				statistics.nearClipped++;
+
+				Varyings clipped[4];
+	            int clipCount = 0;
+
+	            // Two vertices clipped (one visible) -> produces 1 triangle
+	            if (front0 && !front1 && !front2)
+	            {
+	                clipped[0] = v0;
+	                clipped[1] = ClipLerpVaryings(v0, v1, NEAR_PLANE);
+	                clipped[2] = ClipLerpVaryings(v0, v2, NEAR_PLANE);
+	                clipCount = 3;
+	            }
+	            else if (front1 && !front0 && !front2)
+	            {
+	                clipped[0] = v1;
+	                clipped[1] = ClipLerpVaryings(v1, v2, NEAR_PLANE);
+	                clipped[2] = ClipLerpVaryings(v1, v0, NEAR_PLANE);
+	                clipCount = 3;
+	            }
+	            else if (front2 && !front0 && !front1)
+	            {
+	                clipped[0] = v2;
+	                clipped[1] = ClipLerpVaryings(v2, v0, NEAR_PLANE);
+	                clipped[2] = ClipLerpVaryings(v2, v1, NEAR_PLANE);
+	                clipCount = 3;
+	            }
+	            // One vertex clipped (two visible) -> produces 2 triangles (quad)
+	            else if (front0 && front1 && !front2)
+	            {
+	                clipped[0] = v0;
+	                clipped[1] = v1;
+	                clipped[2] = ClipLerpVaryings(v1, v2, NEAR_PLANE);
+	                clipped[3] = ClipLerpVaryings(v0, v2, NEAR_PLANE);
+	                clipCount = 4;
+	            }
+	            else if (front1 && front2 && !front0)
+	            {
+	                clipped[0] = v1;
+	                clipped[1] = v2;
+	                clipped[2] = ClipLerpVaryings(v2, v0, NEAR_PLANE);
+	                clipped[3] = ClipLerpVaryings(v1, v0, NEAR_PLANE);
+	                clipCount = 4;
+	            }
+	            else if (front2 && front0 && !front1)
+	            {
+	                clipped[0] = v2;
+	                clipped[1] = v0;
+	                clipped[2] = ClipLerpVaryings(v0, v1, NEAR_PLANE);
+	                clipped[3] = ClipLerpVaryings(v2, v1, NEAR_PLANE);
+	                clipCount = 4;
+	            }
+
+	            // Perspective divide for clipped vertices
+	            auto perspectiveDivide = [](Varyings& v) {
+
+	            	// Store invW for perspective correction
+	            	float invW = 1.0f / v.positionCS.w;
+	            	v.positionCS *= invW;
+	            	v.positionCS.w = invW;
+	            };
+
+	            if (clipCount == 3)
+	            {
+	                perspectiveDivide(clipped[0]);
+	                perspectiveDivide(clipped[1]);
+	                perspectiveDivide(clipped[2]);
+	                lap(RenderStage::Clip);
+	                RasterizeTriangle(clipped[0], clipped[1], clipped[2], shader, uniforms, target);
+	                lap(RenderStage::Raster);
+	            }
+	            else if (clipCount == 4)
+	            {
+	                perspectiveDivide(clipped[0]);
+	                perspectiveDivide(clipped[1]);
+	                perspectiveDivide(clipped[2]);
+	                perspectiveDivide(clipped[3]);
+	                lap(RenderStage::Clip);
+
+	                // Render as two triangles
+	                RasterizeTriangle(clipped[0], clipped[1], clipped[2], shader, uniforms, target);
+	                RasterizeTriangle(clipped[0], clipped[2], clipped[3], shader, uniforms, target);
+	                lap(RenderStage::Raster);
+	            }
 			}
-
-			Varyings clipped[4];
-            int clipCount = 0;
-
-            // Two vertices clipped (one visible) -> produces 1 triangle
-            if (front0 && !front1 && !front2)
-            {
-                clipped[0] = v0;
-                clipped[1] = ClipLerpVaryings(v0, v1, NEAR_PLANE);
-                clipped[2] = ClipLerpVaryings(v0, v2, NEAR_PLANE);
-                clipCount = 3;
-            }
-            else if (front1 && !front0 && !front2)
-            {
-                clipped[0] = v1;
-                clipped[1] = ClipLerpVaryings(v1, v0, NEAR_PLANE);
-                clipped[2] = ClipLerpVaryings(v1, v2, NEAR_PLANE);
-                clipCount = 3;
-            }
-            else if (front2 && !front0 && !front1)
-            {
-                clipped[0] = v2;
-                clipped[1] = ClipLerpVaryings(v2, v0, NEAR_PLANE);
-                clipped[2] = ClipLerpVaryings(v2, v1, NEAR_PLANE);
-                clipCount = 3;
-            }
-            // One vertex clipped (two visible) -> produces 2 triangles (quad)
-            else if (front0 && front1 && !front2)
-            {
-                clipped[0] = v0;
-                clipped[1] = v1;
-                clipped[2] = ClipLerpVaryings(v1, v2, NEAR_PLANE);
-                clipped[3] = ClipLerpVaryings(v0, v2, NEAR_PLANE);
-                clipCount = 4;
-            }
-            else if (front1 && front2 && !front0)
-            {
-                clipped[0] = v1;
-                clipped[1] = v2;
-                clipped[2] = ClipLerpVaryings(v2, v0, NEAR_PLANE);
-                clipped[3] = ClipLerpVaryings(v1, v0, NEAR_PLANE);
-                clipCount = 4;
-            }
-            else if (front2 && front0 && !front1)
-            {
-                clipped[0] = v2;
-                clipped[1] = v0;
-                clipped[2] = ClipLerpVaryings(v0, v1, NEAR_PLANE);
-                clipped[3] = ClipLerpVaryings(v2, v1, NEAR_PLANE);
-                clipCount = 4;
-            }
-
-            // Perspective divide for clipped vertices
-            auto perspectiveDivide = [](Varyings& v) {
-
-            	// Store invW for perspective correction
-            	float invW = 1.0f / v.positionCS.w;
-            	v.positionCS *= invW;
-            	v.positionCS.w = invW;
-            };
-
-            if (clipCount == 3)
-            {
-                perspectiveDivide(clipped[0]);
-                perspectiveDivide(clipped[1]);
-                perspectiveDivide(clipped[2]);
-                RasterizeTriangle(clipped[0], clipped[1], clipped[2], shader, uniforms,
-                                  width, height, *depthBuffer, *colorBuffer);
-            }
-            else if (clipCount == 4)
-            {
-                perspectiveDivide(clipped[0]);
-                perspectiveDivide(clipped[1]);
-                perspectiveDivide(clipped[2]);
-                perspectiveDivide(clipped[3]);
-
-                // Render as two triangles
-                RasterizeTriangle(clipped[0], clipped[1], clipped[2], shader, uniforms,
-                                  width, height, *depthBuffer, *colorBuffer);
-                RasterizeTriangle(clipped[0], clipped[2], clipped[3], shader, uniforms,
-                                  width, height, *depthBuffer, *colorBuffer);
-            }
 		}
+		lap(RenderStage::Clip);
 	}
 
-	inline float EdgeFunction(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& p)
-	{
-		return (p.x - v0.x) * (v1.y - v0.y) - (p.y - v0.y) * (v1.x - v0.x);
-	}
-
+	template<DepthFormat Format, DepthFunction Function>
 	void RenderPipeline::RasterizeTriangle(
 		const Varyings& v0, const Varyings& v1, const Varyings& v2,
-		const IShader* shader, const ShaderUniforms& uniforms, int width, int height,
-		Texture2D_RFloat& depthBuffer, Texture2D_RGBA& colorBuffer)
+		const IShader* shader, const ShaderUniforms& uniforms,
+		const RasterTarget<Format, Function>& target)
 	{
+		using DepthTraits = DepthFormatTraits<Format>;
+
+		const int width = target.width;
+		const int height = target.height;
+		auto& depthBuffer = *target.depthBuffer;
+		Texture2D_RGBA& colorBuffer = *target.colorBuffer;
+
 		auto toScreen = [&](const glm::vec4& posCS) -> glm::vec3
 		{
 			return glm::vec3(
@@ -308,13 +650,21 @@ namespace CPURDR
 		glm::vec3 s1 = toScreen(pv1.positionCS);
 		glm::vec3 s2 = toScreen(pv2.positionCS);
 
+		PipelineStatistics& statistics = *target.statistics;
+
 		float area = EdgeFunction(s0, s1, s2);
-		if (std::abs(area) < 1e-5f) return;
-		//
-		// if (area < 0.0f)
-		// {
-		// 	return;
-		// }
+		if (std::abs(area) < 1e-5f)
+		{
+			statistics.zeroAreaRejected++;
+			return;
+		}
+
+		// Counter-clockwise(front facing) triangles end up with a positive area in screen space
+		if (target.cullMode != CullMode::None && (area > 0.0f) == (target.cullMode == CullMode::Front))
+		{
+			statistics.backfaceCulled++;
+			return;
+		}
 
 		// Bounding box, adjust for pixel center sampling
 		int minX = std::max(0, (int)std::ceil(std::min({s0.x, s1.x, s2.x}) - 0.5f));
@@ -322,59 +672,33 @@ namespace CPURDR
 		int minY = std::max(0, (int)std::ceil(std::min({s0.y, s1.y, s2.y}) - 0.5));
 		int maxY = std::min(height - 1, (int)std::floor(std::max({s0.y, s1.y, s2.y}) - 0.5));
 
-		if (minX > maxX || minY > maxY) return;
-
-		float invArea = 1.0f / area;
-		const float EPS = 1e-5f;
-
-		// E(x, y) = A * x + B * y + C
-		struct EdgeEquation
-		{
-			float A, B, C;
-			bool topLeft;
-		};
-
-		auto makeEdgeEquation = [&](const glm::vec3& a, const glm::vec3& b) -> EdgeEquation
+		if (minX > maxX || minY > maxY)
 		{
-			EdgeEquation e;
-			e.A = b.y - a.y;
-			e.B = a.x - b.x;
-			e.C = b.x * a.y - a.x * b.y;
-
-			// Top-Left rule
-			// A > 0 means y going down for CCW triangle -> left edge
-			// A <= EPS && e.B > 0 -> top edge
-			e.topLeft = (e.A > 0 || (std::abs(e.A) <= EPS && e.B > 0));
-			return e;
-		};
-
-		//  Evaluate edge equation at a given point
-		auto eval = [](const EdgeEquation& e, float x, float y) -> float
-		{
-			return e.A * x + e.B * y + e.C;
-		};
+			statistics.zeroAreaRejected++;
+			return;
+		}
+		statistics.trianglesRasterized++;
 
-		// Test is inside the triangle
-		auto isInside = [&](float edgeValue, bool topLeft) -> bool
-		{
-			// return (edgeValue > EPS) || (std::abs(edgeValue) <= EPS && topLeft);
-			return (area > 0)? (edgeValue >= EPS || (std::abs(edgeValue) <= EPS && topLeft)) :
-								(edgeValue <= -EPS || (std::abs(edgeValue) <= EPS && topLeft));
-		};
+		// The caller charges the whole call to Raster, shading time is moved over to Shade
+		RenderStats* stats = target.stats;
+		int64_t shadeTicks = 0;
 
-		auto packColor = [](const glm::vec4& c) -> uint32_t
+		float invArea = 1.0f / area;
+		const bool positiveArea = area > 0;
+
+		ColorDamage* colorDamage = target.colorDamage;
+		Texture2D_S8* overdrawBuffer = target.overdrawBuffer;
+		Texture2D_R32UI* shadingCostBuffer = target.shadingCostBuffer;
+		const int checkerboardParity = target.checkerboardParity;
+		const ColorFormat colorFormat = target.colorFormat;
+		auto packColor = [colorFormat](const glm::vec4& c) -> uint32_t
 		{
-			const glm::vec4 clamped = glm::clamp(c, 0.0f, 1.0f);
-			uint8_t r = (uint8_t)(clamped.r * 255.0f);
-			uint8_t g = (uint8_t)(clamped.g * 255.0f);
-			uint8_t b = (uint8_t)(clamped.b * 255.0f);
-			uint8_t a = (uint8_t)(clamped.a * 255.0f);
-			return r << 24 | g << 16 | b << 8 | a;
+			return PackColor(c, colorFormat);
 		};
 
-		const EdgeEquation e0eq = makeEdgeEquation(s1, s2);
-		const EdgeEquation e1eq = makeEdgeEquation(s2, s0);
-		const EdgeEquation e2eq = makeEdgeEquation(s0, s1);
+		const EdgeEquation e0eq = MakeEdgeEquation(s1, s2);
+		const EdgeEquation e1eq = MakeEdgeEquation(s2, s0);
+		const EdgeEquation e2eq = MakeEdgeEquation(s0, s1);
 
 		// offset 0.5f to sample pixel center
 		const float startX = (float)minX + 0.5f;
@@ -386,9 +710,9 @@ namespace CPURDR
 			const float py = (float)by + 0.5f;
 
 			// Evaluate each edge at the first lane of the row
-			float e0Row = eval(e0eq, startX, py);
-			float e1Row = eval(e1eq, startX, py);
-			float e2Row = eval(e2eq, startX, py);
+			float e0Row = e0eq.Evaluate(startX, py);
+			float e1Row = e1eq.Evaluate(startX, py);
+			float e2Row = e2eq.Evaluate(startX, py);
 
 			for (int bx = minX; bx <= maxX; bx+=2)
 			{
@@ -441,10 +765,11 @@ namespace CPURDR
 				{
 					if (!valid[lane]) continue;
 					covered[lane] =
-						isInside(e0Lane[lane], e0eq.topLeft) &&
-						isInside(e1Lane[lane], e1eq.topLeft) &&
-						isInside(e2Lane[lane], e2eq.topLeft);
+						IsInsideEdge(e0Lane[lane], e0eq.topLeft, positiveArea) &&
+						IsInsideEdge(e1Lane[lane], e1eq.topLeft, positiveArea) &&
+						IsInsideEdge(e2Lane[lane], e2eq.topLeft, positiveArea);
 					anyCovered |= covered[lane];
+					statistics.pixelsCovered += covered[lane];
 				}
 
 				// Skip if no cover at all
@@ -457,6 +782,7 @@ namespace CPURDR
 				}
 
 				// Shade only covered pixels
+				const uint64_t shadeStart = stats? RenderStats::Now() : 0;
 				for (int lane = 0; lane < 4; lane++)
 				{
 					if (!valid[lane] || !covered[lane]) continue;
@@ -472,31 +798,65 @@ namespace CPURDR
 					float invW = w0 + w1 + w2;
 					if (invW <= 0.0f) continue;
 
-					float depth = (w0 * s0.z + w1 * s1.z + w2 * s2.z) * (1.0f / invW);
-
-					if (depth < 0.0f || depth > 1.0f) continue;
-					if (depth >= depthBuffer(p[lane].x, p[lane].y)) continue;
+					// z/w is affine in screen space, only the varyings need perspective correction. Weighting it by 1/w
+					// too let large triangles win depth tests they should lose, the references in resources/golden
+					// were rendered with the screen-space weights
+					float depth = b0 * s0.z + b1 * s1.z + b2 * s2.z;
+
+					auto& depthTexel = depthBuffer(p[lane].x, p[lane].y);
+					const typename DepthTraits::DepthType encodedDepth = DepthTraits::Encode(depth);
+					if (depth < 0.0f || depth > 1.0f || !PassesDepthTest<Function>(encodedDepth, DepthTraits::Load(depthTexel)))
+					{
+						statistics.depthFailed++;
+						continue;
+					}
+
+					// Left for Context::ResolveTemporal(), which needs the depth but not the shading
+					if (checkerboardParity >= 0 && (((int)p[lane].x + (int)p[lane].y) & 1) != checkerboardParity)
+					{
+						depthTexel = DepthTraits::Store(depthTexel, encodedDepth);
+						if (colorDamage) colorDamage->MarkPixel((int)p[lane].x, (int)p[lane].y);
+						continue;
+					}
 
 					float invInvW = 1.0f / invW;
 
 					Varyings i;
-					i.positionWS = (w0 * pv0.positionWS + w1 * pv1.positionWS + w2 * pv2.positionWS) * invInvW;
-					i.normalWS = glm::normalize((w0 * pv0.normalWS + w1 * pv1.normalWS + w2 * pv2.normalWS) * invInvW);
-					i.uv = (w0 * pv0.uv + w1 * pv1.uv + w2 * pv2.uv) * invInvW;
+					InterpolateVaryings(pv0, pv1, pv2, w0, w1, w2, invInvW, i);
 
+					const uint64_t fragmentStart = shadingCostBuffer? ReadCycleCounter() : 0;
 					glm::vec4 color = shader->Fragment(i, uniforms);
+					statistics.fragmentsShaded++;
+					if (shadingCostBuffer)
+					{
+						(*shadingCostBuffer)(p[lane].x, p[lane].y) += (uint32_t)(ReadCycleCounter() - fragmentStart);
+					}
+					if (overdrawBuffer)
+					{
+						uint8_t& fragments = (*overdrawBuffer)(p[lane].x, p[lane].y);
+						fragments += fragments < 255;
+					}
 
 					if (color.a <= 0.0f) continue;
+					statistics.pixelsWritten++;
 
-					depthBuffer(p[lane].x, p[lane].y) = depth;
+					depthTexel = DepthTraits::Store(depthTexel, encodedDepth);
 					colorBuffer(p[lane].x, p[lane].y) = packColor(color);
+					if (colorDamage) colorDamage->MarkPixel((int)p[lane].x, (int)p[lane].y);
 				}
+				if (stats) shadeTicks += (int64_t)(RenderStats::Now() - shadeStart);
 
 				e0Row += 2.0f * e0eq.A;
 				e1Row += 2.0f * e1eq.A;
 				e2Row += 2.0f * e2eq.A;
 			}
 		}
+
+		if (stats)
+		{
+			stats->AddTicks(RenderStage::Shade, shadeTicks);
+			stats->AddTicks(RenderStage::Raster, -shadeTicks);
+		}
 	}
 
 }
\ No newline at end of file
@@ -1,17 +1,41 @@
 #pragma once
+#include <algorithm>
 #include "entt.hpp"
 
 #include "Context.h"
+#include "DrawCommand.h"
+#include "HiZBuffer.h"
 #include "IShader.h"
+#include "MeshletCulling.h"
 #include "../Camera.h"
 
 namespace CPURDR
 {
 	struct Mesh;
 	struct Material;
-	struct Transform;
 	class IShader;
 
+	template<DepthFormat Format, DepthFunction Function>
+	struct RasterTarget
+	{
+		int width = 0;
+		int height = 0;
+		typename DepthFormatTraits<Format>::TextureType* depthBuffer = nullptr;
+		Texture2D_RGBA* colorBuffer = nullptr;
+		ColorFormat colorFormat = ColorFormat::RGBA8888;
+		ColorDamage* colorDamage = nullptr;
+		CullMode cullMode = CullMode::None;
+		// Owned by the rendering thread, merged into the context after the pass
+		PipelineStatistics* statistics = nullptr;
+		// nullptr unless the context collects stats
+		RenderStats* stats = nullptr;
+		// nullptr unless the matching debug view is selected
+		Texture2D_S8* overdrawBuffer = nullptr;
+		Texture2D_R32UI* shadingCostBuffer = nullptr;
+		// See Context::GetCheckerboardParity
+		int checkerboardParity = -1;
+	};
+
 	class RenderPipeline
 	{
 	public:
@@ -19,19 +43,74 @@ namespace CPURDR
 		~RenderPipeline() = default;
 
 		void Render(entt::registry& registry, Context* context, const Camera& camera);
+		// Executes a prepared draw list, this is all Render() does once the scene has been walked
+		void RenderDrawList(Context* context, const FrameUniforms& frameUniforms, const DrawList& drawList);
+
+		// The next Render() also writes its inputs to filepath as a FrameCapture
+		void RequestCapture(const std::string& filepath) {m_CapturePath = filepath;}
+
+		// Skips the meshlets of a mesh outside the frustum or facing away from the camera, see MeshletCulling.h
+		void SetMeshletCulling(bool enabled) {m_MeshletCulling = enabled;}
+		bool IsMeshletCullingEnabled() const {return m_MeshletCulling;}
+
+		// Also skips meshlets behind the depth drawn earlier in the frame, through a Hi-Z buffer rebuilt
+		// between draws. Needs meshlet culling
+		void SetOcclusionCulling(bool enabled) {m_OcclusionCulling = enabled;}
+		bool IsOcclusionCullingEnabled() const {return m_OcclusionCulling;}
+
+		// Draws the coarsest level of detail of a mesh asset whose error projects to at most this many pixels,
+		// 0 always draws the full detail meshes
+		void SetLodErrorThreshold(float pixels) {m_LodErrorThreshold = std::max(pixels, 0.0f);}
+		float GetLodErrorThreshold() const {return m_LodErrorThreshold;}
+
+		// Entities sharing a mesh asset, level of detail and material without overrides become one instanced draw
+		void SetInstancing(bool enabled) {m_Instancing = enabled;}
+		bool IsInstancingEnabled() const {return m_Instancing;}
 
 	private:
+		// An instance that survived meshlet culling, it draws m_VisibleRanges[firstRange, endRange)
+		struct VisibleInstance
+		{
+			const ObjectUniforms* object;
+			uint32_t firstRange;
+			uint32_t endRange;
+		};
+
 		void SetupFrameUniforms(entt::registry& registry, const Camera& camera, float aspectRatio);
-		void RenderOpaqueObject(entt::registry& registry, Context* context);
+		// Also asks the streams of visible streamed assets for the levels they should draw, see MeshResidency.h
+		void BuildDrawList(entt::registry& registry, const MeshletCullingView& cullingView, DrawList& drawList) const;
+
+		// Draws the mesh once per transform. cullingView is nullptr when meshlet culling is off
+		void DrawMesh(const Mesh& mesh, const Material& material, std::span<const RenderTransform> instanceTransforms,
+			Context* context, const MeshletCullingView* cullingView, PipelineStatistics& statistics);
 
-		void DrawMesh(const Mesh& mesh, const Material& material, const Transform& transform, Context* context) const;
+		void BuildHiZBuffer(Context* context);
+
+		template<DepthFormat Format, DepthFunction Function>
+		static void DrawTriangles(const Mesh& mesh, std::span<const VisibleInstance> instances,
+			std::span<const TriangleRange> ranges, const IShader* shader, const ShaderUniforms& uniforms,
+			const RasterTarget<Format, Function>& target);
+
+		template<DepthFormat Format, DepthFunction Function>
 		static void RasterizeTriangle(
 			const Varyings& v0, const Varyings& v1, const Varyings& v2,
 			const IShader* shader, const ShaderUniforms& uniforms,
-			int width, int height,
-			Texture2D_RFloat& depthBuffer, Texture2D_RGBA& colorBuffer
+			const RasterTarget<Format, Function>& target
 			);
 
 		FrameUniforms m_FrameUniforms;
+		DrawList m_DrawList;
+		std::string m_CapturePath;
+
+		bool m_MeshletCulling = true;
+		bool m_OcclusionCulling = false;
+		float m_LodErrorThreshold = 1.0f;
+		bool m_Instancing = true;
+		HiZBuffer m_HiZBuffer;
+		// Scratch for DrawMesh()
+		std::vector<ObjectUniforms> m_InstanceUniforms;
+		std::vector<VisibleInstance> m_VisibleInstances;
+		std::vector<TriangleRange> m_VisibleRanges;
+		std::vector<TriangleRange> m_MeshletRanges;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include "SDL3/SDL_timer.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#define CPURDR_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define CPURDR_HAS_RDTSC 1
+#endif
+
+namespace CPURDR
+{
+	enum class RenderStage : uint8_t
+	{
+		Vertex,         // vertex shader
+		Clip,           // near plane clipping, trivial rejection and perspective divide
+		Raster,         // triangle setup, coverage and depth test
+		Shade,          // attribute interpolation, fragment shader and color write
+		Clear,
+		PresentConvert, // framebuffer -> presentation format copy
+		Count
+	};
+
+	inline const char* GetRenderStageName(RenderStage stage)
+	{
+		switch (stage)
+		{
+		case RenderStage::Vertex: return "vertex";
+		case RenderStage::Clip: return "clip";
+		case RenderStage::Raster: return "raster";
+		case RenderStage::Shade: return "shade";
+		case RenderStage::Clear: return "clear";
+		case RenderStage::PresentConvert: return "present-convert";
+		case RenderStage::Count: break;
+		}
+		return "unknown";
+	}
+
+	// Time stamp counter on x86, the performance counter elsewhere
+	inline uint64_t ReadCycleCounter()
+	{
+#ifdef CPURDR_HAS_RDTSC
+		return __rdtsc();
+#else
+		return SDL_GetPerformanceCounter();
+#endif
+	}
+
+	inline const char* GetCycleCounterUnit()
+	{
+#ifdef CPURDR_HAS_RDTSC
+		return "cycles";
+#else
+		return "ticks";
+#endif
+	}
+
+	// Per-stage timings accumulated until Reset(), counters are in PipelineStatistics.
+	// Stage timing reads the performance counter per triangle and per shaded 2x2 quad,
+	// so frame times measured with it enabled are inflated, use them for the breakdown only
+	struct RenderStats
+	{
+		std::array<int64_t, (size_t)RenderStage::Count> stageTicks{};
+
+		static uint64_t Now() {return SDL_GetPerformanceCounter();}
+
+		void AddTicks(RenderStage stage, int64_t ticks) {stageTicks[(size_t)stage] += ticks;}
+
+		double GetStageMs(RenderStage stage) const
+		{
+			return (double)stageTicks[(size_t)stage] * 1000.0 / (double)SDL_GetPerformanceFrequency();
+		}
+
+		void Reset() {*this = RenderStats();}
+	};
+}
@@ -0,0 +1,182 @@
+#include "TemporalUpsampling.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "Upscale.h"
+#include "../core/Profiler.h"
+#include "../core/ThreadPool.h"
+
+namespace CPURDR
+{
+	static constexpr size_t PARALLEL_CHUNK_ROWS = 8;
+
+	// Bilinear fetch, coordinates in pixels with centers at integers
+	static uint32_t SampleHistory(const Texture2D_RGBA& history, float x, float y)
+	{
+		const int maxX = (int)history.GetWidth() - 1;
+		const int maxY = (int)history.GetHeight() - 1;
+		x = std::clamp(x, 0.0f, (float)maxX);
+		y = std::clamp(y, 0.0f, (float)maxY);
+
+		const int x0 = (int)x;
+		const int y0 = (int)y;
+		const int x1 = std::min(x0 + 1, maxX);
+		const int y1 = std::min(y0 + 1, maxY);
+		const uint32_t wx = (uint32_t)((x - (float)x0) * (float)LERP_WEIGHT_ONE + 0.5f);
+		const uint32_t wy = (uint32_t)((y - (float)y0) * (float)LERP_WEIGHT_ONE + 0.5f);
+
+		const uint32_t top = LerpPacked(history(x0, y0), history(x1, y0), wx);
+		const uint32_t bottom = LerpPacked(history(x0, y1), history(x1, y1), wx);
+		return LerpPacked(top, bottom, wy);
+	}
+
+	// Byte lane wise
+	static uint32_t ClampPacked(uint32_t c, uint32_t low, uint32_t high)
+	{
+		uint32_t result = 0;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			const uint32_t lane = std::clamp((c >> shift) & 0xFF, (low >> shift) & 0xFF, (high >> shift) & 0xFF);
+			result |= lane << shift;
+		}
+		return result;
+	}
+
+	// Min, max and average of the shaded 4-neighborhood, every direct neighbor of an unshaded pixel is shaded
+	struct Neighborhood
+	{
+		uint32_t low = 0xFFFFFFFF;
+		uint32_t high = 0;
+		uint32_t average = 0;
+	};
+
+	static Neighborhood GatherNeighborhood(const Texture2D_RGBA& color, int x, int y, int width, int height)
+	{
+		uint32_t samples[4];
+		int count = 0;
+		if (x > 0)          samples[count++] = color(x - 1, y);
+		if (x < width - 1)  samples[count++] = color(x + 1, y);
+		if (y > 0)          samples[count++] = color(x, y - 1);
+		if (y < height - 1) samples[count++] = color(x, y + 1);
+
+		Neighborhood neighborhood;
+		for (int shift = 0; shift < 32; shift += 8)
+		{
+			uint32_t low = 0xFF;
+			uint32_t high = 0;
+			uint32_t sum = 0;
+			for (int i = 0; i < count; ++i)
+			{
+				const uint32_t lane = (samples[i] >> shift) & 0xFF;
+				low = std::min(low, lane);
+				high = std::max(high, lane);
+				sum += lane;
+			}
+			neighborhood.low = (neighborhood.low & ~(0xFFu << shift)) | (low << shift);
+			neighborhood.high |= high << shift;
+			neighborhood.average |= (count > 0? (sum + count / 2) / count : 0) << shift;
+		}
+		return neighborhood;
+	}
+
+	template<DepthFormat Format>
+	TemporalResolveResult ResolveCheckerboard(const typename DepthFormatTraits<Format>::TextureType& depthBuffer,
+		float clearDepth, const glm::mat4& viewProjection, int parity, Texture2D_RGBA& color, TemporalHistory& history)
+	{
+		using DepthTraits = DepthFormatTraits<Format>;
+		PROFILE_SCOPE("ResolveCheckerboard");
+
+		const int width = (int)color.GetWidth();
+		const int height = (int)color.GetHeight();
+		const auto clearEncoded = DepthTraits::Load(DepthTraits::Clear(clearDepth, 0));
+
+		const glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+		// Current NDC to previous clip space, up to the scale 1 / (current clip w)
+		const glm::mat4 reprojection = history.viewProjection * inverseViewProjection;
+		const glm::vec4 inverseW = glm::vec4(inverseViewProjection[0][3], inverseViewProjection[1][3],
+			inverseViewProjection[2][3], inverseViewProjection[3][3]);
+		const bool historyValid = history.valid;
+
+		std::atomic<uint64_t> reprojectedTotal = 0;
+		std::atomic<uint64_t> rejectedTotal = 0;
+		ThreadPool::GetInstance().ParallelFor(0, (size_t)height, PARALLEL_CHUNK_ROWS,
+			[&](size_t begin, size_t end)
+			{
+				uint64_t reprojected = 0;
+				uint64_t rejected = 0;
+				for (int y = (int)begin; y < (int)end; ++y)
+				{
+					const float ndcY = ((float)y + 0.5f) / (float)height * 2.0f - 1.0f;
+					for (int x = 0; x < width; ++x)
+					{
+						float& nextDepth = history.nextLinearDepth(x, y);
+						const auto texel = depthBuffer(x, y);
+						if (DepthTraits::Load(texel) == clearEncoded)
+						{
+							nextDepth = 0.0f;
+							continue;
+						}
+
+						const glm::vec4 ndc(((float)x + 0.5f) / (float)width * 2.0f - 1.0f, ndcY, DepthTraits::Decode(texel), 1.0f);
+						const float invClipW = glm::dot(inverseW, ndc);
+						const float linearDepth = invClipW > 0.0f? 1.0f / invClipW : 0.0f;
+						nextDepth = linearDepth;
+
+						if (((x + y) & 1) == parity) continue;
+
+						const Neighborhood neighborhood = GatherNeighborhood(color, x, y, width, height);
+						uint32_t resolved = neighborhood.average;
+						bool accepted = false;
+						if (historyValid && linearDepth > 0.0f)
+						{
+							const glm::vec4 previousClip = reprojection * ndc;
+							if (previousClip.w > 0.0f)
+							{
+								const float previousX = (previousClip.x / previousClip.w + 1.0f) * 0.5f * (float)width - 0.5f;
+								const float previousY = (previousClip.y / previousClip.w + 1.0f) * 0.5f * (float)height - 0.5f;
+								if (previousX >= -0.5f && previousX <= (float)width - 0.5f &&
+									previousY >= -0.5f && previousY <= (float)height - 0.5f)
+								{
+									const int nearestX = std::clamp((int)(previousX + 0.5f), 0, width - 1);
+									const int nearestY = std::clamp((int)(previousY + 0.5f), 0, height - 1);
+									const float historyDepth = history.linearDepth(nearestX, nearestY);
+									const float previousDepth = previousClip.w * linearDepth;
+									if (historyDepth > 0.0f &&
+										std::abs(historyDepth - previousDepth) <= DISOCCLUSION_DEPTH_TOLERANCE * previousDepth)
+									{
+										resolved = ClampPacked(SampleHistory(history.color, previousX, previousY),
+											neighborhood.low, neighborhood.high);
+										accepted = true;
+									}
+								}
+							}
+						}
+
+						color(x, y) = resolved;
+						reprojected += accepted;
+						rejected += !accepted;
+					}
+				}
+				reprojectedTotal += reprojected;
+				rejectedTotal += rejected;
+			});
+
+		std::memcpy(history.color.GetData(), color.GetData(), color.GetSize() * sizeof(uint32_t));
+		std::swap(history.linearDepth, history.nextLinearDepth);
+		history.viewProjection = viewProjection;
+		history.valid = true;
+
+		TemporalResolveResult result;
+		result.reprojected = reprojectedTotal;
+		result.rejected = rejectedTotal;
+		return result;
+	}
+
+	template TemporalResolveResult ResolveCheckerboard<DepthFormat::D32_Float>(const Texture2D_RFloat&,
+		float, const glm::mat4&, int, Texture2D_RGBA&, TemporalHistory&);
+	template TemporalResolveResult ResolveCheckerboard<DepthFormat::D24_UNorm_S8_UInt>(const Texture2D_D24S8&,
+		float, const glm::mat4&, int, Texture2D_RGBA&, TemporalHistory&);
+	template TemporalResolveResult ResolveCheckerboard<DepthFormat::D16_UNorm>(const Texture2D_D16&,
+		float, const glm::mat4&, int, Texture2D_RGBA&, TemporalHistory&);
+}
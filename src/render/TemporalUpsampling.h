@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+
+#include "glm.hpp"
+#include "DepthFormat.h"
+#include "../Texture2D.h"
+
+namespace CPURDR
+{
+	enum class TemporalMode : uint8_t
+	{
+		Off,
+		// Each pass shades the pixels of one checkerboard color, alternating, the others are reprojected
+		// from the previous frame
+		Checkerboard
+	};
+
+	inline const char* GetTemporalModeName(TemporalMode mode)
+	{
+		switch (mode)
+		{
+		case TemporalMode::Off: return "Off";
+		case TemporalMode::Checkerboard: return "Checkerboard";
+		}
+		return "Unknown";
+	}
+
+	// The previous resolved frame, same size and color format as the framebuffer
+	struct TemporalHistory
+	{
+		Texture2D_RGBA color;
+		// View space depth, 0 where nothing was drawn
+		Texture2D_RFloat linearDepth;
+		Texture2D_RFloat nextLinearDepth;
+		glm::mat4 viewProjection = glm::mat4(1.0f);
+		bool valid = false;
+
+		TemporalHistory(int width, int height):
+			color(width, height, 0u), linearDepth(width, height, 0.0f), nextLinearDepth(width, height, 0.0f) {}
+	};
+
+	struct TemporalResolveResult
+	{
+		uint64_t reprojected = 0;
+		// Off screen last frame, or disoccluded, filled from the shaded neighbors instead
+		uint64_t rejected = 0;
+	};
+
+	// A history sample is rejected when its view depth differs from the reprojected one by more than this share
+	constexpr float DISOCCLUSION_DEPTH_TOLERANCE = 0.05f;
+
+	// Fills the pixels with (x + y) & 1 != parity that were drawn into. Each is reprojected into the history
+	// and clamped to its four shaded neighbors, or set to their average when the history can't be used.
+	// Then stores this frame as the new history
+	template<DepthFormat Format>
+	TemporalResolveResult ResolveCheckerboard(const typename DepthFormatTraits<Format>::TextureType& depthBuffer,
+		float clearDepth, const glm::mat4& viewProjection, int parity, Texture2D_RGBA& color, TemporalHistory& history);
+}
@@ -0,0 +1,76 @@
+#include "Upscale.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../core/ThreadPool.h"
+
+namespace CPURDR
+{
+	// Rows per job, the work per row is small
+	static constexpr size_t PARALLEL_CHUNK_ROWS = 16;
+
+	struct SampleTap
+	{
+		uint32_t i0 = 0;
+		uint32_t i1 = 0;
+		uint32_t weight = 0; // of i1
+	};
+
+	static void BuildTaps(size_t srcSize, size_t dstSize, std::vector<SampleTap>& taps)
+	{
+		taps.resize(dstSize);
+		const float step = (float)srcSize / (float)dstSize;
+		const float maxCoord = (float)(srcSize - 1);
+		for (size_t i = 0; i < dstSize; ++i)
+		{
+			const float coord = std::clamp(((float)i + 0.5f) * step - 0.5f, 0.0f, maxCoord);
+			const uint32_t i0 = (uint32_t)coord;
+			taps[i].i0 = i0;
+			taps[i].i1 = std::min(i0 + 1, (uint32_t)(srcSize - 1));
+			taps[i].weight = (uint32_t)((coord - (float)i0) * (float)LERP_WEIGHT_ONE + 0.5f);
+		}
+	}
+
+	void UpscaleBilinear(const Texture2D_RGBA& src, Texture2D_RGBA& dst)
+	{
+		const size_t srcWidth = src.GetWidth();
+		const size_t srcHeight = src.GetHeight();
+		const size_t dstWidth = dst.GetWidth();
+		const size_t dstHeight = dst.GetHeight();
+		if (srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0) return;
+
+		if (srcWidth == dstWidth && srcHeight == dstHeight)
+		{
+			std::memcpy(dst.GetData(), src.GetData(), src.GetSize() * sizeof(uint32_t));
+			return;
+		}
+
+		std::vector<SampleTap> columns;
+		std::vector<SampleTap> rows;
+		BuildTaps(srcWidth, dstWidth, columns);
+		BuildTaps(srcHeight, dstHeight, rows);
+
+		const uint32_t* srcData = src.GetData();
+		uint32_t* dstData = dst.GetData();
+		ThreadPool::GetInstance().ParallelFor(0, dstHeight, PARALLEL_CHUNK_ROWS,
+			[&](size_t begin, size_t end)
+			{
+				for (size_t y = begin; y < end; ++y)
+				{
+					const SampleTap& row = rows[y];
+					const uint32_t* row0 = srcData + row.i0 * srcWidth;
+					const uint32_t* row1 = srcData + row.i1 * srcWidth;
+					uint32_t* out = dstData + y * dstWidth;
+					for (size_t x = 0; x < dstWidth; ++x)
+					{
+						const SampleTap& column = columns[x];
+						const uint32_t top = LerpPacked(row0[column.i0], row0[column.i1], column.weight);
+						const uint32_t bottom = LerpPacked(row1[column.i0], row1[column.i1], column.weight);
+						out[x] = LerpPacked(top, bottom, row.weight);
+					}
+				}
+			});
+	}
+}
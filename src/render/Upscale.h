@@ -0,0 +1,22 @@
+#pragma once
+#include "../Texture2D.h"
+
+namespace CPURDR
+{
+	// Weights are 8-bit fixed point, 256 is all of b
+	constexpr uint32_t LERP_WEIGHT_ONE = 256;
+
+	// Interpolates the four byte lanes of two packed pixels at once, two lanes per 16-bit half
+	inline uint32_t LerpPacked(uint32_t a, uint32_t b, uint32_t weight)
+	{
+		const uint32_t inverse = LERP_WEIGHT_ONE - weight;
+		const uint32_t evenLanes = (((a & 0x00FF00FF) * inverse + (b & 0x00FF00FF) * weight) >> 8) & 0x00FF00FF;
+		const uint32_t oddLanes = (((a >> 8) & 0x00FF00FF) * inverse + ((b >> 8) & 0x00FF00FF) * weight) & 0xFF00FF00;
+		return evenLanes | oddLanes;
+	}
+
+	// Scales src to the size dst already has, bilinear with pixel centers aligned. Every byte lane is filtered
+	// the same way, so it works for any 8-bit-per-channel ColorFormat without converting.
+	// Rows are split across the ThreadPool
+	void UpscaleBilinear(const Texture2D_RGBA& src, Texture2D_RGBA& dst);
+}
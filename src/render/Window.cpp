@@ -91,7 +91,22 @@ namespace CPURDR
 
 	void Window::CreateContext()
 	{
-		m_Context = std::make_shared<Context>(m_Width >> 2, m_Height >> 2);
+		m_Context = std::make_shared<Context>(GetRenderWidth(), GetRenderHeight());
+	}
+
+	void Window::SetRenderScale(float scale)
+	{
+		scale = std::clamp(scale, MIN_RENDER_SCALE, MAX_RENDER_SCALE);
+		if (scale == m_RenderScale)
+		{
+			return;
+		}
+
+		m_RenderScale = scale;
+		if (m_Context)
+		{
+			m_Context->ResizeFramebuffer(GetRenderWidth(), GetRenderHeight());
+		}
 	}
 
 	void Window::Present()
@@ -136,7 +151,7 @@ namespace CPURDR
 
 		if (m_Context)
 		{
-			m_Context->ResizeFramebuffer(width >> 1, height >> 1);
+			m_Context->ResizeFramebuffer(GetRenderWidth(), GetRenderHeight());
 		}
 
 		if (m_ResizeCallback)
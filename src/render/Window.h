@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
@@ -38,6 +39,16 @@ namespace CPURDR
 		void CreateContext();
 		std::shared_ptr<Context> GetContext() const {return m_Context;}
 
+		// Framebuffer size relative to the window, the presented image is scaled back up to the window.
+		// Resizes the context, call outside a render pass
+		void SetRenderScale(float scale);
+		float GetRenderScale() const {return m_RenderScale;}
+		int GetRenderWidth() const {return GetScaledSize(m_Width);}
+		int GetRenderHeight() const {return GetScaledSize(m_Height);}
+
+		static constexpr float MIN_RENDER_SCALE = 0.1f;
+		static constexpr float MAX_RENDER_SCALE = 1.0f;
+
 		void Present();
 
 		// Callbacks for ImGui
@@ -56,6 +67,7 @@ namespace CPURDR
 		int m_Width, m_Height;
 		bool m_ShouldClose;
 		bool m_VSync;
+		float m_RenderScale = 0.5f;
 
 		std::shared_ptr<Context> m_Context;
 		ResizeCallback m_ResizeCallback;
@@ -63,6 +75,7 @@ namespace CPURDR
 		uint64_t m_LastPresentTime;
 		float m_RefreshRate;
 
+		int GetScaledSize(int size) const {return std::max(1, (int)((float)size * m_RenderScale + 0.5f));}
 		void UpdateSurface();
 		void WaitForVSync();
 	};
@@ -0,0 +1,568 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+#include "Log.h"
+#include "Primitives.h"
+#include "Scene.h"
+#include "core/HeadlessRenderer.h"
+#include "core/SceneDescription.h"
+#include "ecs/components/MeshFilter.h"
+#include "ecs/components/MeshRenderer.h"
+#include "ecs/components/Transform.h"
+#include "plog/Log.h"
+#include "render/ColorFormat.h"
+#include "render/MaterialManager.h"
+
+using namespace CPURDR;
+
+// Bump when the JSON layout changes, so tracking scripts can tell reports apart
+static constexpr int REPORT_VERSION = 2;
+
+struct BenchOptions
+{
+	std::vector<std::string> sceneFilter;
+	std::string modelDirectory = "resources/assets/models";
+	std::string outputPath = "bench.json";
+	int width = 1280;
+	int height = 720;
+	int frames = 30;
+	int warmupFrames = 3;
+	DepthFormat depthFormat = DepthFormat::D32_Float;
+	bool reversedZ = false;
+	CullMode cullMode = CullMode::None;
+	ColorFormat presentFormat = ColorFormat::ABGR8888;
+};
+
+// A canned scene, camera placement lives in description, build() populates the scene
+struct BenchScene
+{
+	std::string name;
+	SceneDescription description;
+	std::function<bool(Scene&, SceneDescription&)> build;
+};
+
+struct BenchResult
+{
+	std::string name;
+	uint64_t triangles = 0;
+	std::vector<double> frameMs;
+	// Counters of the last measured frame, every frame renders the same
+	PipelineStatistics statistics;
+	// From a separate instrumented pass, stage timing inflates frame time
+	RenderStats stats;
+	int statsFrames = 0;
+	double statsFrameMs = 0.0;
+};
+
+static void PrintUsage()
+{
+	std::cout <<
+		"Usage: cpurenderer_bench [options]\n"
+		"  --scene <name>        run only this scene, repeatable (see --list)\n"
+		"  --list                print the scene names and exit\n"
+		"  --models <dir>        directory of the model scenes (default resources/assets/models)\n"
+		"  --output <file>       JSON report (default bench.json)\n"
+		"  --width <px>          (default 1280)\n"
+		"  --height <px>         (default 720)\n"
+		"  --frames <n>          measured frames per scene (default 30)\n"
+		"  --warmup <n>          unmeasured frames per scene (default 3)\n"
+		"  --depth <d32|d24s8|d16>\n"
+		"  --reversed-z\n"
+		"  --cull <none|back|front>\n"
+		"  --present-format <rgba8888|abgr8888>  format the present-convert stage copies into (default abgr8888)\n";
+}
+
+static bool ParseOptions(int argc, char* argv[], BenchOptions& options, bool& listOnly)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto next = [&]() -> const char*
+		{
+			return i + 1 < argc? argv[++i] : nullptr;
+		};
+
+		const char* value = nullptr;
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+		else if (arg == "--list")                        listOnly = true;
+		else if (arg == "--scene" && (value = next()))   options.sceneFilter.emplace_back(value);
+		else if (arg == "--models" && (value = next()))  options.modelDirectory = value;
+		else if (arg == "--output" && (value = next()))  options.outputPath = value;
+		else if (arg == "--width" && (value = next()))   options.width = std::max(1, std::atoi(value));
+		else if (arg == "--height" && (value = next()))  options.height = std::max(1, std::atoi(value));
+		else if (arg == "--frames" && (value = next()))  options.frames = std::max(1, std::atoi(value));
+		else if (arg == "--warmup" && (value = next()))  options.warmupFrames = std::max(0, std::atoi(value));
+		else if (arg == "--reversed-z")                  options.reversedZ = true;
+		else if (arg == "--depth" && (value = next()))
+		{
+			if (std::strcmp(value, "d32") == 0)        options.depthFormat = DepthFormat::D32_Float;
+			else if (std::strcmp(value, "d24s8") == 0) options.depthFormat = DepthFormat::D24_UNorm_S8_UInt;
+			else if (std::strcmp(value, "d16") == 0)   options.depthFormat = DepthFormat::D16_UNorm;
+			else return false;
+		}
+		else if (arg == "--cull" && (value = next()))
+		{
+			if (std::strcmp(value, "none") == 0)       options.cullMode = CullMode::None;
+			else if (std::strcmp(value, "back") == 0)  options.cullMode = CullMode::Back;
+			else if (std::strcmp(value, "front") == 0) options.cullMode = CullMode::Front;
+			else return false;
+		}
+		else if (arg == "--present-format" && (value = next()))
+		{
+			if (std::strcmp(value, "rgba8888") == 0)      options.presentFormat = ColorFormat::RGBA8888;
+			else if (std::strcmp(value, "abgr8888") == 0) options.presentFormat = ColorFormat::ABGR8888;
+			else return false;
+		}
+		else
+		{
+			std::cerr << "Unknown or incomplete option: " << arg << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// ===============
+// Canned scenes
+// ===============
+static entt::entity AddMesh(Scene& scene, const std::string& name, Mesh mesh,
+	const glm::vec3& position, const glm::vec3& euler = glm::vec3(0.0f), const glm::vec3& scale = glm::vec3(1.0f))
+{
+	std::vector<Mesh> meshes;
+	meshes.push_back(std::move(mesh));
+	const entt::entity entity = scene.CreateMeshEntity(name, MeshFilter(std::move(meshes)));
+
+	auto& transform = scene.GetRegistry().get<Transform>(entity);
+	transform.position = position;
+	transform.SetRotationEuler(euler.x, euler.y, euler.z);
+	transform.scale = scale;
+	return entity;
+}
+
+static void AddLight(Scene& scene)
+{
+	const entt::entity light = scene.CreateDirectionalLightEntity("Directional Light");
+	scene.GetRegistry().get<Transform>(light).SetRotationEuler(-45.0f, 30.0f, 0.0f);
+}
+
+// Camera is placed to frame the union of every mesh's object bounds, transformed by its entity
+static bool FrameSceneBounds(Scene& scene, SceneDescription& description)
+{
+	glm::vec3 boundsMin(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+
+	auto view = scene.GetRegistry().view<Transform, MeshFilter>();
+	for (auto entity : view)
+	{
+		const glm::mat4 model = view.get<Transform>(entity).GetLocalModelMatrix();
+		for (const Mesh& mesh : view.get<MeshFilter>(entity).GetMeshes())
+		{
+			for (size_t i = 0; i < mesh.GetVertexCount(); ++i)
+			{
+				const glm::vec3 position = glm::vec3(model * glm::vec4(mesh.GetPosition(i), 1.0f));
+				boundsMin = glm::min(boundsMin, position);
+				boundsMax = glm::max(boundsMax, position);
+			}
+		}
+	}
+	if (boundsMin.x > boundsMax.x) return false;
+
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	const float radius = std::max(glm::length(boundsMax - boundsMin) * 0.5f, 1e-3f);
+	const float distance = radius / std::tan(glm::radians(description.cameraFOV) * 0.5f);
+
+	description.cameraTarget = center;
+	description.cameraPosition = center + glm::normalize(glm::vec3(0.5f, 0.4f, 1.0f)) * distance;
+	description.cameraNear = std::max(distance - radius, 1e-3f) * 0.5f;
+	description.cameraFar = (distance + radius) * 2.0f;
+	return true;
+}
+
+static std::vector<BenchScene> CreateBenchScenes(const BenchOptions& options)
+{
+	std::vector<BenchScene> scenes;
+
+	// Many small high-tessellation spheres, vertex and setup bound
+	{
+		BenchScene bench;
+		bench.name = "dense-spheres";
+		bench.description.cameraPosition = glm::vec3(0.0f, 0.0f, 11.0f);
+		bench.build = [](Scene& scene, SceneDescription&)
+		{
+			AddLight(scene);
+			const Mesh sphere = Primitives::Sphere(0.45f, 96, 48);
+			for (int y = 0; y < 8; ++y)
+			{
+				for (int x = 0; x < 12; ++x)
+				{
+					AddMesh(scene, "Sphere", sphere, glm::vec3(x - 5.5f, y - 3.5f, 0.0f));
+				}
+			}
+			return true;
+		};
+		scenes.push_back(std::move(bench));
+	}
+
+	// Lots of draws with few triangles each
+	{
+		BenchScene bench;
+		bench.name = "many-cubes";
+		bench.description.cameraPosition = glm::vec3(0.0f, 22.0f, 26.0f);
+		bench.build = [](Scene& scene, SceneDescription&)
+		{
+			AddLight(scene);
+			const Mesh cube = Primitives::Cube(0.6f);
+			for (int z = 0; z < 40; ++z)
+			{
+				for (int x = 0; x < 40; ++x)
+				{
+					AddMesh(scene, "Cube", cube, glm::vec3(x - 19.5f, 0.0f, z - 19.5f), glm::vec3(0.0f, (float)((x * 7 + z * 13) % 90), 0.0f));
+				}
+			}
+			return true;
+		};
+		scenes.push_back(std::move(bench));
+	}
+
+	// A ground plane running to the horizon, large triangles crossing the near plane
+	{
+		BenchScene bench;
+		bench.name = "large-plane";
+		bench.description.cameraPosition = glm::vec3(0.0f, 2.0f, 0.0f);
+		bench.description.cameraTarget = glm::vec3(0.0f, 1.0f, -10.0f);
+		bench.description.cameraFar = 500.0f;
+		bench.build = [](Scene& scene, SceneDescription&)
+		{
+			AddLight(scene);
+			AddMesh(scene, "Plane", Primitives::Plane(400.0f, 400.0f, 64, 64), glm::vec3(0.0f));
+			return true;
+		};
+		scenes.push_back(std::move(bench));
+	}
+
+	// Full screen quads drawn back to front, every layer passes the depth test and gets shaded.
+	// Views iterate the newest entity first, so the layers are created front to back
+	{
+		BenchScene bench;
+		bench.name = "overdraw-stack";
+		bench.description.cameraPosition = glm::vec3(0.0f, 0.0f, 2.0f);
+		bench.build = [](Scene& scene, SceneDescription&)
+		{
+			AddLight(scene);
+			constexpr int LAYER_COUNT = 16;
+			for (int layer = 0; layer < LAYER_COUNT; ++layer)
+			{
+				AddMesh(scene, "Layer", Primitives::Quad(8.0f, 8.0f), glm::vec3(0.0f, 0.0f, -(float)(layer + 1) * 0.1f),
+					glm::vec3(90.0f, 0.0f, 0.0f));
+			}
+			return true;
+		};
+		scenes.push_back(std::move(bench));
+	}
+
+	// Same overdraw stack with the PBR material, shading bound
+	{
+		BenchScene bench;
+		bench.name = "overdraw-stack-pbr";
+		bench.description.cameraPosition = glm::vec3(0.0f, 0.0f, 2.0f);
+		bench.build = [](Scene& scene, SceneDescription&)
+		{
+			AddLight(scene);
+			const MaterialHandle pbrMaterial = MaterialManager::GetInstance().GetDefaultPBRMaterial();
+			constexpr int LAYER_COUNT = 16;
+			for (int layer = 0; layer < LAYER_COUNT; ++layer)
+			{
+				const entt::entity entity = AddMesh(scene, "Layer", Primitives::Quad(8.0f, 8.0f),
+					glm::vec3(0.0f, 0.0f, -(float)(layer + 1) * 0.1f), glm::vec3(90.0f, 0.0f, 0.0f));
+				scene.GetRegistry().get<MeshRenderer>(entity).materialId = pbrMaterial;
+			}
+			return true;
+		};
+		scenes.push_back(std::move(bench));
+	}
+
+	// Every model shipped with the editor, framed by its bounds
+	std::error_code error;
+	std::vector<std::filesystem::path> modelPaths;
+	for (const auto& entry : std::filesystem::directory_iterator(options.modelDirectory, error))
+	{
+		if (entry.is_regular_file()) modelPaths.push_back(entry.path());
+	}
+	std::sort(modelPaths.begin(), modelPaths.end());
+	if (error)
+	{
+		PLOG_WARNING << "Model scenes skipped, can't read " << options.modelDirectory << ": " << error.message();
+	}
+
+	for (const auto& modelPath : modelPaths)
+	{
+		BenchScene bench;
+		bench.name = "model-" + modelPath.stem().string();
+		bench.build = [path = modelPath.string()](Scene& scene, SceneDescription& description)
+		{
+			AddLight(scene);
+			const entt::entity entity = scene.CreateMeshEntity(path, path);
+			return scene.GetRegistry().get<MeshFilter>(entity).asset && FrameSceneBounds(scene, description);
+		};
+		scenes.push_back(std::move(bench));
+	}
+
+	return scenes;
+}
+
+// ===============
+// Measurement
+// ===============
+static uint64_t CountTriangles(Scene& scene)
+{
+	uint64_t triangles = 0;
+	auto view = scene.GetRegistry().view<MeshFilter>();
+	for (auto entity : view)
+	{
+		triangles += view.get<MeshFilter>(entity).GetTotalTriangleCount();
+	}
+	return triangles;
+}
+
+// Renders one frame and copies it into the presentation format, like App does before an upload
+static double RenderBenchFrame(HeadlessRenderer& renderer, Scene& scene, const Camera& camera,
+	ColorFormat presentFormat, std::vector<uint32_t>& presentPixels)
+{
+	Context* context = renderer.GetContext();
+	const uint64_t frequency = SDL_GetPerformanceFrequency();
+	const uint64_t start = SDL_GetPerformanceCounter();
+
+	renderer.RenderFrame(scene, camera);
+
+	const uint64_t convertStart = SDL_GetPerformanceCounter();
+	const Texture2D_RGBA* colorBuffer = context->GetColorBuffer();
+	ConvertPixels(colorBuffer->GetData(), context->GetColorFormat(), presentPixels.data(), presentFormat, presentPixels.size());
+	const uint64_t end = SDL_GetPerformanceCounter();
+
+	if (RenderStats* stats = context->GetStats())
+	{
+		stats->AddTicks(RenderStage::PresentConvert, (int64_t)(end - convertStart));
+	}
+	return (double)(end - start) * 1000.0 / (double)frequency;
+}
+
+static bool RunBenchScene(const BenchScene& bench, const BenchOptions& options, BenchResult& result)
+{
+	Scene scene(bench.name);
+	SceneDescription description = bench.description;
+	description.width = options.width;
+	description.height = options.height;
+	description.reversedZ = options.reversedZ;
+	if (!bench.build(scene, description))
+	{
+		PLOG_ERROR << "Failed to build bench scene " << bench.name;
+		return false;
+	}
+
+	HeadlessRenderer renderer(description.width, description.height, options.depthFormat);
+	renderer.SetClearColor(description.clearColor);
+	renderer.SetReversedZ(description.reversedZ);
+	Context* context = renderer.GetContext();
+	context->SetCullMode(options.cullMode);
+
+	Camera camera;
+	description.ApplyToCamera(camera);
+
+	std::vector<uint32_t> presentPixels((size_t)description.width * description.height);
+
+	result.name = bench.name;
+	result.triangles = CountTriangles(scene);
+
+	for (int frame = 0; frame < options.warmupFrames; ++frame)
+	{
+		RenderBenchFrame(renderer, scene, camera, options.presentFormat, presentPixels);
+	}
+
+	result.frameMs.reserve(options.frames);
+	for (int frame = 0; frame < options.frames; ++frame)
+	{
+		result.frameMs.push_back(RenderBenchFrame(renderer, scene, camera, options.presentFormat, presentPixels));
+	}
+	result.statistics = context->GetPipelineStatistics();
+
+	// Stage breakdown, a shorter pass since it only needs the proportions
+	context->SetStatsEnabled(true);
+	context->GetStats()->Reset();
+	result.statsFrames = std::max(1, options.frames / 3);
+	double statsTotalMs = 0.0;
+	for (int frame = 0; frame < result.statsFrames; ++frame)
+	{
+		statsTotalMs += RenderBenchFrame(renderer, scene, camera, options.presentFormat, presentPixels);
+	}
+	result.stats = *context->GetStats();
+	result.statsFrameMs = statsTotalMs / result.statsFrames;
+	context->SetStatsEnabled(false);
+	return true;
+}
+
+// ===============
+// Report
+// ===============
+static std::string EscapeJson(const std::string& text)
+{
+	std::string escaped;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\') escaped += '\\';
+		escaped += c;
+	}
+	return escaped;
+}
+
+static bool WriteReport(const std::string& path, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		PLOG_ERROR << "Failed to open " << path;
+		return false;
+	}
+
+	file << "{\n";
+	file << std::format("  \"version\": {},\n", REPORT_VERSION);
+	file << std::format("  \"width\": {},\n  \"height\": {},\n", options.width, options.height);
+	file << std::format("  \"frames\": {},\n  \"warmupFrames\": {},\n", options.frames, options.warmupFrames);
+	file << std::format("  \"depthFormat\": \"{}\",\n  \"reversedZ\": {},\n",
+		GetDepthFormatName(options.depthFormat), options.reversedZ? "true" : "false");
+	file << std::format("  \"presentFormat\": \"{}\",\n", GetColorFormatName(options.presentFormat));
+	file << "  \"scenes\": [\n";
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& result = results[i];
+
+		std::vector<double> sorted = result.frameMs;
+		std::sort(sorted.begin(), sorted.end());
+		double totalMs = 0.0;
+		for (double ms : sorted) totalMs += ms;
+		const double meanMs = totalMs / (double)sorted.size();
+		const double medianMs = sorted[sorted.size() / 2];
+		const double mtrisPerSecond = meanMs > 0.0? (double)result.triangles / (meanMs * 1000.0) : 0.0;
+
+		file << "    {\n";
+		file << std::format("      \"name\": \"{}\",\n", EscapeJson(result.name));
+		file << std::format("      \"triangles\": {},\n", result.triangles);
+		file << std::format("      \"msPerFrame\": {{\"mean\": {:.4f}, \"median\": {:.4f}, \"min\": {:.4f}, \"max\": {:.4f}}},\n",
+			meanMs, medianMs, sorted.front(), sorted.back());
+		file << std::format("      \"mtrisPerSecond\": {:.4f},\n", mtrisPerSecond);
+
+		// Stage times are per frame, measured with stage timing enabled
+		const double frames = (double)result.statsFrames;
+		file << "      \"stages\": {\n";
+		file << std::format("        \"instrumentedMsPerFrame\": {:.4f},\n", result.statsFrameMs);
+		for (size_t stage = 0; stage < (size_t)RenderStage::Count; ++stage)
+		{
+			file << std::format("        \"{}\": {:.4f},\n", GetRenderStageName((RenderStage)stage),
+				result.stats.GetStageMs((RenderStage)stage) / frames);
+		}
+		file << std::format("        \"instrumentedFrames\": {}\n", result.statsFrames);
+		file << "      },\n";
+
+		const PipelineStatistics& statistics = result.statistics;
+		file << "      \"pipeline\": {\n";
+		file << std::format("        \"draws\": {},\n", statistics.draws);
+		file << std::format("        \"instances\": {},\n", statistics.instances);
+		file << std::format("        \"meshletsDrawn\": {},\n", statistics.meshletsDrawn);
+		file << std::format("        \"meshletsFrustumCulled\": {},\n", statistics.meshletsFrustumCulled);
+		file << std::format("        \"meshletsBackfaceCulled\": {},\n", statistics.meshletsBackfaceCulled);
+		file << std::format("        \"meshletsOcclusionCulled\": {},\n", statistics.meshletsOcclusionCulled);
+		file << std::format("        \"verticesShaded\": {},\n", statistics.verticesShaded);
+		file << std::format("        \"vertexCacheHits\": {},\n", statistics.vertexCacheHits);
+		file << std::format("        \"trianglesSubmitted\": {},\n", statistics.trianglesSubmitted);
+		file << std::format("        \"backfaceCulled\": {},\n", statistics.backfaceCulled);
+		file << std::format("        \"frustumRejected\": {},\n", statistics.frustumRejected);
+		file << std::format("        \"nearClipped\": {},\n", statistics.nearClipped);
+		file << std::format("        \"zeroAreaRejected\": {},\n", statistics.zeroAreaRejected);
+		file << std::format("        \"trianglesRasterized\": {},\n", statistics.trianglesRasterized);
+		file << std::format("        \"pixelsCovered\": {},\n", statistics.pixelsCovered);
+		file << std::format("        \"depthFailed\": {},\n", statistics.depthFailed);
+		file << std::format("        \"fragmentsShaded\": {},\n", statistics.fragmentsShaded);
+		file << std::format("        \"pixelsWritten\": {},\n", statistics.pixelsWritten);
+		file << std::format("        \"overdraw\": {:.4f},\n", statistics.GetOverdraw((uint64_t)options.width * options.height));
+		file << std::format("        \"cullEfficiency\": {:.4f}\n", statistics.GetCullEfficiency());
+		file << "      }\n";
+		file << (i + 1 < results.size()? "    },\n" : "    }\n");
+	}
+
+	file << "  ]\n}\n";
+	return file.good();
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	bool listOnly = false;
+	if (!ParseOptions(argc, argv, options, listOnly))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Log::Init();
+	HeadlessRenderer::InitializeRenderResources();
+
+	std::vector<BenchScene> scenes = CreateBenchScenes(options);
+	if (listOnly)
+	{
+		for (const BenchScene& bench : scenes)
+		{
+			std::cout << bench.name << "\n";
+		}
+		return 0;
+	}
+
+	std::vector<BenchResult> results;
+	for (const BenchScene& bench : scenes)
+	{
+		if (!options.sceneFilter.empty() &&
+			std::find(options.sceneFilter.begin(), options.sceneFilter.end(), bench.name) == options.sceneFilter.end())
+		{
+			continue;
+		}
+
+		BenchResult result;
+		if (!RunBenchScene(bench, options, result))
+		{
+			return 1;
+		}
+
+		double totalMs = 0.0;
+		for (double ms : result.frameMs) totalMs += ms;
+		const double meanMs = totalMs / (double)result.frameMs.size();
+		PLOG_INFO << std::format("{:<24} {:>9} tris {:>9.3f} ms/frame {:>9.3f} Mtris/s",
+			result.name, result.triangles, meanMs, (double)result.triangles / (meanMs * 1000.0));
+
+		results.push_back(std::move(result));
+	}
+
+	if (results.empty())
+	{
+		PLOG_ERROR << "No bench scene matched";
+		return 1;
+	}
+
+	if (!WriteReport(options.outputPath, options, results))
+	{
+		return 1;
+	}
+	PLOG_INFO << "Report written to " << options.outputPath;
+	return 0;
+}
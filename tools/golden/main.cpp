@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+#include "Log.h"
+#include "Scene.h"
+#include "core/HeadlessRenderer.h"
+#include "core/ImageCompare.h"
+#include "core/SceneDescription.h"
+#include "plog/Log.h"
+
+using namespace CPURDR;
+
+// Renders every <name>.scene of the golden directory and compares it against <name>.bmp next to it
+struct GoldenOptions
+{
+	std::string goldenDirectory = "resources/golden";
+	std::string outputDirectory = "golden_out";
+	std::vector<std::string> sceneFilter;
+	// Per pixel perceptual delta above which a pixel counts as different
+	float threshold = 0.1f;
+	// Share of different pixels a scene may have and still pass, in percent
+	double maxDifferentPercent = 0.1;
+	DepthFormat depthFormat = DepthFormat::D32_Float;
+	bool update = false;
+};
+
+static void PrintUsage()
+{
+	std::cout <<
+		"Usage: cpurenderer_golden [options]\n"
+		"  --dir <path>          golden directory with <name>.scene and <name>.bmp (default resources/golden)\n"
+		"  --scene <name>        only this scene, repeatable\n"
+		"  --output <dir>        <name>_actual.bmp and <name>_diff.bmp of failed scenes (default golden_out)\n"
+		"  --threshold <0-1>     perceptual delta above which a pixel is different (default 0.1)\n"
+		"  --max-diff <percent>  different pixels a scene may have (default 0.1)\n"
+		"  --depth <d32|d24s8|d16>  render with another depth format against the same references\n"
+		"  --update              overwrite the references with the current renders\n"
+		"Exits with 0 when every scene passes, 1 otherwise\n";
+}
+
+static bool ParseOptions(int argc, char* argv[], GoldenOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto next = [&]() -> const char*
+		{
+			return i + 1 < argc? argv[++i] : nullptr;
+		};
+
+		const char* value = nullptr;
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+		else if (arg == "--dir" && (value = next()))       options.goldenDirectory = value;
+		else if (arg == "--scene" && (value = next()))     options.sceneFilter.emplace_back(value);
+		else if (arg == "--output" && (value = next()))    options.outputDirectory = value;
+		else if (arg == "--threshold" && (value = next())) options.threshold = std::clamp((float)std::atof(value), 0.0f, 1.0f);
+		else if (arg == "--max-diff" && (value = next()))  options.maxDifferentPercent = std::max(0.0, std::atof(value));
+		else if (arg == "--update")                        options.update = true;
+		else if (arg == "--depth" && (value = next()))
+		{
+			if (std::strcmp(value, "d32") == 0)        options.depthFormat = DepthFormat::D32_Float;
+			else if (std::strcmp(value, "d24s8") == 0) options.depthFormat = DepthFormat::D24_UNorm_S8_UInt;
+			else if (std::strcmp(value, "d16") == 0)   options.depthFormat = DepthFormat::D16_UNorm;
+			else return false;
+		}
+		else
+		{
+			std::cerr << "Unknown or incomplete option: " << arg << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool RenderScene(const std::filesystem::path& scenePath, DepthFormat depthFormat, Texture2D_RGBA& image)
+{
+	Scene scene(scenePath.stem().string());
+	SceneDescription description;
+	if (!description.LoadFromFile(scenePath.string(), scene))
+	{
+		return false;
+	}
+
+	HeadlessRenderer renderer(description.width, description.height, depthFormat);
+	renderer.SetClearColor(description.clearColor);
+	renderer.SetReversedZ(description.reversedZ);
+
+	Camera camera;
+	description.ApplyToCamera(camera);
+	renderer.RenderFrame(scene, camera);
+	renderer.ReadColorBuffer(image);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	GoldenOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Log::Init();
+	HeadlessRenderer::InitializeRenderResources();
+
+	std::error_code error;
+	std::vector<std::filesystem::path> scenePaths;
+	for (const auto& entry : std::filesystem::directory_iterator(options.goldenDirectory, error))
+	{
+		const std::filesystem::path& path = entry.path();
+		if (!entry.is_regular_file() || path.extension() != ".scene") continue;
+		if (!options.sceneFilter.empty() &&
+			std::find(options.sceneFilter.begin(), options.sceneFilter.end(), path.stem().string()) == options.sceneFilter.end())
+		{
+			continue;
+		}
+		scenePaths.push_back(path);
+	}
+	if (error)
+	{
+		PLOG_ERROR << "Can't read " << options.goldenDirectory << ": " << error.message();
+		return 1;
+	}
+	if (scenePaths.empty())
+	{
+		PLOG_ERROR << "No scenes found in " << options.goldenDirectory;
+		return 1;
+	}
+	std::sort(scenePaths.begin(), scenePaths.end());
+
+	if (!options.update)
+	{
+		std::filesystem::create_directories(options.outputDirectory, error);
+	}
+
+	int failed = 0;
+	Texture2D_RGBA actual(0, 0);
+	Texture2D_RGBA expected(0, 0);
+	Texture2D_RGBA diffImage(0, 0);
+	for (const auto& scenePath : scenePaths)
+	{
+		const std::string name = scenePath.stem().string();
+		std::filesystem::path referencePath = scenePath;
+		referencePath.replace_extension(".bmp");
+
+		if (!RenderScene(scenePath, options.depthFormat, actual))
+		{
+			std::cout << std::format("FAIL  {:<24} scene failed to load\n", name);
+			failed++;
+			continue;
+		}
+
+		if (options.update)
+		{
+			if (!SaveImageBMP(referencePath.string(), actual))
+			{
+				failed++;
+				continue;
+			}
+			std::cout << std::format("UPDATED {:<22} {}\n", name, referencePath.string());
+			continue;
+		}
+
+		if (!std::filesystem::exists(referencePath) || !LoadImageBMP(referencePath.string(), expected))
+		{
+			std::cout << std::format("FAIL  {:<24} no reference image, run with --update to create it\n", name);
+			failed++;
+			continue;
+		}
+
+		const ImageDiff diff = CompareImages(actual, expected, options.threshold, &diffImage);
+		const double differentPercent = 100.0 * diff.GetDifferentRatio();
+		const bool passed = !diff.sizeMismatch && differentPercent <= options.maxDifferentPercent;
+
+		if (diff.sizeMismatch)
+		{
+			std::cout << std::format("FAIL  {:<24} rendered {}x{}, reference is {}x{}\n", name,
+				actual.GetWidth(), actual.GetHeight(), expected.GetWidth(), expected.GetHeight());
+		}
+		else
+		{
+			std::cout << std::format("{}  {:<24} {:.3f}% different, max delta {:.3f}, PSNR {:.2f} dB\n",
+				passed? "PASS" : "FAIL", name, differentPercent, diff.maxDelta, diff.psnr);
+		}
+
+		if (!passed)
+		{
+			failed++;
+			const std::filesystem::path output = options.outputDirectory;
+			SaveImageBMP((output / (name + "_actual.bmp")).string(), actual);
+			if (!diff.sizeMismatch)
+			{
+				SaveImageBMP((output / (name + "_diff.bmp")).string(), diffImage);
+			}
+		}
+	}
+
+	if (options.update)
+	{
+		return failed > 0? 1 : 0;
+	}
+
+	std::cout << std::format("{} of {} scenes passed\n", (int)scenePaths.size() - failed, scenePaths.size());
+	if (failed > 0)
+	{
+		std::cout << std::format("Renders and diffs of the failed scenes are in {}\n", options.outputDirectory);
+	}
+	return failed > 0? 1 : 0;
+}
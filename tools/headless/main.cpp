@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gtc/quaternion.hpp"
+#include "Camera.h"
+#include "Log.h"
+#include "MeshOptimizer.h"
+#include "MeshResidency.h"
+#include "MeshSimplifier.h"
+#include "Scene.h"
+#include "VertexQuantization.h"
+#include "core/HeadlessRenderer.h"
+#include "core/ImageCompare.h"
+#include "core/SceneDescription.h"
+#include "ecs/components/Transform.h"
+#include "plog/Log.h"
+#include "render/Upscale.h"
+
+using namespace CPURDR;
+
+struct HeadlessOptions
+{
+	std::string scenePath;
+	std::vector<std::string> meshPaths;
+	std::string outputPrefix = "frame";
+	std::string capturePath;
+	int width = 0;
+	int height = 0;
+	int frames = 1;
+	float orbitDegrees = 0.0f;
+	// Renders at this fraction of the resolution and upscales the written images
+	float renderScale = 1.0f;
+	DepthFormat depthFormat = DepthFormat::D32_Float;
+	bool reversedZ = false;
+	CullMode cullMode = CullMode::None;
+	DebugView debugView = DebugView::None;
+	TemporalMode temporalMode = TemporalMode::Off;
+	bool optimizeMeshes = false;
+	bool quantizeVertices = false;
+	bool buildMeshlets = false;
+	bool generateLods = false;
+	// Pixels, see RenderPipeline::SetLodErrorThreshold
+	float lodErrorThreshold = 1.0f;
+	bool instancing = true;
+	bool meshletCulling = true;
+	bool occlusionCulling = false;
+	bool writeImages = true;
+	// Models given with --mesh are streamed through MeshResidency
+	bool streamMeshes = false;
+	// Megabytes, negative keeps the MeshResidency default
+	int meshBudgetMB = -1;
+};
+
+struct MeshDataSummary
+{
+	size_t vertexBytes = 0;
+	size_t triangles = 0;
+	double cacheMisses = 0.0;
+
+	void Add(const Mesh& mesh)
+	{
+		vertexBytes += mesh.vertices.size_bytes() + mesh.quantizedVertices.size_bytes();
+		triangles += mesh.indices.size() / 3;
+		cacheMisses += AnalyzeVertexCache(mesh.indices, mesh.GetVertexCount()) * (double)(mesh.indices.size() / 3);
+	}
+
+	double GetACMR() const {return triangles > 0? cacheMisses / (double)triangles : 0.0;}
+};
+
+// Replaces every mesh asset by a processed copy, entities sharing an asset keep sharing it
+static void ProcessSceneMeshes(Scene& scene, const char* name, Mesh (*process)(const Mesh&))
+{
+	std::unordered_map<const MeshAsset*, MeshAssetHandle> processed;
+	MeshDataSummary before;
+	MeshDataSummary after;
+	for (auto [entity, meshFilter] : scene.GetRegistry().view<MeshFilter>().each())
+	{
+		// Streamed assets are processed as they are read, like an import
+		if (!meshFilter.asset || meshFilter.asset->stream) continue;
+
+		MeshAssetHandle& handle = processed[meshFilter.asset.get()];
+		if (!handle)
+		{
+			// Only the full detail meshes count towards the summary
+			std::vector<Mesh> meshes;
+			for (const Mesh& mesh : meshFilter.GetMeshes())
+			{
+				meshes.push_back(process(mesh));
+				before.Add(mesh);
+				after.Add(meshes.back());
+			}
+			std::vector<MeshLod> lods = meshFilter.asset->lods;
+			for (MeshLod& lod : lods)
+			{
+				for (Mesh& mesh : lod.meshes) mesh = process(mesh);
+			}
+			handle = CreateMeshAsset(std::move(meshes), meshFilter.asset->source, std::move(lods));
+		}
+		meshFilter.asset = handle;
+	}
+	PLOG_INFO << std::format("{}: vertex data {} KB -> {} KB, ACMR {:.3f} -> {:.3f}", name,
+		before.vertexBytes / 1024, after.vertexBytes / 1024, before.GetACMR(), after.GetACMR());
+}
+
+// Like an import with MeshImportSettings::generateLods, before any other processing
+static void GenerateSceneLods(Scene& scene)
+{
+	std::unordered_map<const MeshAsset*, MeshAssetHandle> processed;
+	for (auto [entity, meshFilter] : scene.GetRegistry().view<MeshFilter>().each())
+	{
+		if (!meshFilter.asset || meshFilter.asset->stream) continue;
+
+		MeshAssetHandle& handle = processed[meshFilter.asset.get()];
+		if (!handle)
+		{
+			std::vector<MeshLod> lods = GenerateLods(meshFilter.GetMeshes(), false);
+			std::string chain = std::to_string(meshFilter.GetTotalTriangleCount());
+			for (const MeshLod& lod : lods)
+			{
+				size_t triangles = 0;
+				for (const Mesh& mesh : lod.meshes) triangles += mesh.indices.size() / 3;
+				chain += std::format(" -> {} ({:.4f})", triangles, lod.error);
+			}
+			PLOG_INFO << std::format("LODs of {}: {} triangles", meshFilter.asset->source.empty()?
+				"<generated>" : meshFilter.asset->source, chain);
+			handle = CreateMeshAsset(meshFilter.GetMeshes(), meshFilter.asset->source, std::move(lods));
+		}
+		meshFilter.asset = handle;
+	}
+}
+
+static Mesh BuildMeshletsCopy(const Mesh& mesh)
+{
+	Mesh copy = mesh;
+	copy.meshlets = BuildMeshlets(copy);
+	return copy;
+}
+
+static void PrintUsage()
+{
+	std::cout <<
+		"Usage: cpurenderer_headless [options] [scene file]\n"
+		"  --scene <file>        scene description to render\n"
+		"  --mesh <path>         add a model at the origin, repeatable, used when no scene is given\n"
+		"  --width <px>          override the scene resolution\n"
+		"  --height <px>\n"
+		"  --frames <n>          number of frames to render (default 1)\n"
+		"  --orbit <degrees>     rotate the camera around its target by this much per frame\n"
+		"  --depth <d32|d24s8|d16>\n"
+		"  --reversed-z\n"
+		"  --cull <none|back|front>\n"
+		"  --render-scale <0.1-1>  render smaller and upscale the images to the full resolution\n"
+		"  --debug-view <overdraw|shading-cost>  write heatmaps instead of the lit image\n"
+		"  --temporal <off|checkerboard>  shade half the pixels per frame, use with --frames and --orbit\n"
+		"  --optimize-meshes     reorder triangles and vertices of every mesh like an optimized import\n"
+		"  --quantize-vertices   render every mesh from the 16-byte quantized vertex layout\n"
+		"  --meshlets            split every mesh into meshlets like an import, for meshlet culling\n"
+		"  --lods                generate simplified levels of detail for every mesh like an import\n"
+		"  --lod-error <px>      projected error allowed when picking a level of detail (default 1, 0 = full detail)\n"
+		"  --no-instancing       draw every entity on its own instead of batching identical ones\n"
+		"  --no-meshlet-culling  draw meshlets without culling them\n"
+		"  --occlusion-culling   also cull meshlets against a Hi-Z buffer\n"
+		"  --stream-meshes       page the levels of detail of --mesh models in and out, like stream in a scene\n"
+		"  --mesh-budget <MB>    memory streamed meshes may page in (default 256), reads a frame asks for arrive\n"
+		"                        before the next frame\n"
+		"  --output <prefix>     images are written as <prefix>_0000.bmp, ... (default frame)\n"
+		"  --no-output           render only, for timing\n"
+		"  --capture <file>      write the first frame as a capture for cpurenderer_replay\n";
+}
+
+static bool ParseOptions(int argc, char* argv[], HeadlessOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto next = [&]() -> const char*
+		{
+			return i + 1 < argc? argv[++i] : nullptr;
+		};
+
+		const char* value = nullptr;
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+		else if (arg == "--scene" && (value = next()))  options.scenePath = value;
+		else if (arg == "--mesh" && (value = next()))   options.meshPaths.emplace_back(value);
+		else if (arg == "--width" && (value = next()))  options.width = std::atoi(value);
+		else if (arg == "--height" && (value = next())) options.height = std::atoi(value);
+		else if (arg == "--frames" && (value = next())) options.frames = std::max(1, std::atoi(value));
+		else if (arg == "--orbit" && (value = next()))  options.orbitDegrees = (float)std::atof(value);
+		else if (arg == "--output" && (value = next())) options.outputPrefix = value;
+		else if (arg == "--no-output")                  options.writeImages = false;
+		else if (arg == "--capture" && (value = next())) options.capturePath = value;
+		else if (arg == "--reversed-z")                 options.reversedZ = true;
+		else if (arg == "--optimize-meshes")            options.optimizeMeshes = true;
+		else if (arg == "--quantize-vertices")          options.quantizeVertices = true;
+		else if (arg == "--meshlets")                   options.buildMeshlets = true;
+		else if (arg == "--lods")                       options.generateLods = true;
+		else if (arg == "--lod-error" && (value = next())) options.lodErrorThreshold = (float)std::atof(value);
+		else if (arg == "--no-instancing")              options.instancing = false;
+		else if (arg == "--no-meshlet-culling")         options.meshletCulling = false;
+		else if (arg == "--occlusion-culling")          options.occlusionCulling = true;
+		else if (arg == "--stream-meshes")              options.streamMeshes = true;
+		else if (arg == "--mesh-budget" && (value = next())) options.meshBudgetMB = std::max(0, std::atoi(value));
+		else if (arg == "--render-scale" && (value = next())) options.renderScale = std::clamp((float)std::atof(value), 0.1f, 1.0f);
+		else if (arg == "--debug-view" && (value = next()))
+		{
+			if (std::strcmp(value, "overdraw") == 0)          options.debugView = DebugView::Overdraw;
+			else if (std::strcmp(value, "shading-cost") == 0) options.debugView = DebugView::ShadingCost;
+			else return false;
+		}
+		else if (arg == "--temporal" && (value = next()))
+		{
+			if (std::strcmp(value, "off") == 0)               options.temporalMode = TemporalMode::Off;
+			else if (std::strcmp(value, "checkerboard") == 0) options.temporalMode = TemporalMode::Checkerboard;
+			else return false;
+		}
+		else if (arg == "--cull" && (value = next()))
+		{
+			if (std::strcmp(value, "none") == 0)       options.cullMode = CullMode::None;
+			else if (std::strcmp(value, "back") == 0)  options.cullMode = CullMode::Back;
+			else if (std::strcmp(value, "front") == 0) options.cullMode = CullMode::Front;
+			else return false;
+		}
+		else if (arg == "--depth" && (value = next()))
+		{
+			if (std::strcmp(value, "d32") == 0)        options.depthFormat = DepthFormat::D32_Float;
+			else if (std::strcmp(value, "d24s8") == 0) options.depthFormat = DepthFormat::D24_UNorm_S8_UInt;
+			else if (std::strcmp(value, "d16") == 0)   options.depthFormat = DepthFormat::D16_UNorm;
+			else return false;
+		}
+		else if (arg[0] != '-' && options.scenePath.empty())
+		{
+			options.scenePath = arg;
+		}
+		else
+		{
+			std::cerr << "Unknown or incomplete option: " << arg << "\n";
+			return false;
+		}
+	}
+
+	return !options.scenePath.empty() || !options.meshPaths.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	HeadlessOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Log::Init();
+	HeadlessRenderer::InitializeRenderResources();
+
+	MeshResidency& residency = MeshResidency::GetInstance();
+	if (options.meshBudgetMB >= 0)
+	{
+		residency.SetBudget((uint64_t)options.meshBudgetMB << 20);
+	}
+
+	Scene scene("Headless Scene");
+	SceneDescription description;
+	if (!options.scenePath.empty())
+	{
+		if (!description.LoadFromFile(options.scenePath, scene))
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		scene.CreateDirectionalLightEntity("Directional Light");
+		for (const std::string& meshPath : options.meshPaths)
+		{
+			const entt::entity entity = options.streamMeshes? scene.CreateStreamedMeshEntity(meshPath, meshPath) :
+				scene.CreateMeshEntity(meshPath, meshPath);
+			if (!scene.GetRegistry().get<MeshFilter>(entity).asset)
+			{
+				PLOG_ERROR << "Failed to load mesh " << meshPath;
+				return 1;
+			}
+		}
+	}
+
+	// Simplified, then optimized before quantizing, like MeshLoader imports
+	if (options.generateLods)
+	{
+		GenerateSceneLods(scene);
+	}
+	if (options.optimizeMeshes)
+	{
+		ProcessSceneMeshes(scene, "Optimized meshes", OptimizeMesh);
+	}
+	if (options.quantizeVertices)
+	{
+		ProcessSceneMeshes(scene, "Quantized vertices", QuantizeMesh);
+	}
+	if (options.buildMeshlets)
+	{
+		ProcessSceneMeshes(scene, "Meshlets", BuildMeshletsCopy);
+	}
+
+	if (options.width > 0) description.width = options.width;
+	if (options.height > 0) description.height = options.height;
+	description.reversedZ |= options.reversedZ;
+
+	const int renderWidth = std::max(1, (int)((float)description.width * options.renderScale + 0.5f));
+	const int renderHeight = std::max(1, (int)((float)description.height * options.renderScale + 0.5f));
+	HeadlessRenderer renderer(renderWidth, renderHeight, options.depthFormat);
+	renderer.SetClearColor(description.clearColor);
+	renderer.SetReversedZ(description.reversedZ);
+	renderer.GetContext()->SetDebugView(options.debugView);
+	renderer.GetContext()->SetTemporalMode(options.temporalMode);
+	renderer.GetContext()->SetCullMode(options.cullMode);
+	renderer.GetRenderPipeline()->SetMeshletCulling(options.meshletCulling);
+	renderer.GetRenderPipeline()->SetOcclusionCulling(options.occlusionCulling);
+	renderer.GetRenderPipeline()->SetLodErrorThreshold(options.lodErrorThreshold);
+	renderer.GetRenderPipeline()->SetInstancing(options.instancing);
+	if (!options.capturePath.empty())
+	{
+		renderer.GetRenderPipeline()->RequestCapture(options.capturePath);
+	}
+
+	Camera camera;
+	const uint64_t frequency = SDL_GetPerformanceFrequency();
+	double totalMs = 0.0;
+	Texture2D_RGBA rendered(0, 0);
+	Texture2D_RGBA upscaled(description.width, description.height);
+
+	for (int frame = 0; frame < options.frames; ++frame)
+	{
+		// Orbit around the target's Y axis
+		const glm::quat orbit = glm::angleAxis(glm::radians(options.orbitDegrees * frame), glm::vec3(0.0f, 1.0f, 0.0f));
+		SceneDescription frameDescription = description;
+		frameDescription.cameraPosition = description.cameraTarget + orbit * (description.cameraPosition - description.cameraTarget);
+		frameDescription.ApplyToCamera(camera);
+
+		residency.Update();
+		const uint64_t start = SDL_GetPerformanceCounter();
+		renderer.RenderFrame(scene, camera);
+		const double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)frequency;
+		totalMs += ms;
+		// Frames don't depend on read timing
+		residency.WaitForReads();
+
+		const PipelineStatistics& statistics = renderer.GetContext()->GetPipelineStatistics();
+		PLOG_INFO << std::format("Frame {} rendered in {:.3f} ms, {} draws, {} instances", frame, ms,
+			statistics.draws, statistics.instances);
+		const uint64_t meshletsCulled = statistics.meshletsFrustumCulled + statistics.meshletsBackfaceCulled +
+			statistics.meshletsOcclusionCulled;
+		if (statistics.meshletsDrawn + meshletsCulled > 0)
+		{
+			PLOG_INFO << std::format("Meshlets: {} drawn, {} frustum culled, {} backface culled, {} occlusion culled, "
+				"{} triangles submitted", statistics.meshletsDrawn, statistics.meshletsFrustumCulled,
+				statistics.meshletsBackfaceCulled, statistics.meshletsOcclusionCulled, statistics.trianglesSubmitted);
+		}
+		else if (options.generateLods)
+		{
+			PLOG_INFO << std::format("LODs: {} triangles submitted", statistics.trianglesSubmitted);
+		}
+		const MeshResidencyStatistics& streaming = residency.GetStatistics();
+		if (streaming.streams > 0)
+		{
+			PLOG_INFO << std::format("Streaming: {} levels resident, {} KB of {} KB budget, {} KB permanent, {} reads pending, "
+				"{} KB read, {} evictions", streaming.residentLevels, streaming.residentBytes / 1024, residency.GetBudget() / 1024,
+				streaming.permanentBytes / 1024, streaming.pendingReads, streaming.bytesRead / 1024, streaming.evictions);
+		}
+		if (options.temporalMode != TemporalMode::Off)
+		{
+			const TemporalResolveResult& resolve = renderer.GetContext()->GetTemporalResolveResult();
+			PLOG_INFO << std::format("Temporal resolve: {} reprojected, {} rejected", resolve.reprojected, resolve.rejected);
+		}
+		if (options.debugView == DebugView::ShadingCost)
+		{
+			PLOG_INFO << std::format("Shading cost heatmap range {} {}",
+				renderer.GetContext()->GetDebugViewRange(), GetCycleCounterUnit());
+		}
+
+		if (options.writeImages)
+		{
+			const std::string outputPath = std::format("{}_{:04}.bmp", options.outputPrefix, frame);
+			if (renderWidth != description.width || renderHeight != description.height)
+			{
+				renderer.ReadColorBuffer(rendered);
+				UpscaleBilinear(rendered, upscaled);
+				if (!SaveImageBMP(outputPath, upscaled))
+				{
+					return 1;
+				}
+			}
+			else if (!renderer.SaveColorBuffer(outputPath))
+			{
+				return 1;
+			}
+		}
+	}
+
+	PLOG_INFO << std::format("{} frames at {}x{}, {:.3f} ms/frame average",
+		options.frames, renderWidth, renderHeight, totalMs / options.frames);
+	residency.Shutdown();
+	return 0;
+}
@@ -0,0 +1,526 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Log.h"
+#include "Texture2D.h"
+#include "plog/Log.h"
+#include "render/ColorFormat.h"
+#include "render/RasterKernels.h"
+#include "render/RenderStats.h"
+
+using namespace CPURDR;
+
+// Bump when the JSON layout changes, so tracking scripts can tell reports apart
+static constexpr int REPORT_VERSION = 1;
+
+struct MicroBenchOptions
+{
+	std::vector<std::string> kernelFilter;
+	std::string outputPath;
+	// Pixel kernels run over a width x height image, triangle kernels over this many triangles
+	int width = 1280;
+	int height = 720;
+	int triangles = 100000;
+	int textureSize = 512;
+	int repeats = 7;
+};
+
+// One isolated kernel, run() processes items units of work on inputs prepared beforehand
+struct MicroKernel
+{
+	std::string name;
+	const char* unit;
+	size_t items = 0;
+	std::function<void()> run;
+};
+
+struct MicroResult
+{
+	std::string name;
+	const char* unit;
+	size_t items = 0;
+	double cyclesPerItem = 0.0;
+	double nsPerItem = 0.0;
+};
+
+// Results are folded in here so the optimizer can't drop the kernels
+static volatile uint64_t s_Sink = 0;
+
+static void PrintUsage()
+{
+	std::cout <<
+		"Usage: cpurenderer_microbench [options]\n"
+		"  --kernel <name>       run only this kernel, repeatable (see --list)\n"
+		"  --list                print the kernel names and exit\n"
+		"  --width <px>          image size of the per pixel kernels (default 1280)\n"
+		"  --height <px>         (default 720)\n"
+		"  --triangles <n>       triangles of the per triangle kernels (default 100000)\n"
+		"  --texture <px>        size of the sampled textures (default 512)\n"
+		"  --repeats <n>         timed runs per kernel, the fastest is reported (default 7)\n"
+		"  --output <file>       also write the results as JSON\n";
+}
+
+static bool ParseOptions(int argc, char* argv[], MicroBenchOptions& options, bool& listOnly)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto next = [&]() -> const char*
+		{
+			return i + 1 < argc? argv[++i] : nullptr;
+		};
+
+		const char* value = nullptr;
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+		else if (arg == "--list")                          listOnly = true;
+		else if (arg == "--kernel" && (value = next()))    options.kernelFilter.emplace_back(value);
+		else if (arg == "--width" && (value = next()))     options.width = std::max(1, std::atoi(value));
+		else if (arg == "--height" && (value = next()))    options.height = std::max(1, std::atoi(value));
+		else if (arg == "--triangles" && (value = next())) options.triangles = std::max(1, std::atoi(value));
+		else if (arg == "--texture" && (value = next()))   options.textureSize = std::max(2, std::atoi(value));
+		else if (arg == "--repeats" && (value = next()))   options.repeats = std::max(1, std::atoi(value));
+		else if (arg == "--output" && (value = next()))    options.outputPath = value;
+		else
+		{
+			std::cerr << "Unknown or incomplete option: " << arg << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+static std::string GetInstructionSets()
+{
+	std::string isa;
+#if defined(__AVX2__)
+	isa += "AVX2 ";
+#endif
+#if defined(__AVX__)
+	isa += "AVX ";
+#endif
+#if defined(__SSSE3__)
+	isa += "SSSE3 ";
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+	isa += "SSE2 ";
+#endif
+#if defined(__FMA__)
+	isa += "FMA ";
+#endif
+	if (isa.empty()) return "scalar";
+	isa.pop_back();
+	return isa;
+}
+
+// ===============
+// Synthetic inputs
+// ===============
+struct MicroInputs
+{
+	std::vector<glm::vec3> screenTriangles;  // 3 per triangle, inside the image
+	std::vector<Varyings> clipTriangles;     // 3 per triangle, only the first vertex in front of the near plane
+	std::vector<glm::vec3> barycentrics;     // already weighted by 1/w, reused cyclically
+	std::vector<glm::vec4> colors;           // reused cyclically
+	std::vector<glm::vec2> sampleCoords;     // texel space, reused cyclically
+	Varyings triangle[3];
+
+	std::vector<uint32_t> pixels;
+	std::vector<uint32_t> convertedPixels;
+	Texture2D_RGBA colorBuffer{0, 0};
+	Texture2D_RFloat depthBuffer{0, 0};
+	Texture2D_RFloat floatTexture{0, 0};
+	Texture2D_HDR hdrTexture{0, 0};
+};
+
+// Power of two so the cyclic tables index with a mask
+static constexpr size_t TABLE_SIZE = 1 << 16;
+
+static Varyings RandomVaryings(std::mt19937& rng, float minW, float maxW)
+{
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> w(minW, maxW);
+
+	Varyings v;
+	v.positionCS = glm::vec4(unit(rng), unit(rng), unit(rng), w(rng));
+	v.positionWS = glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f;
+	v.normalWS = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 2.0f));
+	v.uv = glm::vec2(unit(rng), unit(rng)) * 0.5f + 0.5f;
+	return v;
+}
+
+static void PrepareInputs(const MicroBenchOptions& options, MicroInputs& inputs)
+{
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const float width = (float)options.width;
+	const float height = (float)options.height;
+
+	// Small triangles like a dense mesh produces, a few pixels to a few hundred
+	inputs.screenTriangles.resize((size_t)options.triangles * 3);
+	for (size_t i = 0; i < inputs.screenTriangles.size(); i += 3)
+	{
+		const glm::vec3 center(unit(rng) * width, unit(rng) * height, unit(rng));
+		for (size_t k = 0; k < 3; ++k)
+		{
+			inputs.screenTriangles[i + k] = center + glm::vec3(unit(rng) * 32.0f - 16.0f, unit(rng) * 32.0f - 16.0f, 0.0f);
+		}
+	}
+
+	inputs.clipTriangles.resize((size_t)options.triangles * 3);
+	for (size_t i = 0; i < inputs.clipTriangles.size(); i += 3)
+	{
+		inputs.clipTriangles[i] = RandomVaryings(rng, 0.5f, 10.0f);
+		inputs.clipTriangles[i + 1] = RandomVaryings(rng, -10.0f, -0.5f);
+		inputs.clipTriangles[i + 2] = RandomVaryings(rng, -10.0f, -0.5f);
+	}
+
+	for (Varyings& v : inputs.triangle)
+	{
+		v = RandomVaryings(rng, 0.5f, 10.0f);
+	}
+
+	inputs.barycentrics.resize(TABLE_SIZE);
+	inputs.colors.resize(TABLE_SIZE);
+	inputs.sampleCoords.resize(TABLE_SIZE);
+	const float texelMax = (float)(options.textureSize - 1);
+	for (size_t i = 0; i < TABLE_SIZE; ++i)
+	{
+		glm::vec3 b(unit(rng), unit(rng), unit(rng));
+		b /= (b.x + b.y + b.z + 1e-6f);
+		inputs.barycentrics[i] = b * glm::vec3(
+			1.0f / inputs.triangle[0].positionCS.w,
+			1.0f / inputs.triangle[1].positionCS.w,
+			1.0f / inputs.triangle[2].positionCS.w);
+		inputs.colors[i] = glm::vec4(unit(rng), unit(rng), unit(rng), 1.0f) * 1.2f - 0.1f;
+		inputs.sampleCoords[i] = glm::vec2(unit(rng), unit(rng)) * texelMax;
+	}
+
+	const size_t pixelCount = (size_t)options.width * options.height;
+	inputs.pixels.resize(pixelCount);
+	for (uint32_t& pixel : inputs.pixels)
+	{
+		pixel = (uint32_t)rng();
+	}
+	inputs.convertedPixels.resize(pixelCount);
+	inputs.colorBuffer.Resize(options.width, options.height);
+	inputs.depthBuffer.Resize(options.width, options.height);
+
+	inputs.floatTexture.Resize(options.textureSize, options.textureSize);
+	inputs.hdrTexture.Resize(options.textureSize, options.textureSize);
+	for (size_t i = 0; i < inputs.floatTexture.GetSize(); ++i)
+	{
+		inputs.floatTexture.GetData()[i] = unit(rng);
+		inputs.hdrTexture.GetData()[i] = glm::vec4(unit(rng), unit(rng), unit(rng), 1.0f);
+	}
+}
+
+// ===============
+// Kernels
+// ===============
+static std::vector<MicroKernel> CreateKernels(const MicroBenchOptions& options, MicroInputs& inputs)
+{
+	const size_t triangleCount = (size_t)options.triangles;
+	const size_t pixelCount = (size_t)options.width * options.height;
+	std::vector<MicroKernel> kernels;
+
+	// Signed area, the three edge equations and their top-left flags, as RasterizeTriangle sets up
+	kernels.push_back({"edge-setup", "triangle", triangleCount, [&inputs, triangleCount]()
+	{
+		uint64_t sink = 0;
+		const glm::vec3* s = inputs.screenTriangles.data();
+		for (size_t i = 0; i < triangleCount; ++i, s += 3)
+		{
+			const float area = EdgeFunction(s[0], s[1], s[2]);
+			const EdgeEquation e0 = MakeEdgeEquation(s[1], s[2]);
+			const EdgeEquation e1 = MakeEdgeEquation(s[2], s[0]);
+			const EdgeEquation e2 = MakeEdgeEquation(s[0], s[1]);
+			sink += (area > 0.0f) + e0.topLeft + e1.topLeft + e2.topLeft + (uint64_t)(e0.C + e1.C + e2.C);
+		}
+		s_Sink = s_Sink + sink;
+	}});
+
+	// Incremental edge evaluation and the inside test over every pixel of a screen covering triangle
+	kernels.push_back({"edge-coverage", "pixel", pixelCount, [&options]()
+	{
+		const float width = (float)options.width;
+		const float height = (float)options.height;
+		const glm::vec3 s0(-1.0f, -1.0f, 0.0f);
+		const glm::vec3 s1(width * 2.0f, -1.0f, 0.0f);
+		const glm::vec3 s2(-1.0f, height * 2.0f, 0.0f);
+		const bool positiveArea = EdgeFunction(s0, s1, s2) > 0.0f;
+		const EdgeEquation e0 = MakeEdgeEquation(s1, s2);
+		const EdgeEquation e1 = MakeEdgeEquation(s2, s0);
+		const EdgeEquation e2 = MakeEdgeEquation(s0, s1);
+
+		uint64_t covered = 0;
+		for (int y = 0; y < options.height; ++y)
+		{
+			const float py = (float)y + 0.5f;
+			float e0Value = e0.Evaluate(0.5f, py);
+			float e1Value = e1.Evaluate(0.5f, py);
+			float e2Value = e2.Evaluate(0.5f, py);
+			for (int x = 0; x < options.width; ++x)
+			{
+				covered += IsInsideEdge(e0Value, e0.topLeft, positiveArea) &&
+					IsInsideEdge(e1Value, e1.topLeft, positiveArea) &&
+					IsInsideEdge(e2Value, e2.topLeft, positiveArea);
+				e0Value += e0.A;
+				e1Value += e1.A;
+				e2Value += e2.A;
+			}
+		}
+		s_Sink = s_Sink + covered;
+	}});
+
+	// Near plane clipping of a triangle with one vertex in front, two interpolated vertices
+	kernels.push_back({"clip-lerp", "triangle", triangleCount, [&inputs, triangleCount]()
+	{
+		float sink = 0.0f;
+		const Varyings* v = inputs.clipTriangles.data();
+		for (size_t i = 0; i < triangleCount; ++i, v += 3)
+		{
+			const Varyings a = ClipLerpVaryings(v[0], v[1], 0.001f);
+			const Varyings b = ClipLerpVaryings(v[0], v[2], 0.001f);
+			sink += a.positionCS.x + b.uv.y;
+		}
+		s_Sink = s_Sink + (uint64_t)sink;
+	}});
+
+	// Perspective correct varyings of one triangle at pixelCount barycentric points
+	kernels.push_back({"interpolate", "pixel", pixelCount, [&inputs, pixelCount]()
+	{
+		float sink = 0.0f;
+		const Varyings* t = inputs.triangle;
+		Varyings result;
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			const glm::vec3& w = inputs.barycentrics[i & (TABLE_SIZE - 1)];
+			InterpolateVaryings(t[0], t[1], t[2], w.x, w.y, w.z, 1.0f / (w.x + w.y + w.z), result);
+			sink += result.normalWS.z + result.uv.x;
+		}
+		s_Sink = s_Sink + (uint64_t)sink;
+	}});
+
+	for (ColorFormat format : {ColorFormat::RGBA8888, ColorFormat::ABGR8888})
+	{
+		std::string name = std::string("pack-") + GetColorFormatName(format);
+		std::transform(name.begin(), name.end(), name.begin(), [](char c) {return (char)std::tolower(c);});
+		kernels.push_back({name, "pixel", pixelCount, [&inputs, pixelCount, format]()
+		{
+			uint32_t* dst = inputs.pixels.data();
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				dst[i] = PackColor(inputs.colors[i & (TABLE_SIZE - 1)], format);
+			}
+			s_Sink = s_Sink + dst[pixelCount / 2];
+		}});
+	}
+
+	kernels.push_back({"clear-color", "pixel", pixelCount, [&inputs]()
+	{
+		inputs.colorBuffer.Clear(0x141414FF);
+		s_Sink = s_Sink + inputs.colorBuffer.GetData()[0];
+	}});
+
+	kernels.push_back({"clear-depth", "pixel", pixelCount, [&inputs]()
+	{
+		inputs.depthBuffer.Clear(1.0f);
+		s_Sink = s_Sink + (uint64_t)inputs.depthBuffer.GetData()[0];
+	}});
+
+	// Bilinear samples at random texel positions, pixelCount of them
+	kernels.push_back({"sample-float", "sample", pixelCount, [&inputs, pixelCount]()
+	{
+		float sink = 0.0f;
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			const glm::vec2& p = inputs.sampleCoords[i & (TABLE_SIZE - 1)];
+			sink += inputs.floatTexture.Sample(p.x, p.y);
+		}
+		s_Sink = s_Sink + (uint64_t)sink;
+	}});
+
+	kernels.push_back({"sample-hdr", "sample", pixelCount, [&inputs, pixelCount]()
+	{
+		float sink = 0.0f;
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			const glm::vec2& p = inputs.sampleCoords[i & (TABLE_SIZE - 1)];
+			sink += inputs.hdrTexture.Sample(p.x, p.y).g;
+		}
+		s_Sink = s_Sink + (uint64_t)sink;
+	}});
+
+	// RGBA8888 -> ABGR8888 as the editor's present path does it, split across the ThreadPool
+	kernels.push_back({"present-convert", "pixel", pixelCount, [&inputs, pixelCount]()
+	{
+		ConvertPixels(inputs.pixels.data(), ColorFormat::RGBA8888,
+			inputs.convertedPixels.data(), ColorFormat::ABGR8888, pixelCount);
+		s_Sink = s_Sink + inputs.convertedPixels[0];
+	}});
+
+	// Same kernel on the calling thread only, chunks below the parallel threshold never leave it
+	kernels.push_back({"present-convert-1t", "pixel", pixelCount, [&inputs, pixelCount]()
+	{
+		constexpr size_t CHUNK = 16 * 1024;
+		for (size_t begin = 0; begin < pixelCount; begin += CHUNK)
+		{
+			ConvertPixels(inputs.pixels.data() + begin, ColorFormat::RGBA8888,
+				inputs.convertedPixels.data() + begin, ColorFormat::ABGR8888, std::min(CHUNK, pixelCount - begin));
+		}
+		s_Sink = s_Sink + inputs.convertedPixels[0];
+	}});
+
+	// Plain per pixel loop, the baseline the SIMD path is measured against
+	kernels.push_back({"present-convert-scalar", "pixel", pixelCount, [&inputs, pixelCount]()
+	{
+		const uint32_t* src = inputs.pixels.data();
+		uint32_t* dst = inputs.convertedPixels.data();
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			dst[i] = SwapColorChannels(src[i]);
+		}
+		s_Sink = s_Sink + dst[0];
+	}});
+
+	return kernels;
+}
+
+// ===============
+// Measurement
+// ===============
+static MicroResult Measure(const MicroKernel& kernel, int repeats)
+{
+	// Warm the caches and the branch predictors
+	kernel.run();
+
+	uint64_t bestCycles = std::numeric_limits<uint64_t>::max();
+	uint64_t bestTicks = std::numeric_limits<uint64_t>::max();
+	for (int i = 0; i < repeats; ++i)
+	{
+		const uint64_t startTicks = SDL_GetPerformanceCounter();
+		const uint64_t startCycles = ReadCycleCounter();
+		kernel.run();
+		const uint64_t cycles = ReadCycleCounter() - startCycles;
+		const uint64_t ticks = SDL_GetPerformanceCounter() - startTicks;
+
+		bestCycles = std::min(bestCycles, cycles);
+		bestTicks = std::min(bestTicks, ticks);
+	}
+
+	MicroResult result;
+	result.name = kernel.name;
+	result.unit = kernel.unit;
+	result.items = kernel.items;
+	result.cyclesPerItem = (double)bestCycles / (double)kernel.items;
+	result.nsPerItem = (double)bestTicks * 1e9 / (double)SDL_GetPerformanceFrequency() / (double)kernel.items;
+	return result;
+}
+
+static bool WriteReport(const std::string& path, const MicroBenchOptions& options, const std::vector<MicroResult>& results)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		PLOG_ERROR << "Failed to open " << path;
+		return false;
+	}
+
+	file << "{\n";
+	file << std::format("  \"version\": {},\n", REPORT_VERSION);
+	file << std::format("  \"instructionSets\": \"{}\",\n", GetInstructionSets());
+	file << std::format("  \"cycleUnit\": \"{}\",\n", GetCycleCounterUnit());
+	file << std::format("  \"width\": {},\n  \"height\": {},\n  \"triangles\": {},\n  \"textureSize\": {},\n",
+		options.width, options.height, options.triangles, options.textureSize);
+	file << "  \"kernels\": [\n";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const MicroResult& result = results[i];
+		file << std::format("    {{\"name\": \"{}\", \"unit\": \"{}\", \"items\": {}, \"cyclesPerItem\": {:.3f}, \"nsPerItem\": {:.3f}}}{}\n",
+			result.name, result.unit, result.items, result.cyclesPerItem, result.nsPerItem, i + 1 < results.size()? "," : "");
+	}
+	file << "  ]\n}\n";
+
+	if (!file.good())
+	{
+		PLOG_ERROR << "Failed to write " << path;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	MicroBenchOptions options;
+	bool listOnly = false;
+	if (!ParseOptions(argc, argv, options, listOnly))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Log::Init();
+
+	MicroInputs inputs;
+	if (!listOnly)
+	{
+		PrepareInputs(options, inputs);
+	}
+	std::vector<MicroKernel> kernels = CreateKernels(options, inputs);
+
+	if (listOnly)
+	{
+		for (const MicroKernel& kernel : kernels)
+		{
+			std::cout << kernel.name << "\n";
+		}
+		return 0;
+	}
+
+	std::cout << std::format("Instruction sets: {}, {}x{} pixels, {} triangles\n",
+		GetInstructionSets(), options.width, options.height, options.triangles);
+	std::cout << std::format("{:<24}{:>10}{:>14}{:>12}\n", "kernel", "unit", GetCycleCounterUnit(), "ns");
+
+	std::vector<MicroResult> results;
+	for (const MicroKernel& kernel : kernels)
+	{
+		if (!options.kernelFilter.empty() &&
+			std::find(options.kernelFilter.begin(), options.kernelFilter.end(), kernel.name) == options.kernelFilter.end())
+		{
+			continue;
+		}
+
+		const MicroResult result = Measure(kernel, options.repeats);
+		std::cout << std::format("{:<24}{:>10}{:>14.2f}{:>12.3f}\n",
+			result.name, result.unit, result.cyclesPerItem, result.nsPerItem);
+		results.push_back(result);
+	}
+
+	if (results.empty())
+	{
+		PLOG_ERROR << "No kernel matched the filter, see --list";
+		return 1;
+	}
+
+	if (!options.outputPath.empty())
+	{
+		if (!WriteReport(options.outputPath, options, results))
+		{
+			return 1;
+		}
+		PLOG_INFO << "Wrote " << options.outputPath;
+	}
+	return 0;
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "Log.h"
+#include "core/HeadlessRenderer.h"
+#include "core/ImageCompare.h"
+#include "core/Profiler.h"
+#include "plog/Log.h"
+#include "render/FrameCapture.h"
+
+using namespace CPURDR;
+
+// Re-renders a frame written by RenderPipeline::RequestCapture(), the same draws every frame
+struct ReplayOptions
+{
+	std::string capturePath;
+	std::string outputPath;
+	std::string tracePath;
+	int frames = 30;
+	int warmupFrames = 3;
+};
+
+static void PrintUsage()
+{
+	std::cout <<
+		"Usage: cpurenderer_replay <capture> [options]\n"
+		"  --frames <n>          measured frames (default 30)\n"
+		"  --warmup <n>          frames rendered before measuring (default 3)\n"
+		"  --output <file.bmp>   write the last frame\n"
+		"  --trace <file.json>   Chrome trace of the measured frames, needs CPURDR_ENABLE_PROFILER\n";
+}
+
+static bool ParseOptions(int argc, char* argv[], ReplayOptions& options)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		auto next = [&]() -> const char*
+		{
+			return i + 1 < argc? argv[++i] : nullptr;
+		};
+
+		const char* value = nullptr;
+		if (arg == "--help" || arg == "-h")
+		{
+			return false;
+		}
+		else if (arg == "--frames" && (value = next())) options.frames = std::max(1, std::atoi(value));
+		else if (arg == "--warmup" && (value = next())) options.warmupFrames = std::max(0, std::atoi(value));
+		else if (arg == "--output" && (value = next())) options.outputPath = value;
+		else if (arg == "--trace" && (value = next()))  options.tracePath = value;
+		else if (arg[0] != '-' && options.capturePath.empty())
+		{
+			options.capturePath = arg;
+		}
+		else
+		{
+			std::cerr << "Unknown or incomplete option: " << arg << "\n";
+			return false;
+		}
+	}
+
+	return !options.capturePath.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	ReplayOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	Log::Init();
+	HeadlessRenderer::InitializeRenderResources();
+
+	FrameCapture capture;
+	if (!capture.Load(options.capturePath))
+	{
+		return 1;
+	}
+
+	DrawList drawList;
+	capture.BuildDrawList(drawList);
+
+	HeadlessRenderer renderer(capture.width, capture.height, capture.depthFormat);
+	Context* context = renderer.GetContext();
+	RenderPipeline* pipeline = renderer.GetRenderPipeline();
+	capture.ApplyToContext(*context);
+
+	uint64_t triangles = 0;
+	for (const DrawCommand& command : drawList.commands)
+	{
+		triangles += command.mesh->indices.size() / 3 * command.GetInstanceCount();
+	}
+	PLOG_INFO << std::format("Replaying {}: {}x{}, {} draws, {} meshes, {} triangles", options.capturePath,
+		capture.width, capture.height, drawList.commands.size(), capture.meshes.size(), triangles);
+
+	Profiler& profiler = Profiler::GetInstance();
+	profiler.SetThreadName("Main");
+	const bool tracing = !options.tracePath.empty();
+#ifndef CPURDR_ENABLE_PROFILER
+	if (tracing)
+	{
+		PLOG_WARNING << "Built without CPURDR_ENABLE_PROFILER, the trace will be empty";
+	}
+#endif
+
+	auto renderFrame = [&]()
+	{
+		context->BeginRenderPass(capture.clearValue);
+		pipeline->RenderDrawList(context, capture.frameUniforms, drawList);
+		context->EndRenderPass();
+	};
+
+	for (int frame = 0; frame < options.warmupFrames; ++frame)
+	{
+		renderFrame();
+	}
+
+	if (tracing)
+	{
+		profiler.SetEnabled(true);
+		profiler.StartCapture();
+	}
+
+	const uint64_t frequency = SDL_GetPerformanceFrequency();
+	std::vector<double> frameMs;
+	frameMs.reserve(options.frames);
+	for (int frame = 0; frame < options.frames; ++frame)
+	{
+		profiler.BeginFrame();
+		const uint64_t start = SDL_GetPerformanceCounter();
+		renderFrame();
+		frameMs.push_back((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)frequency);
+		profiler.EndFrame();
+	}
+
+	if (tracing)
+	{
+		profiler.StopCapture();
+		profiler.SetEnabled(false);
+		if (!profiler.ExportChromeTrace(options.tracePath))
+		{
+			return 1;
+		}
+	}
+
+	std::vector<double> sorted = frameMs;
+	std::sort(sorted.begin(), sorted.end());
+	const double meanMs = std::accumulate(sorted.begin(), sorted.end(), 0.0) / (double)sorted.size();
+	PLOG_INFO << std::format("{} frames: {:.3f} ms/frame mean, {:.3f} median, {:.3f} min, {:.3f} max",
+		options.frames, meanMs, sorted[sorted.size() / 2], sorted.front(), sorted.back());
+
+	const PipelineStatistics& statistics = context->GetPipelineStatistics();
+	PLOG_INFO << std::format("{} triangles submitted, {} rasterized, {} backface culled, {} frustum rejected",
+		statistics.trianglesSubmitted, statistics.trianglesRasterized, statistics.backfaceCulled, statistics.frustumRejected);
+	PLOG_INFO << std::format("{} meshlets drawn, {} frustum culled, {} backface culled, {} occlusion culled",
+		statistics.meshletsDrawn, statistics.meshletsFrustumCulled, statistics.meshletsBackfaceCulled,
+		statistics.meshletsOcclusionCulled);
+	PLOG_INFO << std::format("{} vertices shaded, {} vertex cache hits, ACMR {:.3f}",
+		statistics.verticesShaded, statistics.vertexCacheHits, statistics.GetACMR());
+	PLOG_INFO << std::format("{} fragments shaded, {} pixels written, overdraw {:.2f}",
+		statistics.fragmentsShaded, statistics.pixelsWritten,
+		statistics.GetOverdraw((uint64_t)capture.width * capture.height));
+
+	if (!options.outputPath.empty())
+	{
+		Texture2D_RGBA image(0, 0);
+		renderer.ReadColorBuffer(image);
+		if (!SaveImageBMP(options.outputPath, image))
+		{
+			return 1;
+		}
+		PLOG_INFO << "Wrote " << options.outputPath;
+	}
+	return 0;
+}